@@ -2,6 +2,7 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     MainApp \
+    sim \
     test
 
 MainApp.file = src/MainApp.pro
@@ -0,0 +1,410 @@
+#include "fanuc_controller_sim.h"
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+#include <QPointer>
+#include <QSettings>
+#include <QStringList>
+#include "log/loguru.hpp"
+
+using namespace simple_message;
+
+FanucControllerSim::FanucControllerSim(const QString &config_file, QObject *parent):
+    QObject(parent),
+    relay_server_(this),
+    state_server_(this),
+    publish_timer_(this)
+{
+    load_settings(config_file);
+
+    connect(&relay_server_, &QTcpServer::newConnection, this, &FanucControllerSim::on_relay_connection);
+    connect(&state_server_, &QTcpServer::newConnection, this, &FanucControllerSim::on_state_connection);
+    connect(&publish_timer_, &QTimer::timeout, this, &FanucControllerSim::on_publish_timer);
+
+    handlers_.add<ping_t, &FanucControllerSim::on_ping>();
+    handlers_.add<joint_traj_pt_t, &FanucControllerSim::on_joint_traj_pt>();
+    handlers_.add<xyzwpr_traj_pt_t, &FanucControllerSim::on_xyzwpr_traj_pt>();
+    handlers_.add<output_pulse_t, &FanucControllerSim::on_output_pulse>();
+}
+
+void FanucControllerSim::load_settings(const QString &config_file)
+{
+    QSettings settings(config_file, QSettings::IniFormat);
+
+    relay_port_ = static_cast<quint16>(settings.value("server_relay_port", relay_port_).toInt());
+    state_port_ = static_cast<quint16>(settings.value("server_state_port", state_port_).toInt());
+    bigendian_ = settings.value("bigendian", bigendian_).toBool();
+    prefix1_ = settings.value("prefix1", prefix1_).toInt();
+    prefix2_ = settings.value("prefix2", prefix2_).toInt();
+    ack_latency_ = std::max(0, settings.value("ack_latency", ack_latency_).toInt());
+    ack_jitter_ = std::max(0, settings.value("ack_jitter", ack_jitter_).toInt());
+    fail_rate_ = settings.value("fail_rate", fail_rate_).toDouble();
+    for(const QString &s : settings.value("fail_sequences", QString()).toString().split(","))
+        if(!s.trimmed().isEmpty())
+            fail_sequences_.insert(s.trimmed().toInt());
+    state_rate_ = std::max(0.1, settings.value("state_rate", state_rate_).toDouble());
+    status_rate_ = std::max(0.1, settings.value("status_rate", status_rate_).toDouble());
+    linear_speed_ = std::max(1e-3, settings.value("linear_speed", linear_speed_).toDouble());
+    angular_speed_ = std::max(1e-3, settings.value("angular_speed", angular_speed_).toDouble());
+    joint_speed_ = std::max(1e-3, settings.value("joint_speed", joint_speed_).toDouble());
+    queue_size_ = std::max(0, settings.value("queue_size", queue_size_).toInt());
+    relay_ping_ = settings.value("relay_ping", relay_ping_).toBool();
+    state_ping_ = settings.value("state_ping", state_ping_).toBool();
+    random_.seed(settings.value("seed", 1).toUInt());
+
+    LOG_F(INFO, "Relay port %d, state port %d, bigendian %d", relay_port_, state_port_, bigendian_);
+    LOG_F(INFO, "Ack latency %d+%d ms, fail rate %f, %zu failing sequences",
+          ack_latency_, ack_jitter_, fail_rate_, fail_sequences_.size());
+    LOG_F(INFO, "State %f Hz, status %f Hz, speed %f mm/s %f deg/s, joint %f deg/s, queue %d",
+          state_rate_, status_rate_, linear_speed_, angular_speed_, joint_speed_, queue_size_);
+}
+
+bool FanucControllerSim::start()
+{
+    if(!relay_server_.listen(QHostAddress::Any, relay_port_))
+    {
+        LOG_F(ERROR, "Relay port %d: %s", relay_port_, relay_server_.errorString().toLocal8Bit().data());
+        return false;
+    }
+    if(!state_server_.listen(QHostAddress::Any, state_port_))
+    {
+        LOG_F(ERROR, "State port %d: %s", state_port_, state_server_.errorString().toLocal8Bit().data());
+        return false;
+    }
+
+    // messages due are counted on every tick, so rates above 1 kHz still work
+    double max_rate = std::max(state_rate_, status_rate_);
+    publish_timer_.setTimerType(Qt::PreciseTimer);
+    publish_timer_.start(std::max(1, std::min(100, static_cast<int>(1000 / max_rate))));
+    clock_.start();
+    return true;
+}
+
+void FanucControllerSim::on_relay_connection()
+{
+    while(relay_server_.hasPendingConnections())
+    {
+        QTcpSocket *client = relay_server_.nextPendingConnection();
+        LOG_F(INFO, "Relay client connected");
+        client->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        relay_clients_[client].reset(new SimpleMessageFramer(bigendian_));
+        connect(client, &QIODevice::readyRead, this, [this, client](){ read_relay(client); });
+        connect(client, &QAbstractSocket::disconnected, this, [this, client](){
+            LOG_F(INFO, "Relay client disconnected");
+            relay_clients_.erase(client);
+            client->deleteLater();
+        });
+    }
+}
+
+void FanucControllerSim::on_state_connection()
+{
+    while(state_server_.hasPendingConnections())
+    {
+        QTcpSocket *client = state_server_.nextPendingConnection();
+        LOG_F(INFO, "State client connected");
+        client->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        state_clients_[client].reset(new SimpleMessageFramer(bigendian_));
+        connect(client, &QIODevice::readyRead, this, [this, client](){ read_state(client); });
+        connect(client, &QAbstractSocket::disconnected, this, [this, client](){
+            LOG_F(INFO, "State client disconnected");
+            state_clients_.erase(client);
+            client->deleteLater();
+        });
+    }
+}
+
+void FanucControllerSim::read_relay(QTcpSocket *client)
+{
+    auto it = relay_clients_.find(client);
+    if(it == relay_clients_.end())
+        return;
+    SimpleMessageFramer &framer = *it->second;
+
+    while(client->bytesAvailable() > 0)
+    {
+        qint64 size = client->read(framer.write_ptr(), static_cast<qint64>(framer.write_size()));
+        if(size <= 0)
+            break;
+        framer.commit(static_cast<size_t>(size));
+
+        size_t packet_size = 0;
+        while(const char *data = framer.next_frame(packet_size))
+        {
+            packet_view packet(data, packet_size, bigendian_);
+            if(!packet.valid() || packet.header().comm_type != COMM_TYPE_SERVICE_REQUEST)
+            {
+                LOG_F(WARNING, "Unexpected packet msg=%d comm=%d", packet.header().msg_type, packet.header().comm_type);
+                continue;
+            }
+
+            current_client_ = client;
+            current_packet_ = &packet;
+            if(handlers_.dispatch(*this, packet) != handler_table<FanucControllerSim>::HANDLED)
+            {
+                LOG_F(WARNING, "Unsupported request msg=%d", packet.header().msg_type);
+                reply(REPLY_CODE_FAILURE);
+            }
+            current_client_ = nullptr;
+            current_packet_ = nullptr;
+        }
+    }
+}
+
+// the state port takes no requests but PING, answered right away like the
+// state task of the controller would
+void FanucControllerSim::read_state(QTcpSocket *client)
+{
+    auto it = state_clients_.find(client);
+    if(it == state_clients_.end())
+        return;
+    SimpleMessageFramer &framer = *it->second;
+
+    while(client->bytesAvailable() > 0)
+    {
+        qint64 size = client->read(framer.write_ptr(), static_cast<qint64>(framer.write_size()));
+        if(size <= 0)
+            break;
+        framer.commit(static_cast<size_t>(size));
+
+        size_t packet_size = 0;
+        while(const char *data = framer.next_frame(packet_size))
+        {
+            packet_view packet(data, packet_size, bigendian_);
+            if(!state_ping_ || !packet.valid() || packet.header().msg_type != MSG_TYPE_PING ||
+               packet.header().comm_type != COMM_TYPE_SERVICE_REQUEST)
+                continue;
+
+            char buffer[SimpleMessageFramer::MAX_FRAME_SIZE];
+            size_t reply_size = encode_reply(packet, REPLY_CODE_SUCCESS, buffer, sizeof(buffer));
+            if(reply_size != 0)
+                client->write(buffer, static_cast<qint64>(reply_size));
+        }
+    }
+}
+
+void FanucControllerSim::on_ping(const ping_t &)
+{
+    if(relay_ping_)
+        reply(REPLY_CODE_SUCCESS);
+}
+
+// the pulse itself is not simulated, only queued after its point
+void FanucControllerSim::on_output_pulse(const output_pulse_t &msg)
+{
+    LOG_F(INFO, "Output pulse DO[%d] %.3f s at %d", msg.index, msg.duration, msg.sequence);
+    reply(REPLY_CODE_SUCCESS);
+}
+
+void FanucControllerSim::on_joint_traj_pt(const joint_traj_pt_t &msg)
+{
+    values_t values;
+    for(int i=0; i<6; i++)
+        values[i] = msg.joint_data[i] * 180/M_PI;
+    on_request(true, values, msg.sequence, config_);
+}
+
+void FanucControllerSim::on_xyzwpr_traj_pt(const xyzwpr_traj_pt_t &msg)
+{
+    values_t values;
+    for(int i=0; i<6; i++)
+        values[i] = msg.xyz_data.xyzwpr[i];
+    on_request(false, values, msg.sequence, msg.xyz_data.config);
+}
+
+void FanucControllerSim::on_request(bool joint, const values_t &values, int_t sequence, int_t config)
+{
+    if(sequence == STOP_TRAJECTORY)
+    {
+        LOG_F(INFO, "Stop, %zu points dropped", motion_.size());
+        motion_.clear();
+        reply(REPLY_CODE_SUCCESS);
+        return;
+    }
+    if(sequence < 0)
+    {
+        reply(REPLY_CODE_SUCCESS);
+        return;
+    }
+
+    if(inject_failure(sequence))
+    {
+        LOG_F(INFO, "Point %d rejected", sequence);
+        reply(REPLY_CODE_FAILURE);
+        return;
+    }
+    if(queue_size_ > 0 && motion_.size() >= static_cast<size_t>(queue_size_))
+    {
+        LOG_F(INFO, "Point %d rejected, motion queue is full", sequence);
+        reply(REPLY_CODE_FAILURE);
+        return;
+    }
+
+    LOG_F(INFO, "Point %d: %f %f %f %f %f %f (%s)", sequence, values[0], values[1], values[2],
+          values[3], values[4], values[5], joint ? "joint" : "xyzwpr");
+    motion_.push_back(target_t{joint, values});
+    if(!joint)
+        config_ = config;
+    reply(REPLY_CODE_SUCCESS);
+}
+
+bool FanucControllerSim::inject_failure(int_t sequence)
+{
+    if(fail_sequences_.count(sequence) != 0)
+        return true;
+    return fail_rate_ > 0 && std::uniform_real_distribution<double>(0, 1)(random_) < fail_rate_;
+}
+
+void FanucControllerSim::reply(REPLY_CODE code)
+{
+    char buffer[SimpleMessageFramer::MAX_FRAME_SIZE];
+    size_t size = encode_reply(*current_packet_, code, buffer, sizeof(buffer));
+    if(size == 0)
+        return;
+    QByteArray data(buffer, static_cast<int>(size));
+
+    int delay = ack_latency_;
+    if(ack_jitter_ > 0)
+        delay += std::uniform_int_distribution<int>(0, ack_jitter_)(random_);
+
+    if(delay == 0)
+    {
+        current_client_->write(data);
+        return;
+    }
+
+    QPointer<QTcpSocket> client(current_client_);
+    QTimer::singleShot(delay, this, [client, data](){
+        if(client)
+            client->write(data);
+    });
+}
+
+void FanucControllerSim::on_publish_timer()
+{
+    double now = clock_.nsecsElapsed() * 1e-9;
+    step_motion(now - last_step_);
+    last_step_ = now;
+
+    // do not burst after a stall
+    if(now - state_due_ > 1.)
+        state_due_ = now;
+    if(now - status_due_ > 1.)
+        status_due_ = now;
+
+    while(now >= state_due_)
+    {
+        publish_state();
+        state_due_ += 1. / state_rate_;
+    }
+    while(now >= status_due_)
+    {
+        publish_status();
+        status_due_ += 1. / status_rate_;
+    }
+}
+
+void FanucControllerSim::step_motion(double dt)
+{
+    values_t joints_before = joints_;
+    double remaining = dt;
+
+    while(remaining > 0 && !motion_.empty())
+    {
+        const target_t &target = motion_.front();
+        values_t &current = target.joint ? joints_ : pose_;
+
+        // time to reach the target, all axes arrive together
+        double time_left = 0;
+        if(target.joint)
+        {
+            for(int i=0; i<6; i++)
+                time_left = std::max(time_left, fabs(target.values[i] - current[i]) / joint_speed_);
+        }
+        else
+        {
+            double dist = 0;
+            for(int i=0; i<3; i++)
+                dist += (target.values[i] - current[i]) * (target.values[i] - current[i]);
+            time_left = sqrt(dist) / linear_speed_;
+            for(int i=3; i<6; i++)
+                time_left = std::max(time_left, fabs(target.values[i] - current[i]) / angular_speed_);
+        }
+
+        if(time_left <= remaining)
+        {
+            current = target.values;
+            remaining -= time_left;
+            motion_.pop_front();
+            continue;
+        }
+
+        double k = remaining / time_left;
+        for(int i=0; i<6; i++)
+            current[i] += (target.values[i] - current[i]) * k;
+        remaining = 0;
+    }
+
+    // cartesian moves do not update joints, there is no kinematic model here
+    for(int i=0; i<6; i++)
+        joint_velocity_[i] = dt > 0 ? (joints_[i] - joints_before[i]) / dt : 0;
+}
+
+template <typename Msg>
+void FanucControllerSim::broadcast(const Msg &msg)
+{
+    char buffer[sizeof(Msg)];
+    size_t size = encode(msg, bigendian_, buffer, sizeof(buffer));
+    for(auto &client : state_clients_)
+        client.first->write(buffer, static_cast<qint64>(size));
+}
+
+void FanucControllerSim::publish_state()
+{
+    state_sequence_++;
+
+    joint_position_t joint;
+    joint.header.comm_type = COMM_TYPE_TOPIC;
+    joint.sequence = state_sequence_;
+    for(int i=0; i<6; i++)
+        joint.joint_data[i] = static_cast<real_t>(joints_[i] * M_PI/180);
+    broadcast(joint);
+
+    xyzwpr_traj_pt_t xyzwpr;
+    xyzwpr.header.comm_type = COMM_TYPE_TOPIC;
+    xyzwpr.sequence = state_sequence_;
+    xyzwpr.xyz_data.prefix1 = prefix1_;
+    xyzwpr.xyz_data.prefix2 = prefix2_;
+    xyzwpr.xyz_data.config = config_;
+    for(int i=0; i<6; i++)
+    {
+        xyzwpr.joint_data[i] = joint.joint_data[i];
+        xyzwpr.xyz_data.xyzwpr[i] = static_cast<real_t>(pose_[i]);
+    }
+    broadcast(xyzwpr);
+
+    joint_feedback_t feedback;
+    feedback.header.comm_type = COMM_TYPE_TOPIC;
+    feedback.valid_fields = VALID_FIELD_TIME | VALID_FIELD_POSITION | VALID_FIELD_VELOCITY;
+    feedback.time = static_cast<real_t>(clock_.nsecsElapsed() * 1e-9);
+    for(int i=0; i<6; i++)
+    {
+        feedback.positions[i] = joint.joint_data[i];
+        feedback.velocities[i] = static_cast<real_t>(joint_velocity_[i] * M_PI/180);
+    }
+    broadcast(feedback);
+}
+
+void FanucControllerSim::publish_status()
+{
+    status_t status;
+    status.header.comm_type = COMM_TYPE_TOPIC;
+    status.drives_powered = TRI_STATE_ON;
+    status.e_stopped = TRI_STATE_OFF;
+    status.error_code = 0;
+    status.in_error = TRI_STATE_OFF;
+    status.in_motion = motion_.empty() ? TRI_STATE_OFF : TRI_STATE_ON;
+    status.mode = MODE_AUTO;
+    status.motion_possible = TRI_STATE_ON;
+    broadcast(status);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <array>
+#include <deque>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include "BotSocket/simple_message_dispatch.h"
+#include "BotSocket/simple_message_framer.h"
+
+// Stand-in for the FANUC controller side of the ROS-Industrial SimpleMessage
+// protocol. Relay port accepts trajectory points and replies after a configurable
+// latency, optionally failing some of them; state port publishes position, joint
+// feedback and status at configurable rates. Both ports answer PING unless
+// disabled. Accepted points are executed by a simple constant speed motion model.
+class FanucControllerSim : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FanucControllerSim(const QString &config_file, QObject *parent = nullptr);
+
+    bool start();
+
+private slots:
+    void on_relay_connection();
+    void on_state_connection();
+    void on_publish_timer();
+
+private:
+    typedef std::array<double, 6> values_t;
+
+    struct target_t {
+        bool joint;
+        values_t values;
+    };
+
+    void load_settings(const QString &config_file);
+    void read_relay(QTcpSocket *client);
+    void read_state(QTcpSocket *client);
+    void on_ping(const simple_message::ping_t &msg);
+    void on_joint_traj_pt(const simple_message::joint_traj_pt_t &msg);
+    void on_xyzwpr_traj_pt(const simple_message::xyzwpr_traj_pt_t &msg);
+    void on_output_pulse(const simple_message::output_pulse_t &msg);
+    void on_request(bool joint, const values_t &values, simple_message::int_t sequence, simple_message::int_t config);
+    void reply(simple_message::REPLY_CODE code);
+    bool inject_failure(simple_message::int_t sequence);
+
+    void step_motion(double dt);
+    void publish_state();
+    void publish_status();
+    template <typename Msg>
+    void broadcast(const Msg &msg);
+
+    QTcpServer relay_server_, state_server_;
+    std::map<QTcpSocket *, std::unique_ptr<SimpleMessageFramer>> relay_clients_;
+    std::map<QTcpSocket *, std::unique_ptr<SimpleMessageFramer>> state_clients_;
+    QTcpSocket *current_client_ = nullptr;
+    const simple_message::packet_view *current_packet_ = nullptr;
+    simple_message::handler_table<FanucControllerSim> handlers_;
+
+    QTimer publish_timer_;
+    QElapsedTimer clock_;
+    double last_step_ = 0;
+    double state_due_ = 0, status_due_ = 0;
+
+    std::deque<target_t> motion_;
+    values_t pose_ = {{0, 0, 0, 0, 0, 0}};    // mm, deg
+    values_t joints_ = {{0, 0, 0, 0, 0, 0}};  // deg
+    values_t joint_velocity_ = {{0, 0, 0, 0, 0, 0}};
+    simple_message::int_t config_ = 0;
+    simple_message::int_t state_sequence_ = 0;
+
+    std::mt19937 random_;
+
+    // settings
+    quint16 relay_port_ = 11000, state_port_ = 11002;
+    bool bigendian_ = false;
+    simple_message::int_t prefix1_ = 0, prefix2_ = 0;
+    int ack_latency_ = 0;          // ms
+    int ack_jitter_ = 0;           // ms, uniform in [0, jitter]
+    double fail_rate_ = 0;         // probability to reject a point
+    std::set<int> fail_sequences_; // always rejected
+    double state_rate_ = 10;       // Hz
+    double status_rate_ = 1;       // Hz
+    double linear_speed_ = 200;    // mm/s
+    double angular_speed_ = 90;    // deg/s
+    double joint_speed_ = 60;      // deg/s
+    int queue_size_ = 0;           // max points in motion, 0 - unlimited
+    bool relay_ping_ = true;       // answer PING on the relay port
+    bool state_ping_ = true;       // answer PING on the state port
+};
@@ -0,0 +1,27 @@
+#include <QCoreApplication>
+#include <string.h>
+
+#include "fanuc_controller_sim.h"
+#include "log/loguru.hpp"
+
+// Local FANUC controller simulator, see fanuc_controller_sim.h
+// usage: fanuc_sim [--config fanuc_sim.ini]
+int main(int argc, char *argv[])
+{
+    const char *config = "fanuc_sim.ini";
+    for(int i = 1; i + 1 < argc; ++i)
+    {
+        if (strcmp(argv[i], "--config") == 0)
+            config = argv[i + 1];
+    }
+
+    loguru::g_stderr_verbosity = loguru::Verbosity_INFO;
+    loguru::init(argc, argv);
+
+    QCoreApplication a(argc, argv);
+
+    FanucControllerSim sim(config);
+    if (!sim.start())
+        return 1;
+    return a.exec();
+}
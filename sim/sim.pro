@@ -0,0 +1,21 @@
+QT += core network
+QT -= gui
+
+CONFIG += c++14 console
+CONFIG -= app_bundle
+
+TARGET = fanuc_sim
+
+INCLUDEPATH += ../src
+
+SOURCES += \
+    main.cpp \
+    fanuc_controller_sim.cpp \
+    ../src/BotSocket/simple_message_codec.cpp \
+    ../src/BotSocket/simple_message_framer.cpp \
+    ../src/log/loguru.cpp
+
+HEADERS += \
+    fanuc_controller_sim.h
+
+unix: LIBS += -ldl -lpthread
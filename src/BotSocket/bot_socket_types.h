@@ -60,6 +60,31 @@ enum EN_WorkResult
     ENWR_ERROR
 };
 
+//Latency summary, ms
+struct SLatencyStats
+{
+    size_t count = 0;
+    double min  = 0.,
+           mean = 0.,
+           p50  = 0.,
+           p90  = 0.,
+           p99  = 0.,
+           max  = 0.;
+};
+
+struct SDiagnostics
+{
+    SLatencyStats relayRoundTrip; //trajectory point sent -> reply received
+    SLatencyStats stateInterval;  //between position packets
+    SLatencyStats stateJitter;    //deviation of the interval from its average
+    SLatencyStats stateDecode;    //packet processing time
+    SLatencyStats relayPing;      //PING round trip on the relay channel
+    SLatencyStats statePing;      //PING round trip on the state channel
+    SLatencyStats taskCycle;      //previous task done -> task done, simulated robot only
+    double relayRtt = -1.,        //smoothed PING round trip, ms, <0 if unknown
+           stateRtt = -1.;
+};
+
 }
 
 #endif // BOT_SOCKET_TYPES_H
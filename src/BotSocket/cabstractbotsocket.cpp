@@ -24,11 +24,13 @@ protected:
     void setSnapshotCameraPos(const gp_Pnt &, const gp_Pnt &, const gp_Dir &) final { }
     void makeSnapshot(const char *) final { }
     QImage makeSnapshot() final { return QImage(); }
+    QImage makeSnapshot(const BotSocket::SBotPosition &) final { return QImage(); }
     void setSnapshotShapeVisible(const GUI_TYPES::EN_ShapeType, bool) final { }
 
     void setDepthMapCameraPos(const gp_Pnt &, const gp_Pnt &, const gp_Dir &) final { }
     void makeDepthMap(const char *) final { }
     QImage makeDepthMap() final { return QImage(); }
+    QImage makeDepthMap(const BotSocket::SBotPosition &) final { return QImage(); }
     void setDepthMapShapeVisible(const GUI_TYPES::EN_ShapeType, bool) final { }
 
     void snapshotCalibrationDataRecieved(const gp_Vec &) final { }
@@ -111,6 +113,11 @@ QImage CAbstractBotSocket::makeSnapshot()
     return ui->makeSnapshot();
 }
 
+QImage CAbstractBotSocket::makeSnapshot(const BotSocket::SBotPosition &lsrhead)
+{
+    return ui->makeSnapshot(lsrhead);
+}
+
 void CAbstractBotSocket::setSnapshotShapeVisible(const GUI_TYPES::EN_ShapeType model, bool visible)
 {
     ui->setSnapshotShapeVisible(model, visible);
@@ -131,6 +138,11 @@ QImage CAbstractBotSocket::makeDepthMap()
     return ui->makeDepthMap();
 }
 
+QImage CAbstractBotSocket::makeDepthMap(const BotSocket::SBotPosition &lsrhead)
+{
+    return ui->makeDepthMap(lsrhead);
+}
+
 void CAbstractBotSocket::setDepthMapShapeVisible(const GUI_TYPES::EN_ShapeType model, bool visible)
 {
     ui->setDepthMapShapeVisible(model, visible);
@@ -28,6 +28,8 @@ protected:
                             const std::vector <GUI_TYPES::STaskPoint> &taskPoints) = 0;
     virtual void stopTasks() = 0;
     virtual void shapeTransformChanged(const GUI_TYPES::EN_ShapeType shType) = 0;
+    virtual BotSocket::SDiagnostics getDiagnostics() const = 0;
+    virtual void resetDiagnostics() = 0;
 
     void prepareComplete(const BotSocket::EN_PrepareResult result);
     void tasksComplete(const BotSocket::EN_WorkResult result);
@@ -43,11 +45,13 @@ protected:
     void setSnapshotCameraPos(const gp_Pnt &pos, const gp_Pnt &dir, const gp_Dir &orient);
     void makeSnapshot(const char *fname);
     QImage makeSnapshot();
+    QImage makeSnapshot(const BotSocket::SBotPosition &lsrhead);    // laser head there, not where it is
     void setSnapshotShapeVisible(const GUI_TYPES::EN_ShapeType model, bool visible);
 
     void setDepthMapCameraPos(const gp_Pnt &pos, const gp_Pnt &dir, const gp_Dir &orient);
     void makeDepthMap(const char *fname);
     QImage makeDepthMap();
+    QImage makeDepthMap(const BotSocket::SBotPosition &lsrhead);
     void setDepthMapShapeVisible(const GUI_TYPES::EN_ShapeType model, bool visible);
 
     void snapshotCalibrationDataRecieved(const gp_Vec &globalDelta);
@@ -16,6 +16,10 @@ protected:
                     const std::vector <GUI_TYPES::STaskPoint> &) final { }
     void stopTasks() final { }
     void shapeTransformChanged(const GUI_TYPES::EN_ShapeType) final { }
+    BotSocket::SDiagnostics getDiagnostics() const final {
+        return BotSocket::SDiagnostics();
+    }
+    void resetDiagnostics() final { }
 
 } emptySocket;
 
@@ -74,3 +78,13 @@ void CAbstractUi::shapeTransformChaged(const GUI_TYPES::EN_ShapeType shType)
     d_ptr->bot->shapeTransformChanged(shType);
 }
 
+BotSocket::SDiagnostics CAbstractUi::getDiagnostics() const
+{
+    return d_ptr->bot->getDiagnostics();
+}
+
+void CAbstractUi::resetDiagnostics()
+{
+    d_ptr->bot->resetDiagnostics();
+}
+
@@ -41,16 +41,20 @@ protected:
                     const std::vector <GUI_TYPES::STaskPoint> &taskPoints);
     void stopTasks();
     void shapeTransformChaged(const GUI_TYPES::EN_ShapeType shType);
+    BotSocket::SDiagnostics getDiagnostics() const;
+    void resetDiagnostics();
 
     //
     virtual void setSnapshotCameraPos(const gp_Pnt &pos, const gp_Pnt &dir, const gp_Dir &orient) = 0;
     virtual void makeSnapshot(const char *fname) = 0;
     virtual QImage makeSnapshot() = 0;
+    virtual QImage makeSnapshot(const BotSocket::SBotPosition &lsrhead) = 0;
     virtual void setSnapshotShapeVisible(const GUI_TYPES::EN_ShapeType model, bool visible) = 0;
 
     virtual void setDepthMapCameraPos(const gp_Pnt &pos, const gp_Pnt &dir, const gp_Dir &orient) = 0;
     virtual void makeDepthMap(const char *fname) = 0;
     virtual QImage makeDepthMap() = 0;
+    virtual QImage makeDepthMap(const BotSocket::SBotPosition &lsrhead) = 0;
     virtual void setDepthMapShapeVisible(const GUI_TYPES::EN_ShapeType model, bool visible) = 0;
 
     virtual void snapshotCalibrationDataRecieved(const gp_Vec &globalDelta) = 0;
@@ -0,0 +1,244 @@
+#include "calibration_channel.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QLocalSocket>
+#include <QSettings>
+#include <QStringList>
+#include <cstring>
+#include "../log/loguru.hpp"
+
+const quint32 calibration_shm_header::MAGIC;
+
+calibration_channel_config calibration_channel_config::load(const QString &file_name)
+{
+    QSettings settings(file_name, QSettings::IniFormat);
+    calibration_channel_config config;
+    config.server = settings.value("calib_server", config.server).toString();
+    config.snapshot_file = settings.value("calib_snapshot_file", config.snapshot_file).toString();
+    config.result_file = settings.value("calib_result_file", config.result_file).toString();
+    config.timeout = qMax(1, settings.value("calib_timeout", config.timeout).toInt());
+    config.camera_file = settings.value("calib_camera_file", config.camera_file).toString();
+    config.pixel_size = settings.value("calib_pixel_size", config.pixel_size).toDouble();
+    config.min_peak = settings.value("calib_min_peak", config.min_peak).toDouble();
+    return config;
+}
+
+CalibrationChannel::CalibrationChannel(const calibration_channel_config &config, QObject *parent):
+    QObject(parent),
+    config_(config),
+    server_(this),
+    memory_(config.server),
+    watcher_(this),
+    timeout_(this)
+{
+    timeout_.setSingleShot(true);
+    connect(&timeout_, &QTimer::timeout, this, &CalibrationChannel::on_timeout);
+    connect(&watcher_, &QFileSystemWatcher::directoryChanged, this, &CalibrationChannel::on_file_changed);
+    connect(&watcher_, &QFileSystemWatcher::fileChanged, this, &CalibrationChannel::on_file_changed);
+    connect(&server_, &QLocalServer::newConnection, this, &CalibrationChannel::on_connection);
+
+    // a socket file left by a crashed run blocks listen() on unix
+    QLocalServer::removeServer(config_.server);
+    if (!server_.listen(config_.server))
+        LOG_F(WARNING, "Calibration server %s: %s, using %s", config_.server.toLocal8Bit().constData(),
+              server_.errorString().toLocal8Bit().constData(), config_.result_file.toLocal8Bit().constData());
+}
+
+const calibration_channel_config &CalibrationChannel::config() const
+{
+    return config_;
+}
+
+bool CalibrationChannel::connected() const
+{
+    return client_ && client_->state() == QLocalSocket::ConnectedState;
+}
+
+bool CalibrationChannel::send(const QImage &snapshot)
+{
+    if (!connected() || snapshot.isNull())
+        return false;
+
+    const QImage image = snapshot.convertToFormat(QImage::Format_RGB32);
+    const int bytes = image.bytesPerLine() * image.height();
+    if (!map(static_cast<int>(sizeof(calibration_shm_header)) + bytes))
+        return false;
+
+    stop();
+    ++sequence_;
+    calibration_shm_header header;
+    header.sequence = sequence_;
+    header.width = image.width();
+    header.height = image.height();
+    header.bytes_per_line = image.bytesPerLine();
+
+    memory_.lock();
+    char *data = static_cast<char *>(memory_.data());
+    memcpy(data, &header, sizeof(header));
+    memcpy(data + sizeof(header), image.constBits(), static_cast<size_t>(bytes));
+    memory_.unlock();
+
+    client_->write(QString("snapshot %1\n").arg(sequence_).toLatin1());
+    client_->flush();
+    mode_ = SHARED_MEMORY;
+    timeout_.start(config_.timeout);
+    return true;
+}
+
+void CalibrationChannel::wait_file()
+{
+    watch(config_.result_file, RESULT_FILE);
+}
+
+bool CalibrationChannel::wait_camera()
+{
+    watch(config_.camera_file, CAMERA_FILE);
+    if (!connected())
+        return false;
+    client_->write(QString("snapshot %1\n").arg(sequence_).toLatin1());
+    client_->flush();
+    return true;
+}
+
+void CalibrationChannel::cancel()
+{
+    stop();
+}
+
+void CalibrationChannel::on_connection()
+{
+    while (QLocalSocket *socket = server_.nextPendingConnection())
+    {
+        // the last one to connect is the vision process
+        if (client_)
+        {
+            LOG_F(WARNING, "Another calibration client connected, dropping the previous one");
+            client_->disconnect(this);
+            client_->deleteLater();
+        }
+        client_ = socket;
+        connect(socket, &QLocalSocket::readyRead, this, &CalibrationChannel::on_ready_read);
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+            LOG_F(WARNING, "Calibration client disconnected");
+            if (client_ == socket)
+                client_ = nullptr;
+            socket->deleteLater();
+        });
+        LOG_F(INFO, "Calibration client connected");
+    }
+}
+
+void CalibrationChannel::on_ready_read()
+{
+    while (client_ && client_->canReadLine())
+    {
+        const QStringList line = QString::fromLatin1(client_->readLine()).trimmed().split(" ");
+        if (line.size() != 2 || line.at(0) != "result")
+        {
+            LOG_F(WARNING, "Unknown calibration message: %s", line.join(" ").toLocal8Bit().constData());
+            continue;
+        }
+        if (mode_ != SHARED_MEMORY || line.at(1).toUInt() != sequence_)
+        {
+            LOG_F(WARNING, "Late calibration result %s", line.at(1).toLocal8Bit().constData());
+            continue;
+        }
+
+        calibration_shm_header header;
+        memory_.lock();
+        memcpy(&header, memory_.constData(), sizeof(header));
+        memory_.unlock();
+        if (header.magic != calibration_shm_header::MAGIC || header.sequence != sequence_ || header.status < 0)
+        {
+            LOG_F(WARNING, "No calibration result in shared memory for %u", sequence_);
+            continue;
+        }
+        finish(header.status, header.delta[0], header.delta[1], header.delta[2]);
+    }
+}
+
+void CalibrationChannel::on_file_changed()
+{
+    if (mode_ != RESULT_FILE && mode_ != CAMERA_FILE)
+        return;
+
+    const QString &file_name = mode_ == RESULT_FILE ? config_.result_file : config_.camera_file;
+    QFile file(file_name);
+    if (!file.exists())
+        return;
+    // the file may be created empty and written later
+    if (!watcher_.files().contains(file_name))
+        watcher_.addPath(file_name);
+
+    if (mode_ == CAMERA_FILE)
+    {
+        // a frame still being written does not load
+        const QImage frame(file_name);
+        if (frame.isNull())
+            return;
+        stop();
+        camera_frame(frame);
+        return;
+    }
+
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return;
+
+    const QStringList line = QString::fromLatin1(file.readLine()).trimmed().split(";");
+    if (line.size() != 4)
+        return;
+    finish(line.at(3).toInt(), line.at(0).toDouble(), line.at(1).toDouble(), line.at(2).toDouble());
+}
+
+void CalibrationChannel::on_timeout()
+{
+    if (mode_ == IDLE)
+        return;
+    stop();
+    timed_out();
+}
+
+void CalibrationChannel::watch(const QString &file_name, mode_t mode)
+{
+    stop();
+    // late answers to an earlier snapshot do not count
+    ++sequence_;
+    QFile::remove(file_name);
+    watcher_.addPath(QFileInfo(file_name).absolutePath());
+    mode_ = mode;
+    timeout_.start(config_.timeout);
+}
+
+// the segment is made by the first request and grown when a snapshot does not fit
+bool CalibrationChannel::map(int size)
+{
+    if (memory_.isAttached() && memory_.size() >= size)
+        return true;
+    if (memory_.isAttached())
+        memory_.detach();
+    if (memory_.create(size))
+        return true;
+    if (memory_.error() == QSharedMemory::AlreadyExists && memory_.attach() && memory_.size() >= size)
+        return true;
+
+    LOG_F(WARNING, "Calibration shared memory of %d bytes: %s", size, memory_.errorString().toLocal8Bit().constData());
+    if (memory_.isAttached())
+        memory_.detach();
+    return false;
+}
+
+void CalibrationChannel::stop()
+{
+    mode_ = IDLE;
+    timeout_.stop();
+    if (!watcher_.files().isEmpty())
+        watcher_.removePaths(watcher_.files());
+    if (!watcher_.directories().isEmpty())
+        watcher_.removePaths(watcher_.directories());
+}
+
+void CalibrationChannel::finish(int status, double x, double y, double z)
+{
+    stop();
+    result(status, x, y, z);
+}
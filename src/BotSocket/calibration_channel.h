@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QImage>
+#include <QLocalServer>
+#include <QSharedMemory>
+#include <QTimer>
+
+class QLocalSocket;
+
+// Settings of the vision process link, see fanuc.ini
+struct calibration_channel_config {
+    QString server = "FanucBotGui.calib";   // local server name and shared memory key
+    QString snapshot_file = "snapshot.bmp";
+    QString result_file = "calib_result.txt";
+    int timeout = 5000;                     // ms from the snapshot to the result
+    QString camera_file;                    // camera frame to register in-process, empty - off
+    double pixel_size = 0.1;                // mm per snapshot pixel at the part
+    double min_peak = 0.5;                  // correlation below it is no match
+
+    static calibration_channel_config load(const QString &file_name);
+};
+
+// Shared memory layout: the header, then the snapshot rows (Format_RGB32)
+struct calibration_shm_header {
+    static const quint32 MAGIC = 0x424c4143;    // "CALB"
+    quint32 magic = MAGIC;
+    quint32 sequence = 0;       // of the last request
+    qint32 width = 0, height = 0, bytes_per_line = 0;
+    qint32 status = -1;         // set by the vision process: 0 - ok, > 0 - failed, -1 - pending
+    double delta[3] = {0, 0, 0};    // mm, as calib_result.txt has it
+};
+
+// Snapshot calibration exchange with the vision process.
+// When the vision process is connected to the local server, the snapshot is put
+// into shared memory and announced by a "snapshot <sequence>\n" line, the process
+// writes status and delta into the header and answers "result <sequence>\n".
+// Otherwise the snapshot is written to snapshot_file by the caller and
+// result_file ("x;y;z;status") is watched for. result() is emitted as soon as the
+// answer is there, timed_out() if it does not come in time.
+// With camera_file set the vision process only saves the frame there and the
+// caller registers it, camera_frame() is emitted once the file loads. The capture
+// is triggered by the same "snapshot <sequence>\n" line (shared memory is not
+// written then), or by the caller writing snapshot_file.
+class CalibrationChannel : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CalibrationChannel(const calibration_channel_config &config, QObject *parent = nullptr);
+
+    const calibration_channel_config &config() const;
+    bool connected() const;     // the vision process listens
+
+    // false if the snapshot cannot go through shared memory, use wait_file() then
+    bool send(const QImage &snapshot);
+    // removes the old result, call before writing snapshot_file
+    void wait_file();
+    // removes the old frame and triggers the connected vision process,
+    // false if there is none, write snapshot_file then
+    bool wait_camera();
+    void cancel();
+
+signals:
+    void result(int status, double x, double y, double z);
+    void camera_frame(const QImage &frame);
+    void timed_out();
+
+private:
+    enum mode_t { IDLE, SHARED_MEMORY, RESULT_FILE, CAMERA_FILE };
+
+    void on_connection();
+    void on_ready_read();
+    void on_file_changed();
+    void on_timeout();
+    void watch(const QString &file_name, mode_t mode);
+    bool map(int size);
+    void stop();
+    void finish(int status, double x, double y, double z);
+
+    calibration_channel_config config_;
+    QLocalServer server_;
+    QLocalSocket *client_ = nullptr;
+    QSharedMemory memory_;
+    QFileSystemWatcher watcher_;
+    QTimer timeout_;
+    quint32 sequence_ = 0;
+    mode_t mode_ = IDLE;
+};
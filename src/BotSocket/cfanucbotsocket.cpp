@@ -2,19 +2,39 @@
 
 #include <QTimer>
 #include <QSettings>
+#include <QBuffer>
 #include <QFile>
-#include <QTextStream>
-#include <QStringList>
+#include <QFileInfo>
+
+#include <chrono>
+
+#include <QtConcurrent/QtConcurrentMap>
 
 #include <Precision.hxx>
 
+#include "traffic_replay.h"
 #include "../PartReference/pointpairspartreferencer.h"
 #include "../log/loguru.hpp"
 
+static const int SETTLE_CHECK_INTERVAL = 20;   // ms
+
+static double monotonicTime()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void runParallel(size_t count, const std::function<void(size_t)> &job)
+{
+    std::vector<size_t> jobs(count);
+    for (size_t i = 0; i < count; ++i)
+        jobs[i] = i;
+    QtConcurrent::blockingMap(jobs, [&job](size_t i) { job(i); });
+}
+
 CFanucBotSocket::CFanucBotSocket() :
     CAbstractBotSocket(),
+    calib_(calibration_channel_config::load("fanuc.ini")),
     lastTaskDelay(0),
-    calibWaitCounter(0),
     bNeedCalib(false)
 {
     VLOG_CALL;
@@ -22,48 +42,107 @@ CFanucBotSocket::CFanucBotSocket() :
 
     QSettings settings("fanuc.ini", QSettings::IniFormat);
 
-    if(settings.contains("world2user") && settings.contains("user2world"))
+    camDelay_ = settings.value("cam_delay", 3000).toInt();
+    robot_ = fanuc_robot_config::load("fanuc.ini");
+    kinematics_.set_parameters(robot_.kinematics);
+    MotionStateTracker::config_t settle;
+    settle.position_tolerance = settings.value("settle_tolerance", settle.position_tolerance).toDouble();
+    settle.rotation_tolerance = settings.value("settle_angle_tolerance", settle.rotation_tolerance).toDouble();
+    settle.settle_time = settings.value("settle_time", settle.settle_time * 1000).toInt() / 1000.;
+    // cam_delay was a fixed wait after enqueue, now it is used only if arrival cannot be confirmed
+    settle.timeout = camDelay_ / 1000.;
+    motion_.set_config(settle);
+    streamTasks_ = settings.value("stream_tasks", false).toBool();
+    interpolatePose_ = settings.value("pose_interpolation", true).toBool();
+    int displayRate = qMax(1, settings.value("display_rate", 60).toInt());
+    const QString captureFile = settings.value("capture_file", QString()).toString();
+    const QString replayFile = settings.value("replay_file", QString()).toString();
+    const double replaySpeed = settings.value("replay_speed", 1.).toDouble();
+    stateReplayed_ = !replayFile.isEmpty();
+
+    fanuc_state_ = new FanucStateSocket();
+    fanuc_relay_ = new FanucRelaySocket();
+    // state channel is not connected when it is replayed
+    connection_ = new FanucConnectionManager("fanuc.ini", fanuc_relay_, replayFile.isEmpty() ? fanuc_state_ : nullptr);
+    fanuc_state_->moveToThread(&ioThread_);
+    fanuc_relay_->moveToThread(&ioThread_);
+    connection_->moveToThread(&ioThread_);
+
+    if (!captureFile.isEmpty() && capture_.open(captureFile, settings.value("bigendian", false).toBool()))
     {
-        QList<QVariant> w2u_v = settings.value("world2user").toList();
-        QList<QVariant> u2w_v = settings.value("user2world").toList();
-
-        if(w2u_v.size() >= 12 && u2w_v.size() >= 12)
-        {
-            QList<double> w2u_d, u2w_d;
-            for(QVariant v : w2u_v)
-                w2u_d.push_back(v.toDouble());
-            for(QVariant v : u2w_v)
-                u2w_d.push_back(v.toDouble());
-
-            world2user_.SetValues(w2u_d[0],w2u_d[1],w2u_d[2],w2u_d[3],
-                                  w2u_d[4],w2u_d[5],w2u_d[6],w2u_d[7],
-                                  w2u_d[8],w2u_d[9],w2u_d[10],w2u_d[11]);
-            user2world_.SetValues(u2w_d[0],u2w_d[1],u2w_d[2],u2w_d[3],
-                                  u2w_d[4],u2w_d[5],u2w_d[6],u2w_d[7],
-                                  u2w_d[8],u2w_d[9],u2w_d[10],u2w_d[11]);
-        }
+        fanuc_state_->set_capture(&capture_);
+        fanuc_relay_->set_capture(&capture_);
     }
-    flip_ = settings.value("flip", flip_).toBool();
-    up_ = settings.value("up", up_).toBool();
-    top_ = settings.value("top", top_).toBool();
-    camDelay_ = settings.value("cam_delay", 3000).toInt();
 
-    connect(&fanuc_state_, &FanucStateSocket::xyzwpr_position_received, this, &CFanucBotSocket::updatePosition);
-
-    connect(&fanuc_state_, &FanucStateSocket::connection_state_changed, this, &CFanucBotSocket::updateConnectionState);
+    // state comes from the capture instead of the controller
+    if (!replayFile.isEmpty())
+    {
+        TrafficReplay *replay = new TrafficReplay(replayFile, replaySpeed, fanuc_state_);
+        replay->moveToThread(&ioThread_);
+        connect(&ioThread_, &QThread::started, replay, &TrafficReplay::start);
+        connect(&ioThread_, &QThread::finished, replay, &QObject::deleteLater);
+    }
+    connect(&ioThread_, &QThread::started, connection_, &FanucConnectionManager::start);
+    connect(&ioThread_, &QThread::finished, connection_, &QObject::deleteLater);
+    connect(&ioThread_, &QThread::finished, fanuc_state_, &QObject::deleteLater);
+    connect(&ioThread_, &QThread::finished, fanuc_relay_, &QObject::deleteLater);
+
+    // Socket signals are handled right in the I/O thread and published
+    // to the GUI thread without blocking the socket event loop
+    connect(fanuc_state_, &FanucStateSocket::xyzwpr_position_received, this, [this](const xyzwpr_data &pos){
+        publishPosition(pos);
+    }, Qt::DirectConnection);
+
+    // JOINT_POSITION of the stock relay or the position of JOINT_FEEDBACK
+    connect(fanuc_state_, &FanucStateSocket::joint_position_received, this, [this](const joint_data &pos){
+        latestJoints_.store(pos);
+    }, Qt::DirectConnection);
+
+    connect(fanuc_state_, &FanucStateSocket::connection_state_changed, this, [this](){
+        postIoEvent(ENIE_CONNECTION_CHANGED);
+    }, Qt::DirectConnection);
+
+    connect(fanuc_state_, &FanucStateSocket::status_received, this, [this](bool moving, bool ready_to_move, bool error){
+        status_data status;
+        status.in_motion = moving;
+        status.ready_to_move = ready_to_move;
+        status.error = error;
+        latestStatus_.store(status);
+    }, Qt::DirectConnection);
+
+    connect(fanuc_relay_, &FanucRelaySocket::connection_state_changed, this, [this](){
+        postIoEvent(ENIE_CONNECTION_CHANGED);
+    }, Qt::DirectConnection);
+    connect(fanuc_relay_, &FanucRelaySocket::trajectory_enqueue_finished, this, [this](){
+        postIoEvent(ENIE_ENQUEUE_FINISHED);
+    }, Qt::DirectConnection);
+    connect(fanuc_relay_, &FanucRelaySocket::trajectory_xyzwpr_point_enqueue_fail, this, [this](){
+        postIoEvent(ENIE_ENQUEUE_FAIL);
+    }, Qt::DirectConnection);
+    connect(fanuc_relay_, &FanucRelaySocket::trajectory_joint_point_enqueue_fail, this, [this](){
+        postIoEvent(ENIE_ENQUEUE_FAIL);
+    }, Qt::DirectConnection);
+
+    settleTimer_.setInterval(SETTLE_CHECK_INTERVAL);
+    connect(&settleTimer_, &QTimer::timeout, this, &CFanucBotSocket::checkSettled);
+    connect(&calib_, &CalibrationChannel::result, this, &CFanucBotSocket::slCalibResult);
+    connect(&calib_, &CalibrationChannel::timed_out, this, &CFanucBotSocket::slCalibTimeout);
+    connect(&calib_, &CalibrationChannel::camera_frame, this, &CFanucBotSocket::slCalibFrame);
+    registration_.set_parallel(runParallel);
+
+    if (interpolatePose_)
+    {
+        connect(&renderTimer_, &QTimer::timeout, this, &CFanucBotSocket::renderPosition);
+        renderTimer_.start(1000 / displayRate);
+    }
 
-//    connect(&fanuc_state_, &FanucStateSocket::status_received, [&](bool moving, bool ready_to_move, bool error){
-//        moving_ = moving;
-//    });
+    ioThread_.start();
+}
 
-    connect(&fanuc_relay_, &FanucRelaySocket::connection_state_changed, this, &CFanucBotSocket::updateConnectionState);
-    // TODO: another signal / monitor position
-    connect(&fanuc_relay_, &FanucRelaySocket::trajectory_enqueue_finished, this, [&](){
-        completePath(BotSocket::ENWR_OK);
-    });
-    connect(&fanuc_relay_, &FanucRelaySocket::trajectory_xyzwpr_point_enqueue_fail, this, [&](){
-        completePath(BotSocket::ENWR_ERROR);
-    });
+CFanucBotSocket::~CFanucBotSocket()
+{
+    ioThread_.quit();
+    ioThread_.wait();
 }
 
 
@@ -98,75 +177,194 @@ BotSocket::SBotPosition xyzwpr2botposition(const xyzwpr_data &pos, const gp_Trsf
     return BotSocket::SBotPosition(p.xyzwpr[0], p.xyzwpr[1], p.xyzwpr[2], p.xyzwpr[3], p.xyzwpr[4], p.xyzwpr[5]);
 }
 
-xyzwpr_data botposition2xyzwpr(const GUI_TYPES::SVertex &globalPos, const GUI_TYPES::SRotationAngle &angle, const GUI_TYPES::SVertex &normal, const gp_Trsf &user2world)
+void CFanucBotSocket::publishPosition(const xyzwpr_data &pos)
 {
-    xyzwpr_data p;
-
-    //normal represent as the ZAxis
-    gp_Dir zDir(normal.x, normal.y, normal.z);
+    latestRobotPose_.store(pos);
+    const BotSocket::SBotPosition botPos = xyzwpr2botposition(pos, robot_.world2user);
+    latestPose_.store(botPos);
 
-    //normal rotation angles from global coord system
-    gp_Quaternion normal_q(gp_Vec(gp_Dir(0., 0., 1.)), gp_Vec(zDir));
+    if (interpolatePose_)
+    {
+        // stamped here, the I/O thread is not delayed by rendering
+        if (!poseSamples_.push(SPoseSample{monotonicTime(), botPos}))
+            LOG_F(WARNING, "Pose sample queue overflow");
+        return;
+    }
 
-    //delta rotation from global coord system
-    gp_Quaternion delta;
-    delta.SetEulerAngles(gp_Extrinsic_XYZ,
-                         angle.x * M_PI / 180.,
-                         angle.y * M_PI / 180.,
-                         angle.z * M_PI / 180.);
+    // only one GUI update in flight, it picks up the latest pose
+    if (!posePending_.exchange(true))
+        QMetaObject::invokeMethod(this, [this](){ updatePosition(); }, Qt::QueuedConnection);
+}
 
-    //final rotation from global coord system
-    gp_Quaternion finalRotationZAxis = normal_q * delta;
+void CFanucBotSocket::updatePosition()
+{
+    posePending_.store(false);
+    BotSocket::SBotPosition pos;
+    if (latestPose_.load(pos) > 0)
+        laserHeadPositionChanged(pos);
+}
 
-    double ax = 0, ay = 0, az = 0;
-    finalRotationZAxis.GetEulerAngles(gp_Extrinsic_XYZ,
-                         ax,
-                         ay,
-                         az);
+void CFanucBotSocket::renderPosition()
+{
+    SPoseSample sample;
+    while (poseSamples_.pop(sample))
+        poseHistory_.push(sample.time, sample.pos);
 
-    p.xyzwpr = {globalPos.x, globalPos.y, globalPos.z, ax * 180/M_PI, ay * 180/M_PI, az * 180/M_PI};
+    BotSocket::SBotPosition pos;
+    if (!poseHistory_.sample(monotonicTime() - poseHistory_.delay(), pos))
+        return;
 
-    return transform(p, user2world);
+    static const double POS_EPS = 1e-4;
+    if (pos.isEqual(shownPose_, POS_EPS, POS_EPS))
+        return;
+    shownPose_ = pos;
+    laserHeadPositionChanged(pos);
 }
 
-xyzwpr_data botposition2xyzwpr(const GUI_TYPES::STaskPoint &pos, const gp_Trsf &user2world)
+void CFanucBotSocket::postIoEvent(const EN_IoEvent event)
 {
-    return botposition2xyzwpr(pos.globalPos, pos.angle, pos.normal, user2world);
+    if (!ioEvents_.push(SIoEvent{event, ioRun_}))
+    {
+        LOG_F(ERROR, "I/O event queue overflow, event %d lost", event);
+        return;
+    }
+    if (!ioEventsPending_.exchange(true))
+        QMetaObject::invokeMethod(this, [this](){ processIoEvents(); }, Qt::QueuedConnection);
 }
 
-xyzwpr_data botposition2xyzwpr(const GUI_TYPES::SHomePoint &pos, const gp_Trsf &user2world)
+void CFanucBotSocket::processIoEvents()
 {
-    return botposition2xyzwpr(pos.globalPos, pos.angle, pos.normal, user2world);
+    ioEventsPending_.store(false);
+    SIoEvent event;
+    while (ioEvents_.pop(event))
+    {
+        switch (event.event)
+        {
+        case ENIE_CONNECTION_CHANGED:
+            updateConnectionState();
+            break;
+        case ENIE_ENQUEUE_FINISHED:
+            // replies queued before a stop and a quick restart belong to the old run
+            if (event.run == runGeneration_)
+                pathEnqueued();
+            break;
+        case ENIE_ENQUEUE_FAIL:
+            if (event.run == runGeneration_)
+                completePath(BotSocket::ENWR_ERROR);
+            break;
+        }
+    }
 }
 
-void CFanucBotSocket::updatePosition(const xyzwpr_data &pos)
+void CFanucBotSocket::prepare(const std::vector <GUI_TYPES::STaskPoint> &points)
 {
-    laserHeadPositionChanged(xyzwpr2botposition(pos, world2user_));
+    VLOG_CALL;
+    // startTasks() with the same points finds them converted
+    const bool ok = updatePoses(taskPoses_, robot_.make_batch(points, points.size()), "Task");
+    prepareComplete(ok ? BotSocket::EN_PrepareResult::ENPR_OK
+                       : BotSocket::EN_PrepareResult::ENPR_ERROR);
 }
 
-void CFanucBotSocket::prepare(const std::vector <GUI_TYPES::STaskPoint> &)
+bool CFanucBotSocket::updatePoses(PoseBatch &cache, PoseBatch batch, const char *what)
 {
-    prepareComplete(BotSocket::EN_PrepareResult::ENPR_OK);
+    if (!cache.converted() || !cache.same_input(batch))
+    {
+        const double start = monotonicTime();
+        cache = std::move(batch);
+        cache.convert();
+        LOG_F(INFO, "%s poses converted: %zu in %.3f ms", what, cache.size(), (monotonicTime() - start) * 1000);
+    }
+
+    const size_t bad = cache.first_error();
+    if (bad != cache.size())
+    {
+        LOG_F(ERROR, "%s point %zu: %s", what, bad, PoseBatch::error_string(cache.error(bad)));
+        return false;
+    }
+    return true;
 }
 
 void CFanucBotSocket::updateConnectionState()
 {
-    bool ok = fanuc_state_.connected() && fanuc_relay_.connected();
-    if(!fanuc_state_.connected() && fanuc_relay_.connected())
-    {
-        fanuc_relay_.disconnectFromHost();
-    }
+    bool state_connected = stateReplayed_ || fanuc_state_->connected();
+    bool relay_connected = fanuc_relay_->connected();
+    bool ok = state_connected && relay_connected;
+    // a half connected link is closed and reconnected by FanucConnectionManager
     socketStateChanged(ok ? BotSocket::ENBS_NOT_ATTACHED
                           : BotSocket::ENBS_FALL);
+
+    // nothing will confirm the points of a dropped link, do not wait for them
+    if (!ok && tasksRunning_)
+    {
+        LOG_F(ERROR, "Connection lost, aborting tasks");
+        completePath(BotSocket::ENWR_ERROR);
+    }
+}
+
+void CFanucBotSocket::pathEnqueued()
+{
+    // the next step needs the robot standing at the point
+    if (bNeedCalib || lastTaskDelay > 0 || curTask.empty())
+    {
+        motion_.start(monotonicTime(), pathTarget_);
+        statusVersion_ = latestStatus_.version(); // only statuses after the move count
+        settleTimer_.start();
+        // the view at the calibration point is known, render it while the robot moves
+        if (bNeedCalib)
+            renderCalibSnapshot();
+        return;
+    }
+    completePath(BotSocket::ENWR_OK);
+}
+
+void CFanucBotSocket::checkSettled()
+{
+    const double now = monotonicTime();
+
+    xyzwpr_data pos;
+    if (latestRobotPose_.load(pos) > 0)
+        motion_.on_pose(now, pos);
+
+    status_data status;
+    const unsigned version = latestStatus_.load(status);
+    if (version != statusVersion_)
+    {
+        statusVersion_ = version;
+        motion_.on_status(now, status.in_motion);
+    }
+
+    switch (motion_.update(now))
+    {
+    case MotionStateTracker::SETTLED:
+        LOG_F(INFO, "Settled in %.0f ms", (now - motion_.started()) * 1000);
+        break;
+    case MotionStateTracker::TIMED_OUT:
+        LOG_F(WARNING, "Arrival not confirmed in %.0f ms, continuing", (now - motion_.started()) * 1000);
+        break;
+    default:
+        return;
+    }
+    settleTimer_.stop();
+    motion_.reset();
+    completePath(BotSocket::ENWR_OK);
 }
 
 void CFanucBotSocket::completePath(const BotSocket::EN_WorkResult result)
 {
     VLOG_CALL;
 
+    // nothing runs after a stop; a restarted run drops the old ones by runGeneration_
+    if (!tasksRunning_)
+        return;
+
     if (result != BotSocket::ENWR_OK)
     {
-        curTask.clear();
+        settleTimer_.stop();
+        motion_.reset();
+        calib_.cancel();
+        calibSnapshot_ = SCalibSnapshot();
+        clearTasks();
+        tasksRunning_ = false;
         tasksComplete(result);
         return;
     }
@@ -175,31 +373,50 @@ void CFanucBotSocket::completePath(const BotSocket::EN_WorkResult result)
     {
         LOG_F(INFO, "need calibration");
         bNeedCalib = false;
-        QFile calibResFile("calib_result.txt");
-        if (calibResFile.exists())
-            calibResFile.remove();
-
-        QTimer::singleShot(camDelay_, this, [this](){
-            makeSnapshot("snapshot.bmp");
-        });
 
-        calibWaitCounter = 0;
-        QTimer::singleShot(camDelay_ + 2000, this, &CFanucBotSocket::slCalibWaitTimeout);
+        // robot has settled, see pathEnqueued()
+        QByteArray encoded;
+        const QImage snapshot = takeCalibSnapshot(encoded);
+        if (!calib_.config().camera_file.isEmpty())
+        {
+            calibReference_ = snapshot;
+            // without a connected process the snapshot file triggers the camera
+            if (calib_.wait_camera())
+                LOG_F(INFO, "Camera triggered through the vision process");
+            else
+                writeCalibSnapshot(snapshot, encoded);
+        }
+        else if (calib_.connected() && calib_.send(snapshot))
+        {
+            LOG_F(INFO, "Snapshot sent to the vision process");
+        }
+        else
+        {
+            calib_.wait_file();
+            writeCalibSnapshot(snapshot, encoded);
+        }
     }
     else if(lastTaskDelay > 0)
     {
         LOG_F(INFO, "task delay %d", lastTaskDelay);
-        QTimer::singleShot(lastTaskDelay, this, [&]() {
-            completePath(BotSocket::ENWR_OK);
+        QTimer::singleShot(lastTaskDelay, this, [this, run = runGeneration_]() {
+            if (run == runGeneration_)
+                completePath(BotSocket::ENWR_OK);
         });
         lastTaskDelay = 0;
     }
     else if (curTask.empty())
     {
         LOG_F(INFO, "finish");
+        calibSnapshot_ = SCalibSnapshot();
+        tasksRunning_ = false;
         tasksComplete(result); //result == BotSocket::ENWR_OK
         return;
     }
+    else if (streamTasks_)
+    {
+        streamNextSegment();
+    }
     else
     {
         GUI_TYPES::STaskPoint &p = curTask.front();
@@ -212,19 +429,14 @@ void CFanucBotSocket::completePath(const BotSocket::EN_WorkResult result)
         if(p.bUseHomePnt && !homePoints.empty())
         {
             LOG_F(INFO, "home point");
-            xyzwpr_data point = botposition2xyzwpr(homePoints[0], user2world_);
-            point.flip = flip_;
-            point.up = up_;
-            point.top = top_;
             p.bUseHomePnt = false;
-            fanuc_relay_.move_point(point);
+            sendPath({homePose}, {robot_.joint_moves ? curHomeJoints.front() : joint_data()});
         }
         else
         {
-            xyzwpr_data point = botposition2xyzwpr(p, user2world_);
-            point.flip = flip_;
-            point.up = up_;
-            point.top = top_;
+            const xyzwpr_data point = curPoses.front();
+            const joint_data joints = robot_.joint_moves ? curJoints.front() : joint_data();
+            std::vector <io_pulse_data> pulses;
             lastTaskDelay = static_cast <int> (p.delay * 1000.);
             bNeedCalib = p.bNeedCalib;
             // if point needs calibration, move to it after calibration
@@ -235,13 +447,180 @@ void CFanucBotSocket::completePath(const BotSocket::EN_WorkResult result)
             }
             else
             {
-                curTask.erase(curTask.begin());
+                // the controller times the dwell, only after the last task it is still waited out
+                if (const int output = taskOutput(p))
+                {
+                    pulses.push_back(io_pulse_data{0, output, p.delay});
+                    if (curTask.size() > 1)
+                        lastTaskDelay = 0;
+                }
+                dropTasks(1);
             }
-            fanuc_relay_.move_point(point);
+            sendPath({point}, {joints}, pulses);
         }
     }
 }
 
+bool CFanucBotSocket::convertTasks()
+{
+    if (!updatePoses(taskPoses_, robot_.make_batch(curTask, curTask.size()), "Task"))
+        return false;
+    if (!homePoints.empty() &&
+        !updatePoses(homePoses_, robot_.make_batch(homePoints, 1), "Home"))
+        return false;
+
+    curPoses.resize(curTask.size());
+    for (size_t i = 0; i < curPoses.size(); ++i)
+        curPoses[i] = robot_.robot_pose(taskPoses_, i);
+
+    if (!homePoints.empty())
+        homePose = robot_.robot_pose(homePoses_, 0);
+    return planPath();
+}
+
+// Symmetric points are turned about the tool Z and the arm configurations are
+// chosen over the whole path at once, starting from where the robot stands now.
+// Closed form solutions of the candidates are independent and computed in parallel.
+bool CFanucBotSocket::planPath()
+{
+    std::vector <bool> symmetric(curTask.size());
+    for (size_t i = 0; i < curTask.size(); ++i)
+        symmetric[i] = curTask[i].zSimmetry;
+
+    std::vector <bool> homeBefore(curTask.size());
+    for (size_t i = 0; i < curTask.size(); ++i)
+        homeBefore[i] = curTask[i].bUseHomePnt;
+
+    joint_data joints;
+    const bool hasJoints = latestJoints_.load(joints) > 0;
+    xyzwpr_data pose;
+    const bool hasPose = latestRobotPose_.load(pose) != 0;
+    // the arm configuration and the joint turns are chosen near where the arm is
+    if (robot_.joint_moves && !hasJoints)
+    {
+        LOG_F(ERROR, "No joint position from the controller, joint moves cannot be planned");
+        curJoints.clear();
+        curHomeJoints.clear();
+        return false;
+    }
+
+    fanuc_robot_config::path_plan_t plan;
+    if (!robot_.plan_path(kinematics_, curPoses, symmetric, homePoints.empty() ? nullptr : &homePose, homeBefore,
+                          hasJoints ? &joints : nullptr, hasPose ? &pose : nullptr, plan, runParallel))
+    {
+        curJoints.clear();
+        curHomeJoints.clear();
+        return false;
+    }
+    curPoses = plan.poses;
+    curJoints = plan.joints;
+    curHomeJoints = plan.home_joints;
+    return true;
+}
+
+void CFanucBotSocket::sendPath(const std::vector <xyzwpr_data> &poses, const std::vector <joint_data> &joints,
+                               const std::vector <io_pulse_data> &pulses)
+{
+    if (!poses.empty())
+        pathTarget_ = poses.back();
+    const unsigned run = runGeneration_;
+    if (robot_.joint_moves)
+        relayCall([this, run, joints, pulses](){ ioRun_ = run; fanuc_relay_->move_trajectory(joints, pulses); });
+    else
+        relayCall([this, run, poses, pulses](){ ioRun_ = run; fanuc_relay_->move_trajectory(poses, pulses); });
+}
+
+// DO the controller pulses for the delay of the task, 0 - the delay is waited out here
+int CFanucBotSocket::taskOutput(const GUI_TYPES::STaskPoint &p) const
+{
+    if (p.delay <= 0)
+        return 0;
+    switch (p.taskType)
+    {
+    case GUI_TYPES::ENBTT_DRILL:
+        return robot_.drill_output;
+    case GUI_TYPES::ENBTT_MARK:
+        return robot_.mark_output;
+    default:
+        return 0;
+    }
+}
+
+void CFanucBotSocket::dropTasks(const size_t count)
+{
+    curTask.erase(curTask.begin(), curTask.begin() + count);
+    curPoses.erase(curPoses.begin(), curPoses.begin() + count);
+    if (!curJoints.empty())
+        curJoints.erase(curJoints.begin(), curJoints.begin() + count);
+    if (!curHomeJoints.empty())
+        curHomeJoints.erase(curHomeJoints.begin(), curHomeJoints.begin() + count);
+}
+
+void CFanucBotSocket::clearTasks()
+{
+    curTask.clear();
+    curPoses.clear();
+    curJoints.clear();
+    curHomeJoints.clear();
+}
+
+void CFanucBotSocket::streamNextSegment()
+{
+    VLOG_CALL;
+
+    // Stream task points as one trajectory up to the next breakpoint:
+    // a point with delay or a point which needs calibration. Delays pulsed
+    // by the controller do not break the stream.
+    std::vector<xyzwpr_data> segment;
+    std::vector<joint_data> jointSegment;
+    std::vector<io_pulse_data> pulses;
+    segment.reserve(curPoses.size() + 1);
+
+    size_t taskCount = 0;
+    for (; taskCount < curTask.size(); ++taskCount)
+    {
+        GUI_TYPES::STaskPoint &p = curTask[taskCount];
+        if (p.bUseHomePnt && !homePoints.empty())
+        {
+            p.bUseHomePnt = false;
+            segment.push_back(homePose);
+            if (robot_.joint_moves)
+                jointSegment.push_back(curHomeJoints[taskCount]);
+        }
+        segment.push_back(curPoses[taskCount]);
+        if (robot_.joint_moves)
+            jointSegment.push_back(curJoints[taskCount]);
+
+        if (p.bNeedCalib)
+        {
+            // move to the point again after calibration
+            bNeedCalib = true;
+            p.bNeedCalib = false;
+            break;
+        }
+
+        lastTaskDelay = static_cast <int> (p.delay * 1000.);
+        if (const int output = taskOutput(p))
+        {
+            pulses.push_back(io_pulse_data{static_cast<int>(segment.size()) - 1, output, p.delay});
+            // only after the last task the dwell is still waited out
+            if (taskCount + 1 < curTask.size())
+                lastTaskDelay = 0;
+        }
+        if (lastTaskDelay > 0)
+        {
+            ++taskCount;
+            break;
+        }
+    }
+
+    dropTasks(taskCount);
+
+    LOG_F(INFO, "Stream %zu points, %zu pulses, %zu tasks left (calib=%d, delay=%d)",
+          segment.size(), pulses.size(), curTask.size(), bNeedCalib, lastTaskDelay);
+    sendPath(segment, jointSegment, pulses);
+}
+
 void CFanucBotSocket::calibFinish(const gp_Vec &delta)
 {
     VLOG_CALL;
@@ -261,70 +640,131 @@ void CFanucBotSocket::calibFinish(const gp_Vec &delta)
             p.globalPos.y += rotatedDelta.Y();
             p.globalPos.z += rotatedDelta.Z();
         }
+        if (!convertTasks())
+        {
+            completePath(BotSocket::ENWR_ERROR);
+            return;
+        }
         snapshotCalibrationDataRecieved(rotatedDelta);
+        // the correction moves the part, views rendered ahead are out of date
+        calibSnapshot_ = SCalibSnapshot();
     }
     completePath(BotSocket::ENWR_OK);
 }
 
-void CFanucBotSocket::slCalibWaitTimeout()
+void CFanucBotSocket::renderCalibSnapshot()
+{
+    if (!calibSnapshot_.image.isNull() && calibSnapshot_.target.xyzwpr == pathTarget_.xyzwpr)
+        return;
+
+    const double start = monotonicTime();
+    SCalibSnapshot s;
+    s.target = pathTarget_;
+    s.image = makeSnapshot(xyzwpr2botposition(pathTarget_, robot_.world2user));
+    // encoded too when it will go to the file
+    if (!calib_.connected())
+    {
+        const QByteArray format = QFileInfo(calib_.config().snapshot_file).suffix().toLatin1();
+        QBuffer buffer(&s.encoded);
+        buffer.open(QIODevice::WriteOnly);
+        if (!s.image.save(&buffer, format.isEmpty() ? "BMP" : format.constData()))
+            s.encoded.clear();
+    }
+    calibSnapshot_ = s;
+    LOG_F(INFO, "Calibration snapshot rendered ahead in %.0f ms", (monotonicTime() - start) * 1000);
+}
+
+// the one rendered for pathTarget_ on the way, or a new one where the robot is
+QImage CFanucBotSocket::takeCalibSnapshot(QByteArray &encoded)
+{
+    const SCalibSnapshot s = calibSnapshot_;
+    calibSnapshot_ = SCalibSnapshot();
+    if (!s.image.isNull() && s.target.xyzwpr == pathTarget_.xyzwpr)
+    {
+        encoded = s.encoded;
+        return s.image;
+    }
+    LOG_F(INFO, "No calibration snapshot rendered ahead");
+    encoded.clear();
+    return makeSnapshot();
+}
+
+void CFanucBotSocket::writeCalibSnapshot(const QImage &snapshot, const QByteArray &encoded)
+{
+    const QString &fileName = calib_.config().snapshot_file;
+    QFile file(fileName);
+    if (encoded.isEmpty() ? !snapshot.save(fileName)
+                          : !file.open(QIODevice::WriteOnly) || file.write(encoded) != encoded.size())
+        LOG_F(WARNING, "Snapshot not written to %s", fileName.toLocal8Bit().constData());
+}
+
+void CFanucBotSocket::slCalibResult(int status, double x, double y, double z)
 {
     VLOG_CALL;
 
-    static const int CALIB_ATTEMP_COUNT = 3;
-    QFile calibResFile("calib_result.txt");
-    if (!calibResFile.exists())
+    if (status == 0)
     {
-        LOG_F(INFO, "Waiting for file; %d time", calibWaitCounter);
-        if (calibWaitCounter < CALIB_ATTEMP_COUNT)
-        {
-            ++calibWaitCounter;
-            QTimer::singleShot(1000, this, &CFanucBotSocket::slCalibWaitTimeout);
-        }
-        else
-        {
-            LOG_F(WARNING, "No file after timeout");
-            calibWaitCounter = 0;
-            if (!execSnapshotCalibrationWarning())
-            {
-                curTask.clear();
-                completePath(BotSocket::ENWR_ERROR);
-                return;
-            }
-            else
-            {
-                calibFinish(gp_Vec());
-            }
-        }
+        LOG_F(INFO, "Delta ok");
+        calibFinish(gp_Vec(x, y, z));
+    }
+    else if (!execSnapshotCalibrationWarning())
+    {
+        curTask.clear();
+        completePath(BotSocket::ENWR_ERROR);
     }
     else
     {
-        LOG_F(INFO, "Calib file found");
-        gp_Vec delta;
-        if (calibResFile.open(QIODevice::ReadOnly | QIODevice::Text))
-        {
-            QTextStream in(&calibResFile);
-            QStringList line = in.readLine().split(";");
-            calibResFile.close();
+        calibFinish(gp_Vec());
+    }
+}
 
-            if (line.size() == 4)
-            {
-                if (line.at(3).toInt() == 0)
-                {
-                    LOG_F(INFO, "Delta ok");
-                    delta = gp_Vec(line.at(0).toDouble(),
-                                   line.at(1).toDouble(),
-                                   line.at(2).toDouble());
-                }
-                else if (!execSnapshotCalibrationWarning())
-                {
-                    curTask.clear();
-                    completePath(BotSocket::ENWR_ERROR);
-                    return;
-                }
-            }
-        }
-        calibFinish(delta);
+void CFanucBotSocket::slCalibTimeout()
+{
+    VLOG_CALL;
+
+    LOG_F(WARNING, "No calibration result in %d ms", calib_.config().timeout);
+    if (!execSnapshotCalibrationWarning())
+    {
+        curTask.clear();
+        completePath(BotSocket::ENWR_ERROR);
+        return;
+    }
+    calibFinish(gp_Vec());
+}
+
+void CFanucBotSocket::slCalibFrame(const QImage &frame)
+{
+    VLOG_CALL;
+
+    const QImage reference = calibReference_.convertToFormat(QImage::Format_RGB32);
+    calibReference_ = QImage();
+    if (reference.isNull())
+    {
+        slCalibResult(1, 0, 0, 0);
+        return;
+    }
+    // pixel_size is of the snapshot, the frame is brought to its size
+    const QImage camera = frame.scaled(reference.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+            .convertToFormat(QImage::Format_RGB32);
+
+    const auto gray = [](const QImage &image) {
+        return SnapshotRegistration::gray(reinterpret_cast<const uint32_t *>(image.constBits()),
+                                          image.width(), image.height(), image.bytesPerLine() / 4);
+    };
+    const auto start = std::chrono::steady_clock::now();
+    const SnapshotRegistration::result_t shift = registration_.align(gray(reference), gray(camera),
+                                                                     reference.width(), reference.height());
+    LOG_F(INFO, "Camera frame shift %.2f %.2f px, peak %.3f in %.0f ms", shift.dx, shift.dy, shift.peak,
+          std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+    if (shift.peak < calib_.config().min_peak)
+    {
+        slCalibResult(1, 0, 0, 0);
+        return;
     }
+    // image y is down, the camera frame y is up
+    const double pixel = calib_.config().pixel_size;
+    slCalibResult(0, shift.dx * pixel, -shift.dy * pixel, 0);
 }
 
 BotSocket::EN_CalibResult CFanucBotSocket::execCalibration(const std::vector<GUI_TYPES::SCalibPoint> &points)
@@ -379,18 +819,51 @@ void CFanucBotSocket::startTasks(const std::vector<GUI_TYPES::SHomePoint> &homeP
 
     curTask = taskPoints;
     homePoints = homePoints_;
+    // every pose is checked before the robot moves
+    if (!convertTasks())
+    {
+        clearTasks();
+        tasksComplete(BotSocket::ENWR_ERROR);
+        return;
+    }
     bNeedCalib = false;
     lastTaskDelay = 0;
-    calibWaitCounter = 0;
+    ++runGeneration_;
+    tasksRunning_ = true;
     completePath(BotSocket::ENWR_OK);
 }
 
 void CFanucBotSocket::stopTasks()
 {
     VLOG_CALL;
-    curTask.clear();
-    fanuc_relay_.stop();
+    tasksRunning_ = false;
+    ++runGeneration_;
+    clearTasks();
+    settleTimer_.stop();
+    motion_.reset();
+    calib_.cancel();
+    calibReference_ = QImage();
+    calibSnapshot_ = SCalibSnapshot();
+    relayCall([this, run = runGeneration_](){ ioRun_ = run; fanuc_relay_->stop(); });
 }
 
-void CFanucBotSocket::shapeTransformChanged(const GUI_TYPES::EN_ShapeType)
-{}
+void CFanucBotSocket::shapeTransformChanged(const GUI_TYPES::EN_ShapeType shType)
+{
+    // snapshots rendered ahead show the part and the desk where they were
+    if (shType == GUI_TYPES::ENST_PART || shType == GUI_TYPES::ENST_DESK)
+        calibSnapshot_ = SCalibSnapshot();
+}
+
+BotSocket::SDiagnostics CFanucBotSocket::getDiagnostics() const
+{
+    BotSocket::SDiagnostics diag;
+    fanuc_relay_->stats(diag);
+    fanuc_state_->stats(diag);
+    return diag;
+}
+
+void CFanucBotSocket::resetDiagnostics()
+{
+    relayCall([this]() { fanuc_relay_->reset_stats(); });
+    QMetaObject::invokeMethod(fanuc_state_, [this]() { fanuc_state_->reset_stats(); }, Qt::QueuedConnection);
+}
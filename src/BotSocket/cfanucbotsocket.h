@@ -4,6 +4,17 @@
 #include "cabstractbotsocket.h"
 #include "fanuc_state_socket.h"
 #include "fanuc_relay_socket.h"
+#include "seqlock.h"
+#include "spsc_queue.h"
+#include "pose_history.h"
+#include "motion_state_tracker.h"
+#include "fanuc_robot_config.h"
+#include "traffic_capture.h"
+#include "calibration_channel.h"
+#include "../Registration/snapshot_registration.h"
+
+#include <QThread>
+#include <QTimer>
 
 class CFanucBotSocket:
         public QObject,
@@ -12,6 +23,7 @@ class CFanucBotSocket:
     Q_OBJECT
 public:
     CFanucBotSocket();
+    ~CFanucBotSocket();
 
     BotSocket::EN_CalibResult execCalibration(const std::vector <GUI_TYPES::SCalibPoint> &points);
     void prepare(const std::vector <GUI_TYPES::STaskPoint> &points);
@@ -19,31 +31,120 @@ public:
                     const std::vector <GUI_TYPES::STaskPoint> &taskPoints);
     void stopTasks();
     void shapeTransformChanged(const GUI_TYPES::EN_ShapeType shType);
+    BotSocket::SDiagnostics getDiagnostics() const;
+    void resetDiagnostics();
 
 private:
+    // Socket events handed from the I/O thread to the GUI thread
+    enum EN_IoEvent
+    {
+        ENIE_CONNECTION_CHANGED,
+        ENIE_ENQUEUE_FINISHED,
+        ENIE_ENQUEUE_FAIL
+    };
+
+    struct SIoEvent
+    {
+        EN_IoEvent event;
+        unsigned run;       // runGeneration_ of the path the relay was working on
+    };
+
+    // Sockets live in ioThread_, GUI thread talks to them only by queued calls
+    QThread ioThread_;
+    FanucStateSocket *fanuc_state_;
+    FanucRelaySocket *fanuc_relay_;
+    FanucConnectionManager *connection_;
+    traffic_capture::writer capture_; // written from ioThread_ only
+
+    struct SPoseSample
+    {
+        double time;
+        BotSocket::SBotPosition pos;
+    };
 
-    FanucStateSocket fanuc_state_;
-    FanucRelaySocket fanuc_relay_;
+    SeqLock<BotSocket::SBotPosition> latestPose_;
+    SeqLock<xyzwpr_data> latestRobotPose_;  // controller coordinates
+    SeqLock<status_data> latestStatus_;
+    SeqLock<joint_data> latestJoints_;
+    std::atomic<bool> posePending_{false};
+    SpscQueue<SPoseSample, 256> poseSamples_;
 
-    gp_Trsf world2user_, user2world_;
-    bool flip_ = false, up_ = true, top_ = true;
+    // GUI side of the pose interpolation
+    bool interpolatePose_;
+    PoseHistory poseHistory_;
+    QTimer renderTimer_;
+    BotSocket::SBotPosition shownPose_;
+    SpscQueue<SIoEvent, 256> ioEvents_;
+    unsigned ioRun_ = 0;    // I/O thread copy of runGeneration_, set with every relay command
+    std::atomic<bool> ioEventsPending_{false};
 
-    void updatePosition(const xyzwpr_data &pos);
+    fanuc_robot_config robot_;
+
+    void publishPosition(const xyzwpr_data &pos); // I/O thread
+    void postIoEvent(const EN_IoEvent event);     // I/O thread
+    void updatePosition();                        // GUI thread
+    void renderPosition();                        // GUI thread
+    void processIoEvents();                       // GUI thread
     void updateConnectionState();
+    void pathEnqueued();                          // GUI thread
+    void checkSettled();                          // GUI thread
+
+    template <typename F>
+    void relayCall(F f) {
+        QMetaObject::invokeMethod(fanuc_relay_, f, Qt::QueuedConnection);
+    }
 
 private:
     void completePath(const BotSocket::EN_WorkResult result);
+    bool convertTasks();
+    bool updatePoses(PoseBatch &cache, PoseBatch batch, const char *what);
+    bool planPath();
+    void sendPath(const std::vector <xyzwpr_data> &poses, const std::vector <joint_data> &joints,
+                  const std::vector <io_pulse_data> &pulses = std::vector <io_pulse_data>());
+    int taskOutput(const GUI_TYPES::STaskPoint &p) const;
+    void dropTasks(const size_t count);
+    void clearTasks();
+    void streamNextSegment();
     void calibFinish(const gp_Vec &delta);
+    void renderCalibSnapshot();
+    QImage takeCalibSnapshot(QByteArray &encoded);
+    void writeCalibSnapshot(const QImage &snapshot, const QByteArray &encoded);
 
 private slots:
-    void slCalibWaitTimeout();
+    void slCalibResult(int status, double x, double y, double z);
+    void slCalibTimeout();
+    void slCalibFrame(const QImage &frame);
 
 private:
     std::vector <GUI_TYPES::STaskPoint> curTask;
     std::vector <GUI_TYPES::SHomePoint> homePoints;
+    std::vector <xyzwpr_data> curPoses; // robot poses of curTask
+    PoseBatch taskPoses_, homePoses_;   // last conversions, reused while the points and user2world stay
+    xyzwpr_data homePose;
+    std::vector <joint_data> curJoints; // joints of curPoses when robot_.joint_moves
+    std::vector <joint_data> curHomeJoints; // of the home move before each of curTask, when robot_.joint_moves
+    OpwKinematics kinematics_;
+    xyzwpr_data pathTarget_;    // last point sent to the relay
+    MotionStateTracker motion_;
+    QTimer settleTimer_;
+    CalibrationChannel calib_;  // snapshot to the vision process and the correction back
+    SnapshotRegistration registration_;
+    QImage calibReference_;     // rendered at the calibration point, for the camera frame
+
+    struct SCalibSnapshot
+    {
+        xyzwpr_data target;
+        QImage image;
+        QByteArray encoded;     // file contents of snapshot_file, when it is used
+    };
+    SCalibSnapshot calibSnapshot_;  // rendered while moving to pathTarget_, null image if none
+    unsigned statusVersion_ = 0;
+    bool tasksRunning_ = false; // between startTasks() and tasksComplete()
+    unsigned runGeneration_ = 0; // bumped by startTasks() and stopTasks(), events of older runs are dropped
     int camDelay_;
+    bool streamTasks_;
+    bool stateReplayed_;    // state comes from replay_file, its socket never connects
     int lastTaskDelay;
-    int calibWaitCounter;
     bool bNeedCalib;
 };
 
@@ -0,0 +1,249 @@
+#include "csimbotsocket.h"
+
+#include <QFile>
+#include <QSettings>
+#include <QTextStream>
+
+#include <algorithm>
+#include <limits>
+
+#include "../log/loguru.hpp"
+
+static const int PLAYBACK_INTERVAL = 20; // ms
+
+static BotSocket::SBotPosition shownPosition(const GUI_TYPES::SVertex &pos, const GUI_TYPES::SRotationAngle &angle)
+{
+    return BotSocket::SBotPosition(pos.x, pos.y, pos.z, angle.x, angle.y, angle.z);
+}
+
+static bool convertPoses(PoseBatch &batch, const char *what)
+{
+    batch.convert();
+    const size_t bad = batch.first_error();
+    if (bad != batch.size())
+    {
+        LOG_F(ERROR, "%s point %zu: %s", what, bad, PoseBatch::error_string(batch.error(bad)));
+        return false;
+    }
+    return true;
+}
+
+CSimBotSocket::CSimBotSocket() :
+    CAbstractBotSocket(),
+    hasPose_(false),
+    curStep_(0)
+{
+    VLOG_CALL;
+
+    robot_ = fanuc_robot_config::load("fanuc.ini");
+    kinematics_.set_parameters(robot_.kinematics);
+
+    model_.set_config(robot_.motion);
+
+    QSettings settings("fanuc.ini", QSettings::IniFormat);
+    settings.beginGroup("sim");
+    timeScale_ = qMax(0., settings.value("time_scale", 60.).toDouble());
+    reportFile_ = settings.value("report_file", "cycle_time.csv").toString();
+    settings.endGroup();
+
+    playbackTimer_.setInterval(PLAYBACK_INTERVAL);
+    connect(&playbackTimer_, &QTimer::timeout, this, &CSimBotSocket::playback);
+
+    // UI is attached after the socket is created
+    QTimer::singleShot(0, this, [this]() {
+        socketStateChanged(BotSocket::ENBS_NOT_ATTACHED);
+    });
+    LOG_F(INFO, "Simulated robot, time scale %.1f", timeScale_);
+}
+
+CSimBotSocket::~CSimBotSocket()
+{
+
+}
+
+BotSocket::EN_CalibResult CSimBotSocket::execCalibration(const std::vector<GUI_TYPES::SCalibPoint> &)
+{
+    LOG_F(WARNING, "No robot to calibrate the part against in simulation");
+    return BotSocket::ENCR_FALL;
+}
+
+void CSimBotSocket::prepare(const std::vector<GUI_TYPES::STaskPoint> &points)
+{
+    VLOG_CALL;
+    PoseBatch batch = robot_.make_batch(points, points.size());
+    prepareComplete(convertPoses(batch, "Task") ? BotSocket::EN_PrepareResult::ENPR_OK
+                                                : BotSocket::EN_PrepareResult::ENPR_ERROR);
+}
+
+// Waypoints in the order the real socket visits them, see CFanucBotSocket::completePath()
+bool CSimBotSocket::makePath(const std::vector<GUI_TYPES::SHomePoint> &homePoints,
+                             const std::vector<GUI_TYPES::STaskPoint> &taskPoints)
+{
+    PoseBatch tasks = robot_.make_batch(taskPoints, taskPoints.size());
+    PoseBatch home = robot_.make_batch(homePoints, homePoints.empty() ? 0 : 1);
+    if (!convertPoses(tasks, "Task") || !convertPoses(home, "Home"))
+        return false;
+
+    // the same turns of symmetric points as the robot gets, see CFanucBotSocket::planPath()
+    std::vector <xyzwpr_data> poses(taskPoints.size());
+    std::vector <bool> symmetric(taskPoints.size()), homeBefore(taskPoints.size());
+    for (size_t i = 0; i < taskPoints.size(); ++i)
+    {
+        poses[i] = robot_.robot_pose(tasks, i);
+        symmetric[i] = taskPoints[i].zSimmetry;
+        homeBefore[i] = taskPoints[i].bUseHomePnt;
+    }
+    const xyzwpr_data homePose = homePoints.empty() ? xyzwpr_data() : robot_.robot_pose(home, 0);
+    fanuc_robot_config::path_plan_t plan;
+    // an unknown start is the first point in the configuration the plan picks for it
+    if (!robot_.plan_path(kinematics_, poses, symmetric, homePoints.empty() ? nullptr : &homePose, homeBefore,
+                          hasPose_ ? &robotPose_.joints : nullptr, hasPose_ ? &robotPose_.pose : nullptr, plan))
+        return false;
+
+    path_.clear();
+    shownPath_.clear();
+    for (size_t i = 0; i < taskPoints.size(); ++i)
+    {
+        const GUI_TYPES::STaskPoint &p = taskPoints[i];
+        if (p.bUseHomePnt && !homePoints.empty())
+        {
+            CycleTimeModel::waypoint_t w;
+            w.pose = homePose;
+            if (robot_.joint_moves)
+                w.joints = plan.home_joints[i];
+            path_.push_back(w);
+            shownPath_.push_back(shownPosition(homePoints.front().globalPos, homePoints.front().angle));
+        }
+        CycleTimeModel::waypoint_t w;
+        w.task = static_cast <int> (i);
+        w.pose = plan.poses[i];
+        if (robot_.joint_moves)
+            w.joints = plan.joints[i];
+        w.delay = p.delay;
+        w.calib = p.bNeedCalib;
+        path_.push_back(w);
+        shownPath_.push_back(shownPosition(p.globalPos, p.angle));
+    }
+    return true;
+}
+
+void CSimBotSocket::startTasks(const std::vector<GUI_TYPES::SHomePoint> &homePoints,
+                               const std::vector<GUI_TYPES::STaskPoint> &taskPoints)
+{
+    VLOG_CALL;
+
+    playbackTimer_.stop();
+    if (!makePath(homePoints, taskPoints))
+    {
+        tasksComplete(BotSocket::ENWR_ERROR);
+        return;
+    }
+    // nothing is known about the start, the robot is put at the first point
+    if (!hasPose_ && !path_.empty())
+    {
+        robotPose_ = path_.front();
+        shownPose_ = shownPath_.front();
+        hasPose_ = true;
+    }
+
+    steps_ = model_.schedule(robotPose_, path_, robot_.joint_moves);
+    curStep_ = 0;
+    LOG_F(INFO, "Simulated job: %zu points in %.3f s", steps_.size(), steps_.empty() ? 0. : steps_.back().end());
+    clock_.start();
+    playbackTimer_.start();
+}
+
+void CSimBotSocket::playback()
+{
+    const double now = timeScale_ > 0 ? clock_.elapsed() / 1000. * timeScale_
+                                      : std::numeric_limits<double>::infinity();
+    while (curStep_ < steps_.size() && steps_[curStep_].end() <= now)
+    {
+        robotPose_ = path_[curStep_];
+        shownPose_ = shownPath_[curStep_];
+        ++curStep_;
+    }
+    if (curStep_ == steps_.size())
+    {
+        laserHeadPositionChanged(shownPose_);
+        finish();
+        return;
+    }
+
+    // position is interpolated along the move, the tool turns on arrival
+    const CycleTimeModel::step_t &step = steps_[curStep_];
+    const double t = step.move > 0 ? std::min(1., std::max(0., (now - step.start) / step.move)) : 1.;
+    const BotSocket::SPosition &from = shownPose_.globalPos, &to = shownPath_[curStep_].globalPos;
+    BotSocket::SBotPosition pos = t < 1. ? shownPose_ : shownPath_[curStep_];
+    pos.globalPos = BotSocket::SPosition(from.x + (to.x - from.x) * t,
+                                         from.y + (to.y - from.y) * t,
+                                         from.z + (to.z - from.z) * t);
+    laserHeadPositionChanged(pos);
+}
+
+void CSimBotSocket::finish()
+{
+    playbackTimer_.stop();
+
+    // a move to the home point counts to the task after it
+    double taskStart = 0;
+    for (const CycleTimeModel::step_t &step : steps_)
+    {
+        LOG_F(INFO, "Step %d: move %.3f settle %.3f delay %.3f calib %.3f, done at %.3f s",
+              step.task, step.move, step.settle, step.delay, step.calib, step.end());
+        if (step.task < 0)
+            continue;
+        taskCycle_.add((step.end() - taskStart) * 1000.);
+        taskStart = step.end();
+    }
+    LOG_F(INFO, "Simulated cycle time %.3f s", steps_.empty() ? 0. : steps_.back().end());
+    writeReport();
+    tasksComplete(BotSocket::ENWR_OK);
+}
+
+void CSimBotSocket::writeReport() const
+{
+    if (reportFile_.isEmpty())
+        return;
+    QFile file(reportFile_);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        LOG_F(WARNING, "Cannot write %s", reportFile_.toLocal8Bit().constData());
+        return;
+    }
+
+    QTextStream out(&file);
+    out << "task;start_s;move_s;settle_s;delay_s;calib_s;end_s\n";
+    for (const CycleTimeModel::step_t &step : steps_)
+        out << (step.task < 0 ? QString("home") : QString::number(step.task)) << ';'
+            << QString::number(step.start, 'f', 3) << ';'
+            << QString::number(step.move, 'f', 3) << ';'
+            << QString::number(step.settle, 'f', 3) << ';'
+            << QString::number(step.delay, 'f', 3) << ';'
+            << QString::number(step.calib, 'f', 3) << ';'
+            << QString::number(step.end(), 'f', 3) << '\n';
+    out << "total;;;;;;" << QString::number(steps_.empty() ? 0. : steps_.back().end(), 'f', 3) << '\n';
+}
+
+void CSimBotSocket::stopTasks()
+{
+    VLOG_CALL;
+    // the robot stays at the last point it reached
+    playbackTimer_.stop();
+    steps_.clear();
+}
+
+void CSimBotSocket::shapeTransformChanged(const GUI_TYPES::EN_ShapeType)
+{}
+
+BotSocket::SDiagnostics CSimBotSocket::getDiagnostics() const
+{
+    BotSocket::SDiagnostics diag;
+    diag.taskCycle = taskCycle_.stats();
+    return diag;
+}
+
+void CSimBotSocket::resetDiagnostics()
+{
+    taskCycle_.reset();
+}
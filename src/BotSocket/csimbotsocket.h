@@ -0,0 +1,63 @@
+#ifndef CSIMBOTSOCKET_H
+#define CSIMBOTSOCKET_H
+
+#include "cabstractbotsocket.h"
+#include "cycle_time_model.h"
+#include "fanuc_robot_config.h"
+#include "latency_histogram.h"
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+// Dry run backend: task lists are executed against CycleTimeModel instead of the
+// robot. startTasks schedules the whole job up front and plays it back on a
+// virtual clock running time_scale times faster than the wall clock (0 - at once),
+// the laser head follows the schedule. Cycle times of every task and of the job
+// are logged and written to report_file. Calibration snapshots take calib_time
+// and never correct the points. Settings are in the [sim] group of fanuc.ini.
+class CSimBotSocket:
+        public QObject,
+        public CAbstractBotSocket
+{
+    Q_OBJECT
+public:
+    CSimBotSocket();
+    ~CSimBotSocket();
+
+    BotSocket::EN_CalibResult execCalibration(const std::vector <GUI_TYPES::SCalibPoint> &points);
+    void prepare(const std::vector <GUI_TYPES::STaskPoint> &points);
+    void startTasks(const std::vector <GUI_TYPES::SHomePoint> &homePoints,
+                    const std::vector <GUI_TYPES::STaskPoint> &taskPoints);
+    void stopTasks();
+    void shapeTransformChanged(const GUI_TYPES::EN_ShapeType shType);
+    BotSocket::SDiagnostics getDiagnostics() const;
+    void resetDiagnostics();
+
+private:
+    bool makePath(const std::vector <GUI_TYPES::SHomePoint> &homePoints,
+                  const std::vector <GUI_TYPES::STaskPoint> &taskPoints);
+    void playback();
+    void finish();
+    void writeReport() const;
+
+private:
+    fanuc_robot_config robot_;
+    OpwKinematics kinematics_;
+    CycleTimeModel model_;
+    double timeScale_;                  // virtual seconds per wall clock second, 0 - instant
+    QString reportFile_;
+
+    std::vector <CycleTimeModel::waypoint_t> path_;
+    std::vector <BotSocket::SBotPosition> shownPath_; // laser head at the waypoints
+    std::vector <CycleTimeModel::step_t> steps_;
+    CycleTimeModel::waypoint_t robotPose_;
+    BotSocket::SBotPosition shownPose_;
+    bool hasPose_;                      // robotPose_ is known, else the first move takes no time
+
+    QTimer playbackTimer_;
+    QElapsedTimer clock_;
+    size_t curStep_;
+    LatencyHistogram taskCycle_;        // ms
+};
+
+#endif // CSIMBOTSOCKET_H
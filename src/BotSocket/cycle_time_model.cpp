@@ -0,0 +1,74 @@
+#include "cycle_time_model.h"
+#include <algorithm>
+#include <cmath>
+#include "motion_state_tracker.h"
+
+void CycleTimeModel::set_config(const config_t &config)
+{
+    config_ = config;
+}
+
+const CycleTimeModel::config_t &CycleTimeModel::config() const
+{
+    return config_;
+}
+
+double CycleTimeModel::profile_time(double distance, double speed, double accel)
+{
+    distance = std::fabs(distance);
+    if (distance <= 0 || speed <= 0)
+        return 0;
+    if (accel <= 0)
+        return distance / speed;
+    // accelerating to speed and braking back takes speed^2 / accel
+    if (distance >= speed * speed / accel)
+        return distance / speed + speed / accel;
+    return 2 * std::sqrt(distance / accel);
+}
+
+double CycleTimeModel::move_time(const xyzwpr_data &from, const xyzwpr_data &to) const
+{
+    return std::max(profile_time(MotionStateTracker::distance(from, to), config_.linear_speed, config_.linear_accel),
+                    profile_time(MotionStateTracker::rotation_angle(from, to), config_.angular_speed, config_.angular_accel));
+}
+
+double CycleTimeModel::move_time(const joint_data &from, const joint_data &to) const
+{
+    double result = 0;
+    for (size_t i = 0; i < from.size(); ++i)
+        result = std::max(result, profile_time(to[i] - from[i], config_.joint_speed[i], config_.joint_accel[i]));
+    return result;
+}
+
+std::vector<CycleTimeModel::step_t> CycleTimeModel::schedule(const waypoint_t &start, const std::vector<waypoint_t> &path,
+                                                              bool joint_moves) const
+{
+    std::vector<step_t> result;
+    result.reserve(path.size());
+    const waypoint_t *from = &start;
+    double time = 0;
+    for (size_t i = 0; i < path.size(); ++i)
+    {
+        const waypoint_t &to = path[i];
+        const bool last = i + 1 == path.size();
+        step_t step;
+        step.task = to.task;
+        step.start = time;
+        step.move = joint_moves ? move_time(from->joints, to.joints) : move_time(from->pose, to.pose);
+        step.settle = 0;
+        step.calib = 0;
+        if (to.calib)
+        {
+            // the point is approached again after the snapshot, it is already there
+            step.settle += config_.settle_time;
+            step.calib = config_.calib_time;
+        }
+        step.delay = to.task < 0 ? 0 : to.delay;
+        if (step.delay > 0 || last)
+            step.settle += config_.settle_time;
+        time = step.end();
+        result.push_back(step);
+        from = &to;
+    }
+    return result;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include "fanuc_socket_types.h"
+
+// Estimates how long a task list takes on the robot without moving it.
+// The robot stops at every point; every axis follows a trapezoidal velocity
+// profile (triangular if the move is too short to reach full speed) and a move
+// lasts as long as its slowest axis. XYZWPR moves are limited by the TCP speed and
+// the tool rotation speed, joint moves by the speed of every joint. settle_time is
+// added where the bot socket waits for the robot to settle: before a delay, before
+// a calibration snapshot and at the end of the job. Times are in seconds.
+class CycleTimeModel
+{
+public:
+    struct config_t {
+        double linear_speed = 1000;    // mm/s
+        double linear_accel = 4000;    // mm/s^2, <= 0 - instant
+        double angular_speed = 360;    // deg/s
+        double angular_accel = 1440;   // deg/s^2
+        joint_data joint_speed = {{170, 140, 160, 230, 230, 350}};   // deg/s
+        joint_data joint_accel = {{600, 500, 600, 900, 900, 1400}};  // deg/s^2
+        double settle_time = 0.2;      // s
+        double calib_time = 3;         // s, snapshot and its processing
+    };
+
+    struct waypoint_t {
+        int task = -1;                        // index in the task list, -1 - home point
+        xyzwpr_data pose;
+        joint_data joints = {{0, 0, 0, 0, 0, 0}};
+        double delay = 0;                     // s after arrival
+        bool calib = false;                   // snapshot after arrival, then the point is approached again
+    };
+
+    struct step_t {
+        int task;
+        double start;                         // from the job start
+        double move, settle, delay, calib;
+        double end() const { return start + move + settle + delay + calib; }
+    };
+
+    void set_config(const config_t &config);
+    const config_t &config() const;
+
+    static double profile_time(double distance, double speed, double accel);
+    double move_time(const xyzwpr_data &from, const xyzwpr_data &to) const;
+    double move_time(const joint_data &from, const joint_data &to) const;
+
+    // one step per waypoint, the robot starts standing at start
+    std::vector<step_t> schedule(const waypoint_t &start, const std::vector<waypoint_t> &path,
+                                 bool joint_moves) const;
+
+private:
+    config_t config_;
+};
@@ -0,0 +1,173 @@
+#include "fanuc_connection_manager.h"
+#include <QFileInfo>
+#include <QSettings>
+#include <algorithm>
+#include "fanuc_relay_socket.h"
+#include "fanuc_state_socket.h"
+#include "log/loguru.hpp"
+
+const int FanucConnectionManager::BACKOFF_MIN;
+const int FanucConnectionManager::BACKOFF_MAX;
+const int FanucConnectionManager::STABLE_TIME;
+
+fanuc_connection_config fanuc_connection_config::load(const QString &file_name)
+{
+    QSettings settings(file_name, QSettings::IniFormat);
+    fanuc_connection_config config;
+    config.host = settings.value("server_ip", config.host).toString();
+    config.relay_port = static_cast<quint16>(settings.value("server_relay_port", config.relay_port).toInt());
+    config.state_port = static_cast<quint16>(settings.value("server_state_port", config.state_port).toInt());
+    config.bigendian = settings.value("bigendian", config.bigendian).toBool();
+    config.prefix1 = settings.value("prefix1", config.prefix1).toInt();
+    config.prefix2 = settings.value("prefix2", config.prefix2).toInt();
+    config.relay_window = std::max(1, settings.value("relay_window", config.relay_window).toInt());
+    config.relay_retries = std::max(0, settings.value("relay_retries", config.relay_retries).toInt());
+    config.ping_interval = std::max(0, settings.value("ping_interval", config.ping_interval).toInt());
+    config.ping_timeout = std::max(config.ping_interval, settings.value("ping_timeout", config.ping_timeout).toInt());
+    return config;
+}
+
+bool fanuc_connection_config::same_endpoint(const fanuc_connection_config &other) const
+{
+    return host == other.host &&
+           relay_port == other.relay_port &&
+           state_port == other.state_port &&
+           bigendian == other.bigendian;
+}
+
+bool fanuc_connection_config::operator==(const fanuc_connection_config &other) const
+{
+    return same_endpoint(other) &&
+           prefix1 == other.prefix1 &&
+           prefix2 == other.prefix2 &&
+           relay_window == other.relay_window &&
+           relay_retries == other.relay_retries &&
+           ping_interval == other.ping_interval &&
+           ping_timeout == other.ping_timeout;
+}
+
+FanucConnectionManager::FanucConnectionManager(const QString &config_file, FanucRelaySocket *relay,
+                                               FanucStateSocket *state, QObject *parent):
+    QObject(parent),
+    config_file_(config_file),
+    relay_(relay),
+    state_(state),
+    watcher_(this),
+    retry_timer_(this),
+    random_(std::random_device()())
+{
+    retry_timer_.setSingleShot(true);
+    connect(&retry_timer_, &QTimer::timeout, this, &FanucConnectionManager::reconnect);
+    connect(&watcher_, &QFileSystemWatcher::fileChanged, this, &FanucConnectionManager::on_file_changed);
+
+    connect(relay_, &FanucRelaySocket::connection_state_changed, this, &FanucConnectionManager::on_channel_state);
+    if(state_)
+        connect(state_, &FanucStateSocket::connection_state_changed, this, &FanucConnectionManager::on_channel_state);
+}
+
+const fanuc_connection_config &FanucConnectionManager::config() const
+{
+    return config_;
+}
+
+void FanucConnectionManager::start()
+{
+    VLOG_CALL;
+    config_ = fanuc_connection_config::load(config_file_);
+    watch_config();
+    reconnect();
+}
+
+void FanucConnectionManager::watch_config()
+{
+    // editors often replace the file, the watcher forgets it then
+    if(!watcher_.files().contains(config_file_) && QFileInfo(config_file_).exists())
+        watcher_.addPath(config_file_);
+}
+
+void FanucConnectionManager::on_file_changed(const QString &)
+{
+    watch_config();
+
+    const fanuc_connection_config config = fanuc_connection_config::load(config_file_);
+    if(config == config_)
+        return;
+
+    const bool same_endpoint = config.same_endpoint(config_);
+    config_ = config;
+    LOG_F(INFO, "%s changed", config_file_.toLocal8Bit().data());
+
+    if(same_endpoint)
+    {
+        relay_->set_config(config_);
+        if(state_)
+            state_->set_config(config_);
+        return;
+    }
+
+    retry_timer_.stop();
+    attempt_ = 0;
+    reset_channels();
+    reconnect();
+}
+
+void FanucConnectionManager::on_channel_state(bool connected)
+{
+    if(resetting_)
+        return;
+
+    if(connected)
+    {
+        if(all_connected())
+        {
+            LOG_F(INFO, "Connected to %s", config_.host.toLocal8Bit().data());
+            connected_since_.start();
+        }
+        return;
+    }
+
+    // error and disconnected come for the same failure, one retry is enough
+    if(retry_timer_.isActive())
+        return;
+
+    if(connected_since_.isValid() && connected_since_.elapsed() >= STABLE_TIME)
+        attempt_ = 0;
+    connected_since_.invalidate();
+
+    reset_channels();
+
+    const int delay = backoff_delay();
+    attempt_++;
+    LOG_F(WARNING, "Connection lost, reconnect %d in %d ms", attempt_, delay);
+    retry_timer_.start(delay);
+}
+
+void FanucConnectionManager::reconnect()
+{
+    relay_->connect_to_host(config_);
+    if(state_)
+        state_->connect_to_host(config_);
+}
+
+void FanucConnectionManager::reset_channels()
+{
+    resetting_ = true;
+    relay_->abort();
+    if(state_)
+        state_->abort();
+    resetting_ = false;
+}
+
+bool FanucConnectionManager::all_connected() const
+{
+    return relay_->connected() && (!state_ || state_->connected());
+}
+
+// "equal jitter": half of the exponential delay is fixed, half is random,
+// so several clients do not reconnect in lockstep
+int FanucConnectionManager::backoff_delay()
+{
+    const int delay = std::min(BACKOFF_MAX, BACKOFF_MIN << std::min(attempt_, 16));
+    std::uniform_int_distribution<int> jitter(0, delay / 2);
+    return delay / 2 + jitter(random_);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <random>
+
+class FanucRelaySocket;
+class FanucStateSocket;
+
+// Connection settings of both channels, see fanuc.ini
+struct fanuc_connection_config {
+    QString host = "127.0.0.1";
+    quint16 relay_port = 11000;
+    quint16 state_port = 11002;
+    bool bigendian = false;
+    int prefix1 = 0, prefix2 = 0;
+    int relay_window = 1;
+    int relay_retries = 0;
+    int ping_interval = 200;   // ms, 0 - no link check
+    int ping_timeout = 800;    // ms without any packet before the link is dropped
+
+    static fanuc_connection_config load(const QString &file_name);
+
+    // settings that need a new connection to take effect
+    bool same_endpoint(const fanuc_connection_config &other) const;
+    bool operator==(const fanuc_connection_config &other) const;
+    bool operator!=(const fanuc_connection_config &other) const { return !(*this == other); }
+};
+
+// Owns the connection life cycle of the relay and state sockets.
+// The config file is parsed once and watched for changes. When any channel drops,
+// both are closed and reconnected together after a jittered exponential backoff,
+// so a flapping link does not reset the channels one by one. Only one retry can
+// be pending, whatever number of error/disconnect signals a failure produces.
+// Has to live in the thread of the sockets. state may be null (state replay).
+class FanucConnectionManager : public QObject
+{
+    Q_OBJECT
+public:
+    FanucConnectionManager(const QString &config_file, FanucRelaySocket *relay, FanucStateSocket *state,
+                           QObject *parent = nullptr);
+
+    const fanuc_connection_config &config() const;
+
+    static const int BACKOFF_MIN = 500;      // ms
+    static const int BACKOFF_MAX = 30000;    // ms
+    static const int STABLE_TIME = 10000;    // ms connected to forget earlier failures
+
+public slots:
+    void start();
+
+private:
+    void on_channel_state(bool connected);
+    void on_file_changed(const QString &path);
+    void watch_config();
+    void reconnect();
+    void reset_channels();
+    bool all_connected() const;
+    int backoff_delay();
+
+    QString config_file_;
+    FanucRelaySocket *relay_;
+    FanucStateSocket *state_;
+    fanuc_connection_config config_;
+    QFileSystemWatcher watcher_;
+    QTimer retry_timer_;
+    QElapsedTimer connected_since_;
+    int attempt_ = 0;
+    bool resetting_ = false;   // channels are closed on purpose
+    std::mt19937 random_;
+};
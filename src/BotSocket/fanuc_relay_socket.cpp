@@ -1,14 +1,17 @@
 #include "fanuc_relay_socket.h"
 #define _USE_MATH_DEFINES
 #include <math.h>
-#include <QTimer>
-#include <QSettings>
+#include <algorithm>
 #include "log/loguru.hpp"
 
 using namespace simple_message;
 
+static const int HEALTH_CHECK_INTERVAL = 50; // ms
+
 FanucRelaySocket::FanucRelaySocket(QObject *parent):
-    QObject(parent)
+    QObject(parent),
+    socket_(this),
+    health_timer_(this)
 {
     VLOG_CALL;
 
@@ -22,27 +25,161 @@ FanucRelaySocket::FanucRelaySocket(QObject *parent):
     connect(&socket_, SIGNAL(error(QAbstractSocket::SocketError)), SLOT(on_error(QAbstractSocket::SocketError)));
 #endif
 
-    start_connection();
+    health_timer_.setInterval(HEALTH_CHECK_INTERVAL);
+    connect(&health_timer_, &QTimer::timeout, this, &FanucRelaySocket::check_link);
+
+    handlers_.add<ping_t, &FanucRelaySocket::on_ping>();
+    handlers_.add<joint_position_t, &FanucRelaySocket::on_reply<joint_position_t>>();
+    handlers_.add<joint_traj_pt_t, &FanucRelaySocket::on_reply<joint_traj_pt_t>>();
+    handlers_.add<xyzwpr_traj_pt_t, &FanucRelaySocket::on_reply<xyzwpr_traj_pt_t>>();
+    handlers_.add<read_input_t, &FanucRelaySocket::on_read_input>();
+    handlers_.add<read_output_t, &FanucRelaySocket::on_read_output>();
+    handlers_.add<write_output_t, &FanucRelaySocket::on_write_output>();
+    handlers_.add<output_pulse_t, &FanucRelaySocket::on_output_pulse>();
+
+    clock_.start();
+}
+
+void FanucRelaySocket::set_config(const fanuc_connection_config &config)
+{
+    bigendian_ = config.bigendian;
+    framer_.set_bigendian(bigendian_);
+    prefix1_ = config.prefix1;
+    prefix2_ = config.prefix2;
+    window_ = config.relay_window;
+    max_retries_ = config.relay_retries;
+    health_.set_timing(config.ping_interval / 1000., config.ping_timeout / 1000.);
+    ping_timeout_ = config.ping_timeout;
+}
+
+void FanucRelaySocket::abort()
+{
+    health_timer_.stop();
+    socket_.abort();
+}
+
+void FanucRelaySocket::set_capture(traffic_capture::writer *capture)
+{
+    capture_ = capture;
 }
 
 bool FanucRelaySocket::connected() const
 {
-    return socket_.state() == QAbstractSocket::ConnectedState;
+    return connected_;
+}
+
+void FanucRelaySocket::stats(BotSocket::SDiagnostics &diag) const
+{
+    stats_t stats;
+    stats_.load(stats);
+    diag.relayRoundTrip = stats.round_trip;
+    diag.relayPing = stats.ping;
+    diag.relayRtt = stats.rtt;
+}
+
+void FanucRelaySocket::reset_stats()
+{
+    round_trip_.reset();
+    ping_.reset();
+    publish_stats();
+}
+
+void FanucRelaySocket::publish_stats()
+{
+    stats_t stats;
+    stats.round_trip = round_trip_.stats();
+    stats.ping = ping_.stats();
+    stats.rtt = health_.rtt() < 0 ? -1 : health_.rtt() * 1000;
+    stats_.store(stats);
+}
+
+double FanucRelaySocket::now() const
+{
+    return clock_.nsecsElapsed() * 1e-9;
+}
+
+// returns the round trip, ms
+double FanucRelaySocket::add_round_trip(qint64 sent_ns)
+{
+    const double ms = (clock_.nsecsElapsed() - sent_ns) * 1e-6;
+    round_trip_.add(ms);
+    publish_stats();
+    return ms;
 }
 
 void FanucRelaySocket::on_connected()
 {
     VLOG_CALL;
+    framer_.reset();
+    health_.reset(now());
+    if(health_.enabled())
+        health_timer_.start();
+    connected_ = true;
     emit connection_state_changed(true);
 }
 
 void FanucRelaySocket::on_disconnected()
 {
     VLOG_CALL;
-    QTimer::singleShot(1000, this, &FanucRelaySocket::start_connection);
+    health_timer_.stop();
+    connected_ = false;
     emit connection_state_changed(false);
 }
 
+void FanucRelaySocket::check_link()
+{
+    const double time = now();
+
+    // the relay holds the reply to a point until the motion queue has room, so a
+    // busy relay can be silent for as long as the robot moves; the state channel
+    // watches the link meanwhile
+    if(path_next_ > path_base_ || pulses_.pending() || stop_pending_)
+    {
+        health_.on_traffic(time);
+        return;
+    }
+
+    // a relay program that never answered PING gives no sign of life while idle,
+    // so the timeout only applies once it has answered one
+    if(health_.rtt() >= 0 && !health_.alive(time))
+    {
+        LOG_F(ERROR, "No reply in %d ms, dropping the connection", ping_timeout_);
+        health_timer_.stop();
+        socket_.abort();
+        if(connected_)
+        {
+            connected_ = false;
+            emit connection_state_changed(false);
+        }
+        return;
+    }
+
+    if(health_.ping_due(time))
+        send_ping();
+}
+
+void FanucRelaySocket::send_ping()
+{
+    if(socket_.state() != QAbstractSocket::ConnectedState)
+        return;
+
+    ping_t msg;
+    msg.header.comm_type = COMM_TYPE_SERVICE_REQUEST;
+    send_frame(encode(msg, bigendian_, send_buffer_, sizeof(send_buffer_)));
+    health_.on_ping_sent(now());
+}
+
+void FanucRelaySocket::on_ping(const ping_t &msg)
+{
+    // even a failure reply proves the controller is there
+    const double rtt = health_.on_ping_reply(now());
+    if(rtt < 0)
+        return;
+    LOG_F(5, "PING reply %d, %.3f ms", msg.header.reply_code, rtt * 1000);
+    ping_.add(rtt * 1000);
+    publish_stats();
+}
+
 void FanucRelaySocket::disconnectFromHost()
 {
     VLOG_CALL;
@@ -54,244 +191,269 @@ void FanucRelaySocket::on_error(QAbstractSocket::SocketError error)
     VLOG_CALL;
     LOG_F(ERROR, "%d (%s)", error, socket_.errorString().toLocal8Bit().data());
     socket_.disconnectFromHost();
-    QTimer::singleShot(1000, this, &FanucRelaySocket::start_connection);
+    connected_ = false;
     emit connection_state_changed(false);
 }
 
-// works with both floats and ints
-template <typename T>
-T bswap(T val) {
-    T retVal;
-    char *pVal = (char*) &val;
-    char *pRetVal = (char*)&retVal;
-    int size = sizeof(T);
-    for(int i=0; i<size; i++) {
-        pRetVal[size-1-i] = pVal[i];
-    }
-
-    return retVal;
-}
-
-static void bswap(QByteArray &array)
+void FanucRelaySocket::on_readyread()
 {
-    for(int i=0; i<(array.size()/4)*4; i+=4)
+    VLOG_CALL;
+
+    while(socket_.bytesAvailable() > 0)
     {
-        char tmp0 = array[i+0], tmp1 = array[i+1];
-        array[i+0] = array[i+3];
-        array[i+1] = array[i+2];
-        array[i+2] = tmp1;
-        array[i+3] = tmp0;
+        qint64 size = socket_.read(framer_.write_ptr(), static_cast<qint64>(framer_.write_size()));
+        if(size <= 0)
+            break;
+        framer_.commit(static_cast<size_t>(size));
+
+        size_t packet_size = 0;
+        while(const char *packet = framer_.next_frame(packet_size))
+        {
+            if(capture_)
+                capture_->record(traffic_capture::CHANNEL_RELAY, traffic_capture::DIRECTION_RX, packet, packet_size);
+            process_packet(packet_view(packet, packet_size, bigendian_));
+        }
     }
 }
 
-static bool get_prefix_header(QByteArray &packet, struct prefix_t **prefix, struct header_t **header)
+void FanucRelaySocket::process_packet(const packet_view &packet)
 {
-    if(static_cast<size_t>(packet.size()) < sizeof(prefix_t) + sizeof(header_t))
-        return false;
+    if(!packet.valid())
+        return;
 
-    char *data = packet.data();
-    *prefix = reinterpret_cast<prefix_t*>(data);
-    *header = reinterpret_cast<header_t*>(data + sizeof(prefix_t));
+    health_.on_traffic(now());
 
-    return true;
-}
+    const header_t &header = packet.header();
+    if(header.comm_type == COMM_TYPE_SERVICE_REQUEST)
+    {
+        LOG_F(ERROR, "Service request received, no support");
+        size_t size = encode_reply(packet, REPLY_CODE_FAILURE, send_buffer_, sizeof(send_buffer_));
+        if(size != 0)
+            send_frame(size);
+        return;
+    }
 
-void FanucRelaySocket::on_readyread()
-{
-    VLOG_CALL;
+    if(header.comm_type == COMM_TYPE_TOPIC)
+    {
+        LOG_F(WARNING, "Topic received, ignoring");
+        return;
+    }
 
-    struct prefix_t *prefix = nullptr;
-    struct header_t *header = nullptr;
-    while(socket_.bytesAvailable() != 0)
+    if(header.comm_type != COMM_TYPE_SERVICE_REPLY)
     {
-        QByteArray packet = socket_.readAll();
+        LOG_F(ERROR, "Unknown comm_type %d", header.comm_type);
+        return;
+    }
 
-        if(!get_prefix_header(packet, &prefix, &header))
-            continue;
+    handler_table<FanucRelaySocket>::result_t result = handlers_.dispatch(*this, packet);
+    if(result == handler_table<FanucRelaySocket>::BAD_LENGTH)
+        LOG_F(ERROR, "Received msg=%d, but length %d is not valid", header.msg_type, packet.prefix().length);
+    else if(result == handler_table<FanucRelaySocket>::UNKNOWN_TYPE)
+        LOG_F(INFO, "Received l=%d msg=%d comm=%d reply=%d", packet.prefix().length, header.msg_type, header.comm_type, header.reply_code);
+}
 
-        if(bigendian_)
-            bswap(packet);
+template <typename Msg>
+void FanucRelaySocket::on_reply(const Msg &msg)
+{
+    process_reply(msg.header, msg.sequence);
+}
 
-        if(header->comm_type == COMM_TYPE_SERVICE_REQUEST)
+void FanucRelaySocket::process_reply(const header_t &header, int_t sequence_id)
+{
+    if(sequence_id < 0)
+    {
+        if(sequence_id == STOP_TRAJECTORY && stop_pending_)
         {
-            LOG_F(ERROR, "Service request received, no support");
-            header->comm_type = COMM_TYPE_SERVICE_REPLY;
-            header->reply_code = REPLY_CODE_FAILURE;
-            if(bigendian_)
-                bswap(packet);
-            socket_.write(packet);
-            continue;
+            stop_pending_ = false;
+            add_round_trip(stop_sent_ns_);
+            if(header.reply_code == REPLY_CODE_SUCCESS)
+                LOG_F(INFO, "Stop trajectory completed");
+            else
+                LOG_F(ERROR, "Stop trajectory failed");
         }
-
-        if(header->comm_type == COMM_TYPE_TOPIC)
+        else
         {
-            LOG_F(WARNING, "Topic received, ignoring");
-            continue;
+            LOG_F(WARNING, "Unexpected sequence_id %d", sequence_id);
         }
+        return;
+    }
 
-        if(header->comm_type != COMM_TYPE_SERVICE_REPLY)
-        {
-            LOG_F(ERROR, "Unknown comm_type %d", header->comm_type);
-            continue;
-        }
+    if(sequence_id < path_base_ || sequence_id >= path_next_ ||
+       path_state_[sequence_id] != POINT_SENT)
+    {
+        LOG_F(WARNING, "Unexpected sequence_id %d, in flight [%d, %d)", sequence_id, path_base_, path_next_);
+        return;
+    }
 
-        simple_message::int_t sequence_id = 0;
-        switch(header->msg_type)
-        {
-            case MSG_TYPE_JOINT_POSITION: {
-                if(prefix->length+sizeof(prefix_t) != sizeof(joint_position_t)) {
-                    LOG_F(ERROR, "Received joint position, but length is not valid");
-                    continue;
-                }
-                struct joint_position_t *msg = reinterpret_cast<struct joint_position_t *>(packet.data());
-                sequence_id = msg->sequence;
-
-                break;
-            };
-            case MSG_TYPE_JOINT_TRAJ_PT: {
-                if(prefix->length+sizeof(prefix_t) != sizeof(joint_traj_pt_t)) {
-                    LOG_F(ERROR, "Received joint traj pt, but length is not valid");
-                    continue;
-                }
-                struct joint_traj_pt_t *msg = reinterpret_cast<struct joint_traj_pt_t *>(packet.data());
-                sequence_id = msg->sequence;
-
-                break;
-            };
-            case MSG_TYPE_XYZWPR_TRAJ_PT: {
-                if(prefix->length+sizeof(prefix_t) != sizeof(xyzwpr_traj_pt_t)) {
-                    LOG_F(ERROR, "Received xyzwpr_traj_pt_t, but length is not valid");
-                    continue;
-                }
-                struct xyzwpr_traj_pt_t *msg = reinterpret_cast<struct xyzwpr_traj_pt_t *>(packet.data());
-                sequence_id = msg->sequence;
-
-                break;
-            };
-            default:
-            {
-                LOG_F(INFO, "Received l=%d msg=%d comm=%d reply=%d", prefix->length, header->msg_type, header->comm_type, header->reply_code);
-                continue;
-            }
-        };
-
-        if(header->reply_code == REPLY_CODE_SUCCESS)
+    const double round_trip = add_round_trip(path_sent_ns_[sequence_id]);
+
+    if(header.reply_code == REPLY_CODE_SUCCESS)
+    {
+        LOG_F(INFO, "Trajectory point enqueued %d, %.3f ms", sequence_id, round_trip);
+        path_state_[sequence_id] = POINT_ACKED;
+
+        // points are reported in order, even if replies come out of order
+        while(path_base_ < path_next_ && path_state_[path_base_] == POINT_ACKED)
         {
-            if(sequence_id < 0)
-            {
-                if(sequence_id == STOP_TRAJECTORY && sequence_id == path_idx_)
-                {
-                    LOG_F(INFO, "Stop trajectory completed");
-                }
-                else
-                {
-                    LOG_F(WARNING, "Unexpected sequence_id %d", sequence_id);
-                }
-                continue;
-            }
-
-            if(sequence_id != path_idx_)
-            {
-                LOG_F(WARNING, "Unexpected sequence_id %d, expected %d", sequence_id, path_idx_);
-                continue;
-            }
-
-            LOG_F(INFO, "Trajectory point enqueued %d", path_idx_);
-
-            size_t path_idx_u = path_idx_;
-            if(path_idx_u < path_joint_.size())
-            {
-                emit trajectory_joint_point_enqueued(path_joint_[path_idx_], path_idx_);
-
-                path_idx_++;
-                path_idx_u++;
-                if(path_idx_u < path_joint_.size())
-                {
-                    move_point(path_joint_[path_idx_], path_idx_);
-                }
-                else
-                {
-                    emit trajectory_enqueue_finished();
-                }
-            }
-            else if(path_idx_u < path_xyzwpr_.size())
-            {
-                emit trajectory_xyzwpr_point_enqueued(path_xyzwpr_[path_idx_], path_idx_);
-
-                path_idx_++;
-                path_idx_u++;
-                if(path_idx_u < path_xyzwpr_.size())
-                {
-                    move_point(path_xyzwpr_[path_idx_], path_idx_);
-                }
-                else
-                {
-                    emit trajectory_enqueue_finished();
-                }
-            }
+            if(!path_joint_.empty())
+                emit trajectory_joint_point_enqueued(path_joint_[path_base_], path_base_);
             else
-            {
-                LOG_F(ERROR, "Failure: unknown path_idx %d", path_idx_);
-            }
+                emit trajectory_xyzwpr_point_enqueued(path_xyzwpr_[path_base_], path_base_);
+            path_base_++;
         }
-        else if(header->reply_code == REPLY_CODE_FAILURE)
-        {
-            if(sequence_id < 0 && sequence_id == path_idx_)
-            {
-                if(sequence_id == STOP_TRAJECTORY)
-                {
-                    LOG_F(ERROR, "Stop trajectory failed");
-                }
-                else
-                {
-                    LOG_F(ERROR, "Unexpected sequence_id %d", sequence_id);
-                }
-                continue;
-            }
-
-            LOG_F(ERROR, "Trajectory point enqueue fail, stopping %d", path_idx_);
-
-            size_t path_idx_u = path_idx_;
-            if(path_idx_u < path_joint_.size())
-            {
-                emit trajectory_joint_point_enqueue_fail(path_joint_[path_idx_], path_idx_);
-            }
-            else if(path_idx_u < path_xyzwpr_.size())
-            {
-                emit trajectory_xyzwpr_point_enqueue_fail(path_xyzwpr_[path_idx_], path_idx_);
-            }
-            else
-            {
-                LOG_F(ERROR, "Failure: unknown path_idx %d", path_idx_);
-            }
 
-            stop();
+        if(path_finished())
+        {
+            emit trajectory_enqueue_finished();
+            return;
         }
-        else
+
+        fill_window();
+    }
+    else if(header.reply_code == REPLY_CODE_FAILURE)
+    {
+        // retransmission keeps the order only if nothing was sent after the failed point
+        if(path_retries_[sequence_id] < max_retries_ && sequence_id == path_next_ - 1)
         {
-            LOG_F(WARNING, "Unexpected reply_code %d", header->reply_code);
-            continue;
+            path_retries_[sequence_id]++;
+            LOG_F(WARNING, "Trajectory point enqueue fail, retry %d of %d for %d",
+                  path_retries_[sequence_id], max_retries_, sequence_id);
+            if(!send_point(sequence_id))
+                reset_path();
+            return;
         }
+
+        LOG_F(ERROR, "Trajectory point enqueue fail, stopping %d", sequence_id);
+        fail_point(sequence_id);
+        stop();
+    }
+    else
+    {
+        LOG_F(WARNING, "Unexpected reply_code %d", header.reply_code);
     }
 }
 
-void FanucRelaySocket::start_connection()
+void FanucRelaySocket::fail_point(int sequence_number)
+{
+    if(!path_joint_.empty())
+        emit trajectory_joint_point_enqueue_fail(path_joint_[sequence_number], sequence_number);
+    else
+        emit trajectory_xyzwpr_point_enqueue_fail(path_xyzwpr_[sequence_number], sequence_number);
+}
+
+void FanucRelaySocket::on_output_pulse(const output_pulse_t &msg)
+{
+    switch(pulses_.on_reply(msg.sequence))
+    {
+    case PulseReplyTracker::REPLY_UNEXPECTED:
+        LOG_F(WARNING, "Unexpected output pulse reply for %d", msg.sequence);
+        return;
+    case PulseReplyTracker::REPLY_STALE:
+        LOG_F(WARNING, "Output pulse reply %d for %d before its retry, dropped", msg.header.reply_code, msg.sequence);
+        if(path_finished())
+            emit trajectory_enqueue_finished();
+        return;
+    case PulseReplyTracker::REPLY_CURRENT:
+        break;
+    }
+    if(msg.header.reply_code == REPLY_CODE_SUCCESS)
+    {
+        LOG_F(INFO, "Output pulse DO[%d] %.3f s enqueued at %d", msg.index, msg.duration, msg.sequence);
+        // the last point may have been acknowledged before its pulse
+        if(path_finished())
+            emit trajectory_enqueue_finished();
+        return;
+    }
+
+    // the path must not run on without its dwell
+    LOG_F(ERROR, "Output pulse DO[%d] enqueue fail, stopping %d", msg.index, msg.sequence);
+    fail_point(msg.sequence);
+    stop();
+}
+
+void FanucRelaySocket::on_read_input(const read_input_t &msg)
+{
+    if(msg.header.reply_code != REPLY_CODE_SUCCESS)
+    {
+        LOG_F(ERROR, "Read DI[%d] failed", msg.index);
+        emit io_fail(msg.index);
+        return;
+    }
+    emit input_read(msg.index, msg.value != 0);
+}
+
+void FanucRelaySocket::on_read_output(const read_output_t &msg)
+{
+    if(msg.header.reply_code != REPLY_CODE_SUCCESS)
+    {
+        LOG_F(ERROR, "Read DO[%d] failed", msg.index);
+        emit io_fail(msg.index);
+        return;
+    }
+    emit output_read(msg.index, msg.value != 0);
+}
+
+void FanucRelaySocket::on_write_output(const write_output_t &msg)
+{
+    if(msg.header.reply_code != REPLY_CODE_SUCCESS)
+    {
+        LOG_F(ERROR, "Write DO[%d] failed", msg.index);
+        emit io_fail(msg.index);
+        return;
+    }
+    LOG_F(INFO, "DO[%d] = %d", msg.index, msg.value);
+    emit output_written(msg.index, msg.value != 0);
+}
+
+template <typename Msg>
+void FanucRelaySocket::send_io(int index, int value)
+{
+    if(socket_.state() != QAbstractSocket::ConnectedState)
+    {
+        emit io_fail(index);
+        return;
+    }
+    Msg msg;
+    msg.header.comm_type = COMM_TYPE_SERVICE_REQUEST;
+    msg.index = index;
+    msg.value = value;
+    send_frame(encode(msg, bigendian_, send_buffer_, sizeof(send_buffer_)));
+}
+
+void FanucRelaySocket::read_input(int index)
+{
+    send_io<read_input_t>(index, 0);
+}
+
+void FanucRelaySocket::read_output(int index)
+{
+    send_io<read_output_t>(index, 0);
+}
+
+void FanucRelaySocket::write_output(int index, bool value)
+{
+    send_io<write_output_t>(index, value ? 1 : 0);
+}
+
+void FanucRelaySocket::send_frame(size_t size)
+{
+    if(capture_)
+        capture_->record(traffic_capture::CHANNEL_RELAY, traffic_capture::DIRECTION_TX, send_buffer_, size);
+    socket_.write(send_buffer_, static_cast<qint64>(size));
+}
+
+void FanucRelaySocket::connect_to_host(const fanuc_connection_config &config)
 {
     VLOG_CALL;
     if(socket_.state() != QAbstractSocket::ConnectingState &&
        socket_.state() != QAbstractSocket::ConnectedState)
     {
-        QSettings settings("fanuc.ini", QSettings::IniFormat);
-
-        bigendian_ = settings.value("bigendian", false).toBool();
-        QString host = settings.value("server_ip", "127.0.0.1").toString();
-        int port = settings.value("server_relay_port", 11000).toInt();
-        prefix1_ = settings.value("prefix1", prefix1_).toInt();
-        prefix2_ = settings.value("prefix2", prefix2_).toInt();
-        LOG_F(INFO, "Connecting to %s:%d", host.toLocal8Bit().data(), port);
+        set_config(config);
+        LOG_F(INFO, "Connecting to %s:%d", config.host.toLocal8Bit().data(), config.relay_port);
         LOG_F(INFO, "Bigendian: %d, prefix1: %d, prefix2: %d", bigendian_, prefix1_, prefix2_);
+        LOG_F(INFO, "Window: %d, retries: %d", window_, max_retries_);
 
-        socket_.connectToHost(host, port);
+        socket_.connectToHost(config.host, config.relay_port);
     }
 }
 
@@ -301,16 +463,10 @@ bool FanucRelaySocket::send_cmd(struct simple_message::joint_traj_pt_t &cmd)
     {
         return false;
     }
-    path_idx_ = cmd.sequence;
-    cmd.header.msg_type = MSG_TYPE_JOINT_TRAJ_PT;
     cmd.header.comm_type = COMM_TYPE_SERVICE_REQUEST;
-    cmd.prefix.length = sizeof(joint_traj_pt_t) - sizeof(prefix_t);
-
-    QByteArray packet(reinterpret_cast<const char*>(&cmd), sizeof(cmd));
-    if(bigendian_)
-        bswap(packet);
 
-    socket_.write(packet);
+    size_t size = encode(cmd, bigendian_, send_buffer_, sizeof(send_buffer_));
+    send_frame(size);
 
     return true;
 }
@@ -321,44 +477,131 @@ bool FanucRelaySocket::send_cmd(struct simple_message::xyzwpr_traj_pt_t &cmd)
     {
         return false;
     }
-    path_idx_ = cmd.sequence;
-    cmd.header.msg_type = MSG_TYPE_XYZWPR_TRAJ_PT;
     cmd.header.comm_type = COMM_TYPE_SERVICE_REQUEST;
-    cmd.prefix.length = sizeof(xyzwpr_traj_pt_t) - sizeof(prefix_t);
-
-    QByteArray packet(reinterpret_cast<const char*>(&cmd), sizeof(cmd));
-    if(bigendian_)
-        bswap(packet);
 
-    socket_.write(packet);
+    size_t size = encode(cmd, bigendian_, send_buffer_, sizeof(send_buffer_));
+    send_frame(size);
     return true;
 }
 
 void FanucRelaySocket::stop()
 {
     VLOG_CALL;
-    path_xyzwpr_.clear();
-    path_joint_.clear();
+    reset_path();
     struct joint_traj_pt_t cmd;
     cmd.sequence = STOP_TRAJECTORY;
-    send_cmd(cmd);
+    stop_sent_ns_ = clock_.nsecsElapsed();
+    stop_pending_ = send_cmd(cmd);
+}
+
+void FanucRelaySocket::reset_path()
+{
+    path_xyzwpr_.clear();
+    path_joint_.clear();
+    path_pulses_.clear();
+    path_state_.clear();
+    pulses_.reset(0);
+    path_retries_.clear();
+    path_sent_ns_.clear();
+    path_base_ = path_next_ = 0;
+}
+
+size_t FanucRelaySocket::path_size() const
+{
+    return !path_joint_.empty() ? path_joint_.size() : path_xyzwpr_.size();
+}
+
+// every point and every pulse acknowledged
+bool FanucRelaySocket::path_finished() const
+{
+    return static_cast<size_t>(path_base_) == path_size() && !pulses_.pending();
+}
+
+void FanucRelaySocket::start_path()
+{
+    path_state_.assign(path_size(), POINT_QUEUED);
+    pulses_.reset(path_size());
+    path_retries_.assign(path_size(), 0);
+    path_sent_ns_.assign(path_size(), 0);
+    path_base_ = path_next_ = 0;
+
+    if(path_size() == 0)
+    {
+        emit trajectory_enqueue_finished();
+        return;
+    }
+
+    fill_window();
+}
+
+void FanucRelaySocket::fill_window()
+{
+    while(static_cast<size_t>(path_next_) < path_size() && path_next_ - path_base_ < window_)
+    {
+        if(!send_point(path_next_))
+        {
+            reset_path();
+            return;
+        }
+        path_state_[path_next_] = POINT_SENT;
+        path_next_++;
+    }
+}
+
+bool FanucRelaySocket::send_point(int sequence_number)
+{
+    path_sent_ns_[sequence_number] = clock_.nsecsElapsed();
+    const bool sent = !path_joint_.empty() ? move_point(path_joint_[sequence_number], sequence_number)
+                                           : move_point(path_xyzwpr_[sequence_number], sequence_number);
+    // before the next point, so the relay queues them in order
+    return sent && send_pulses(sequence_number);
+}
+
+bool FanucRelaySocket::send_pulses(int sequence_number)
+{
+    auto it = std::lower_bound(path_pulses_.begin(), path_pulses_.end(), sequence_number,
+                               [](const io_pulse_data &pulse, int sequence) { return pulse.sequence < sequence; });
+    // a retried point sends its pulses again
+    pulses_.on_point_sent(sequence_number);
+    for(; it != path_pulses_.end() && it->sequence == sequence_number; ++it)
+    {
+        if(socket_.state() != QAbstractSocket::ConnectedState)
+        {
+            fail_point(sequence_number);
+            return false;
+        }
+        output_pulse_t cmd;
+        cmd.header.comm_type = COMM_TYPE_SERVICE_REQUEST;
+        cmd.sequence = sequence_number;
+        cmd.index = it->output;
+        cmd.duration = static_cast<real_t>(it->duration);
+        LOG_F(INFO, "OUTPUT PULSE: i=%d DO[%d] %.3f s", cmd.sequence, cmd.index, it->duration);
+        send_frame(encode(cmd, bigendian_, send_buffer_, sizeof(send_buffer_)));
+        pulses_.on_pulse_sent(sequence_number);
+    }
+    return true;
 }
 
 void FanucRelaySocket::move_point(const joint_data &pos)
 {
-    path_joint_ = {pos};
-    move_trajectory(path_joint_);
+    move_trajectory(std::vector<joint_data>{pos});
 }
 
 void FanucRelaySocket::move_trajectory(const std::vector<joint_data> &path)
+{
+    move_trajectory(path, std::vector<io_pulse_data>());
+}
+
+void FanucRelaySocket::move_trajectory(const std::vector<joint_data> &path, const std::vector<io_pulse_data> &pulses)
 {
     VLOG_CALL;
     path_xyzwpr_.clear();
     path_joint_ = path;
-    move_point(path_joint_[0], 0);
+    path_pulses_ = pulses;
+    start_path();
 }
 
-void FanucRelaySocket::move_point(const joint_data &pos, int sequence_number)
+bool FanucRelaySocket::move_point(const joint_data &pos, int sequence_number)
 {
     VLOG_CALL;
     struct joint_traj_pt_t cmd;
@@ -368,33 +611,37 @@ void FanucRelaySocket::move_point(const joint_data &pos, int sequence_number)
     LOG_F(INFO, "JOINT TRAJ PT: i=%d J1=%f J2=%f J3=%f J4=%f J5=%f J6=%f", cmd.sequence, pos[0], pos[1], pos[2],
                                                                                          pos[3], pos[4], pos[5]);
     if(!send_cmd(cmd))
+    {
         emit trajectory_joint_point_enqueue_fail(pos, sequence_number);
+        return false;
+    }
+    return true;
 }
 
 void FanucRelaySocket::move_point(const xyzwpr_data &pos)
 {
-    path_xyzwpr_ = {pos};
-    move_trajectory(path_xyzwpr_);
+    move_trajectory(std::vector<xyzwpr_data>{pos});
 }
 
 void FanucRelaySocket::move_trajectory(const std::vector<xyzwpr_data> &path)
+{
+    move_trajectory(path, std::vector<io_pulse_data>());
+}
+
+void FanucRelaySocket::move_trajectory(const std::vector<xyzwpr_data> &path, const std::vector<io_pulse_data> &pulses)
 {
     VLOG_CALL;
     path_joint_.clear();
     path_xyzwpr_ = path;
-    move_point(path_xyzwpr_[0], 0);
+    path_pulses_ = pulses;
+    start_path();
 }
 
-void FanucRelaySocket::move_point(const xyzwpr_data &pos, int sequence_number)
+bool FanucRelaySocket::move_point(const xyzwpr_data &pos, int sequence_number)
 {
     struct xyzwpr_traj_pt_t cmd;
     cmd.sequence = sequence_number;
     cmd.xyz_data.config = fanuc_config_make(pos);
-    if(bigendian_)
-    {
-        // config is not byte-swapped
-        cmd.xyz_data.config = bswap(cmd.xyz_data.config);
-    }
     for(int i=0; i<6; i++)
         cmd.xyz_data.xyzwpr[i] = pos.xyzwpr[i];
     cmd.xyz_data.prefix1 = prefix1_;
@@ -402,5 +649,9 @@ void FanucRelaySocket::move_point(const xyzwpr_data &pos, int sequence_number)
     LOG_F(INFO, "XYZWPR TRAJ PT: i=%d X=%f Y=%f Z=%f W=%f P=%f R=%f", cmd.sequence, pos.xyzwpr[0], pos.xyzwpr[1], pos.xyzwpr[2],
                                                                                     pos.xyzwpr[3], pos.xyzwpr[4], pos.xyzwpr[5]);
     if(!send_cmd(cmd))
+    {
         emit trajectory_xyzwpr_point_enqueue_fail(pos, sequence_number);
+        return false;
+    }
+    return true;
 }
@@ -1,9 +1,19 @@
 #pragma once
 
 #include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <atomic>
 #include <QtNetwork/QTcpSocket>
-#include "simple_message.h"
+#include "simple_message_dispatch.h"
+#include "simple_message_framer.h"
+#include "traffic_capture.h"
+#include "fanuc_connection_manager.h"
 #include "fanuc_socket_types.h"
+#include "latency_histogram.h"
+#include "link_health.h"
+#include "pulse_reply_tracker.h"
+#include "seqlock.h"
 
 class FanucRelaySocket : public QObject
 {
@@ -11,13 +21,30 @@ class FanucRelaySocket : public QObject
 public:
     explicit FanucRelaySocket(QObject *parent = nullptr);
 
+    // records traffic into capture, call before start()
+    void set_capture(traffic_capture::writer *capture);
+
+    // thread safe
     bool connected() const;
+    void stats(BotSocket::SDiagnostics &diag) const; // fills relay* fields
+
+    // connection is driven by FanucConnectionManager
+    void set_config(const fanuc_connection_config &config);
+    void connect_to_host(const fanuc_connection_config &config);
+    void abort();
 
 public slots:
+    void reset_stats();
     void move_point(const xyzwpr_data &pos);
     void move_trajectory(const std::vector<xyzwpr_data> &path);
     void move_point(const joint_data &pos);
     void move_trajectory(const std::vector<joint_data> &path);
+    // pulses in the order of their points, each is sent right after its point
+    void move_trajectory(const std::vector<xyzwpr_data> &path, const std::vector<io_pulse_data> &pulses);
+    void move_trajectory(const std::vector<joint_data> &path, const std::vector<io_pulse_data> &pulses);
+    void read_input(int index);
+    void read_output(int index);
+    void write_output(int index, bool value);
     void stop();
     void disconnectFromHost();
 
@@ -28,25 +55,87 @@ signals:
     void trajectory_joint_point_enqueue_fail(const joint_data &pos, int sequence_number);
     void trajectory_enqueue_finished();
     void connection_state_changed(bool connected);
+    void input_read(int index, bool value);
+    void output_read(int index, bool value);
+    void output_written(int index, bool value);
+    void io_fail(int index);
 
 private slots:
     void on_readyread();
     void on_connected();
     void on_disconnected();
     void on_error(QAbstractSocket::SocketError error);
+    void check_link();
 
-    void move_point(const joint_data &pos, int sequence_number);
-    void move_point(const xyzwpr_data &pos, int sequence_number);
+    bool move_point(const joint_data &pos, int sequence_number);
+    bool move_point(const xyzwpr_data &pos, int sequence_number);
 
 private:
-    void start_connection();
+    enum point_state_t {
+        POINT_QUEUED,
+        POINT_SENT,
+        POINT_ACKED
+    };
+
+    void send_frame(size_t size);
+    void process_packet(const simple_message::packet_view &packet);
+    template <typename Msg>
+    void on_reply(const Msg &msg);
+    void on_ping(const simple_message::ping_t &msg);
+    void on_read_input(const simple_message::read_input_t &msg);
+    void on_read_output(const simple_message::read_output_t &msg);
+    void on_write_output(const simple_message::write_output_t &msg);
+    void on_output_pulse(const simple_message::output_pulse_t &msg);
+    template <typename Msg>
+    void send_io(int index, int value);
+    void fail_point(int sequence_number);
+    void send_ping();
+    void process_reply(const simple_message::header_t &header, simple_message::int_t sequence_id);
+    size_t path_size() const;
+    bool path_finished() const;
+    void start_path();
+    void reset_path();
+    void fill_window();
+    bool send_point(int sequence_number);
+    bool send_pulses(int sequence_number);
     bool send_cmd(struct simple_message::joint_traj_pt_t &cmd);
     bool send_cmd(struct simple_message::xyzwpr_traj_pt_t &cmd);
+    double add_round_trip(qint64 sent_ns);
+    void publish_stats();
+    double now() const; // s
 
     QTcpSocket socket_;
+    std::atomic<bool> connected_{false};
+    SimpleMessageFramer framer_;
+    traffic_capture::writer *capture_ = nullptr;
+    simple_message::handler_table<FanucRelaySocket> handlers_;
+    char send_buffer_[SimpleMessageFramer::MAX_FRAME_SIZE];
     bool bigendian_ = false;
     std::vector<joint_data> path_joint_;
     std::vector<xyzwpr_data> path_xyzwpr_;
-    simple_message::int_t path_idx_;
+    std::vector<io_pulse_data> path_pulses_;
+    std::vector<point_state_t> path_state_;
+    PulseReplyTracker pulses_;
+    std::vector<int> path_retries_;
+    std::vector<qint64> path_sent_ns_;     // clock_ time of the last send of each point
+    simple_message::int_t path_base_ = 0;   // first not acknowledged sequence
+    simple_message::int_t path_next_ = 0;   // next sequence to send
+    simple_message::int_t window_ = 1;      // max sequences in flight
+    int max_retries_ = 0;
+    bool stop_pending_ = false;
     simple_message::int_t prefix1_ = 0, prefix2_ = 0;
+
+    struct stats_t {
+        BotSocket::SLatencyStats round_trip, ping;
+        double rtt = -1;    // ms
+    };
+
+    QElapsedTimer clock_;
+    qint64 stop_sent_ns_ = 0;
+    LatencyHistogram round_trip_, ping_;
+    SeqLock<stats_t> stats_;
+
+    LinkHealth health_;
+    int ping_timeout_ = 0;  // ms
+    QTimer health_timer_;
 };
@@ -0,0 +1,202 @@
+#include "fanuc_robot_config.h"
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QStringList>
+#include <algorithm>
+#include "tool_spin_planner.h"
+#include "../log/loguru.hpp"
+
+static const size_t SPIN_CHUNK_SIZE = 64;   // candidates solved by one parallel job
+
+static joint_data joint_list(const QSettings &settings, const QString &key, const joint_data &default_value)
+{
+    const QList<QVariant> list = settings.value(key).toList();
+    if (list.size() < 6)
+        return default_value;
+    joint_data result;
+    for (int i = 0; i < 6; ++i)
+        result[i] = list[i].toDouble();
+    return result;
+}
+
+static bool load_transform(const QSettings &settings, const QString &key, gp_Trsf &result)
+{
+    const QList<QVariant> list = settings.value(key).toList();
+    if (list.size() < 12)
+        return false;
+    double v[12];
+    for (int i = 0; i < 12; ++i)
+        v[i] = list[i].toDouble();
+    result.SetValues(v[0], v[1], v[2], v[3],
+                     v[4], v[5], v[6], v[7],
+                     v[8], v[9], v[10], v[11]);
+    return true;
+}
+
+// lengths in mm and angles in degrees as in OpwKinematics
+static OpwKinematics::parameters_t load_kinematics(QSettings &settings)
+{
+    OpwKinematics::parameters_t p;
+    settings.beginGroup("kinematics");
+    p.a1 = settings.value("a1", p.a1).toDouble();
+    p.a2 = settings.value("a2", p.a2).toDouble();
+    p.b  = settings.value("b",  p.b ).toDouble();
+    p.c1 = settings.value("c1", p.c1).toDouble();
+    p.c2 = settings.value("c2", p.c2).toDouble();
+    p.c3 = settings.value("c3", p.c3).toDouble();
+    p.c4 = settings.value("c4", p.c4).toDouble();
+    p.offsets = joint_list(settings, "offsets", p.offsets);
+    p.signs = joint_list(settings, "signs", p.signs);
+    p.j23_factor = settings.value("j23_factor", p.j23_factor).toDouble();
+    p.joint_min = joint_list(settings, "joint_min", p.joint_min);
+    p.joint_max = joint_list(settings, "joint_max", p.joint_max);
+    p.tool.xyzwpr = joint_list(settings, "tool", p.tool.xyzwpr);
+    p.wrist_margin = settings.value("wrist_margin", p.wrist_margin).toDouble();
+    p.elbow_margin = settings.value("elbow_margin", p.elbow_margin).toDouble();
+    p.shoulder_margin = settings.value("shoulder_margin", p.shoulder_margin).toDouble();
+    settings.endGroup();
+    return p;
+}
+
+// speeds and accelerations in the units of CycleTimeModel, times in ms
+static CycleTimeModel::config_t load_motion(QSettings &settings)
+{
+    CycleTimeModel::config_t model;
+    settings.beginGroup("sim");
+    model.linear_speed = settings.value("linear_speed", model.linear_speed).toDouble();
+    model.linear_accel = settings.value("linear_accel", model.linear_accel).toDouble();
+    model.angular_speed = settings.value("angular_speed", model.angular_speed).toDouble();
+    model.angular_accel = settings.value("angular_accel", model.angular_accel).toDouble();
+    model.joint_speed = joint_list(settings, "joint_speed", model.joint_speed);
+    model.joint_accel = joint_list(settings, "joint_accel", model.joint_accel);
+    model.settle_time = settings.value("settle_time", model.settle_time * 1000).toInt() / 1000.;
+    model.calib_time = settings.value("calib_time", model.calib_time * 1000).toInt() / 1000.;
+    settings.endGroup();
+    return model;
+}
+
+fanuc_robot_config fanuc_robot_config::load(const QString &file_name)
+{
+    QSettings settings(file_name, QSettings::IniFormat);
+    fanuc_robot_config config;
+    // both or none, they have to stay inverse of each other
+    gp_Trsf world2user, user2world;
+    if (load_transform(settings, "world2user", world2user) && load_transform(settings, "user2world", user2world))
+    {
+        config.world2user = world2user;
+        config.user2world = user2world;
+    }
+    config.flip = settings.value("flip", config.flip).toBool();
+    config.up = settings.value("up", config.up).toBool();
+    config.top = settings.value("top", config.top).toBool();
+    config.reach = settings.value("reach", config.reach).toDouble();
+    config.joint_moves = settings.value("joint_moves", config.joint_moves).toBool();
+    config.spin_steps = settings.value("spin_steps", config.spin_steps).toInt();
+    config.drill_output = qMax(0, settings.value("drill_output", config.drill_output).toInt());
+    config.mark_output = qMax(0, settings.value("mark_output", config.mark_output).toInt());
+    config.kinematics = load_kinematics(settings);
+    OpwKinematics kinematics;
+    kinematics.set_parameters(config.kinematics);
+    if (config.joint_moves && !kinematics.valid())
+    {
+        LOG_F(WARNING, "joint_moves needs the [kinematics] arm geometry, moving in XYZWPR");
+        config.joint_moves = false;
+    }
+    config.motion = load_motion(settings);
+    return config;
+}
+
+PoseBatch::transform_t fanuc_robot_config::batch_transform() const
+{
+    PoseBatch::transform_t result;
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 4; ++c)
+            result[r * 4 + c] = user2world.Value(r + 1, c + 1);
+    return result;
+}
+
+xyzwpr_data fanuc_robot_config::robot_pose(const PoseBatch &batch, size_t i) const
+{
+    xyzwpr_data pose = batch.pose(i);
+    pose.flip = flip;
+    pose.up = up;
+    pose.top = top;
+    return pose;
+}
+
+bool fanuc_robot_config::plan_path(const OpwKinematics &kinematics, const std::vector<xyzwpr_data> &poses,
+                                   const std::vector<bool> &symmetric, const xyzwpr_data *home,
+                                   const std::vector<bool> &home_before,
+                                   const joint_data *start_joints, const xyzwpr_data *start_pose,
+                                   path_plan_t &plan, const parallel_t &parallel) const
+{
+    QElapsedTimer timer;
+    timer.start();
+    plan.poses = poses;
+    plan.joints.clear();
+    plan.home_joints.clear();
+
+    // the controller solves XYZWPR poses itself
+    const bool turns = std::find(symmetric.begin(), symmetric.end(), true) != symmetric.end();
+    if (poses.empty() || (!joint_moves && (!turns || spin_steps < 2)))
+        return true;
+
+    // home moves are in the chain, so the turns and joints around them are chosen with them
+    std::vector<xyzwpr_data> chain;
+    std::vector<bool> chainSymmetric;
+    std::vector<size_t> taskIndex;      // in chain of every pose
+    chain.reserve(poses.size() * 2);
+    for (size_t i = 0; i < poses.size(); ++i)
+    {
+        if (home && home_before[i])
+        {
+            chain.push_back(*home);
+            chainSymmetric.push_back(false);
+        }
+        taskIndex.push_back(chain.size());
+        chain.push_back(poses[i]);
+        chainSymmetric.push_back(symmetric[i]);
+    }
+
+    ToolSpinPlanner planner;
+    planner.set_steps(spin_steps);
+    planner.set_kinematics(joint_moves ? &kinematics : nullptr);
+    planner.set_poses(chain, chainSymmetric);
+
+    const size_t candidates = planner.candidate_count();
+    const size_t chunks = (candidates + SPIN_CHUNK_SIZE - 1) / SPIN_CHUNK_SIZE;
+    auto solve = [&planner, candidates](size_t chunk) {
+        planner.solve(chunk * SPIN_CHUNK_SIZE, std::min(candidates, (chunk + 1) * SPIN_CHUNK_SIZE));
+    };
+    if (parallel)
+        parallel(chunks, solve);
+    else
+        for (size_t i = 0; i < chunks; ++i)
+            solve(i);
+
+    const ToolSpinPlanner::result_t result = joint_moves && start_joints ?
+        planner.plan(*start_joints) : planner.plan(start_pose ? *start_pose : chain.front());
+    if (result.failed != ToolSpinPlanner::npos)
+    {
+        const size_t task = static_cast<size_t>(std::lower_bound(taskIndex.begin(), taskIndex.end(), result.failed) -
+                                                taskIndex.begin());
+        LOG_F(ERROR, "%s point %zu: %s", taskIndex[task] == result.failed ? "Task" : "Home before task",
+              task, OpwKinematics::error_string(result.error));
+        return false;
+    }
+
+    size_t turned = 0;
+    for (size_t i = 0; i < poses.size(); ++i)
+    {
+        const size_t k = taskIndex[i];
+        plan.poses[i] = result.poses[k];
+        turned += result.spins[k] != 0;
+        if (!joint_moves)
+            continue;
+        plan.joints.push_back(result.joints[k]);
+        plan.home_joints.push_back(home && home_before[i] ? result.joints[k - 1] : joint_data{{0, 0, 0, 0, 0, 0}});
+    }
+    LOG_F(INFO, "Path of %zu points planned in %.3f ms, %zu turned about the tool axis",
+          poses.size(), timer.nsecsElapsed() / 1e6, turned);
+    return true;
+}
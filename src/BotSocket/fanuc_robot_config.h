@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QString>
+#include <functional>
+#include <vector>
+#include <gp_Trsf.hxx>
+#include "cycle_time_model.h"
+#include "fanuc_socket_types.h"
+#include "opw_kinematics.h"
+#include "pose_batch.h"
+
+// Robot placement and arm settings of fanuc.ini, shared by the real and the
+// simulated bot sockets and the task order optimizer so all of them convert
+// task points the same way
+struct fanuc_robot_config {
+    gp_Trsf world2user, user2world;
+    bool flip = false, up = true, top = true;    // configuration of XYZWPR poses
+    double reach = 0;                            // mm from the robot base, 0 - not checked
+    bool joint_moves = false;                    // joint trajectories instead of XYZWPR
+    int spin_steps = 24;                         // turns of zSimmetry points tried, < 2 - off
+    int drill_output = 0, mark_output = 0;       // DO pulsed for the task delay, 0 - waited out by the PC
+    OpwKinematics::parameters_t kinematics;      // [kinematics] group
+    CycleTimeModel::config_t motion;             // [sim] group, limits of the cycle time model
+
+    // runs job(0) .. job(count - 1), in any order
+    typedef std::function<void(size_t count, const std::function<void(size_t)> &job)> parallel_t;
+
+    // task points as the robot moves through them, see plan_path()
+    struct path_plan_t {
+        std::vector<xyzwpr_data> poses;     // symmetric points turned about the tool axis
+        std::vector<joint_data> joints;     // of poses, only with joint_moves
+        std::vector<joint_data> home_joints; // of the home move before each pose, where there is one
+    };
+
+    // joint_moves is turned off if the arm geometry is not valid
+    static fanuc_robot_config load(const QString &file_name);
+
+    // user2world as PoseBatch wants it
+    PoseBatch::transform_t batch_transform() const;
+
+    // first count points with globalPos, angle and normal, not converted yet
+    template <typename Point>
+    PoseBatch make_batch(const std::vector<Point> &points, size_t count) const {
+        PoseBatch batch;
+        batch.set_transform(batch_transform());
+        batch.set_reach(reach);
+        batch.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+            batch.add(points[i].globalPos, points[i].angle, points[i].normal);
+        return batch;
+    }
+
+    // converted pose with the configuration flags
+    xyzwpr_data robot_pose(const PoseBatch &batch, size_t i) const;
+
+    // Turns symmetric task points (ToolSpinPlanner) and, with joint_moves, solves
+    // their joints. home_before[i] puts a move to home right before poses[i], it is
+    // planned in the same chain. The chain starts where the robot stands; without
+    // start joints the first point takes any arm configuration, without a start
+    // pose it keeps its turn. parallel runs the inverse kinematics, serial if
+    // empty. false, logged, if a point has no solution.
+    bool plan_path(const OpwKinematics &kinematics, const std::vector<xyzwpr_data> &poses,
+                   const std::vector<bool> &symmetric, const xyzwpr_data *home,
+                   const std::vector<bool> &home_before,
+                   const joint_data *start_joints, const xyzwpr_data *start_pose,
+                   path_plan_t &plan, const parallel_t &parallel = parallel_t()) const;
+};
@@ -1,10 +1,13 @@
 #pragma once
 
-#include <QVector>
+#include <array>
+#include <stdint.h>
+#include <type_traits>
 
-typedef QVector<double> joint_data;
+// Fixed size poses, no heap allocation on the state path
+typedef std::array<double, 6> joint_data;
 typedef struct xyzwpr_data_s {
-    QVector<double> xyzwpr;
+    std::array<double, 6> xyzwpr = {{0}};
     bool flip = false; // Flip/Unflip
     bool left = false;
     bool up = true;    // Up/Down
@@ -12,6 +15,35 @@ typedef struct xyzwpr_data_s {
     int t1 = 0, t2 = 0, t3 = 0;
 } xyzwpr_data;
 
+// Joint state with controller timestamp, angles in degrees
+struct joint_feedback_data {
+    double time = 0;              // controller time, s
+    joint_data position = {{0}};
+    joint_data velocity = {{0}};  // deg/s
+    bool has_time = false;
+    bool has_position = false;
+    bool has_velocity = false;
+};
+
+// Controller status, see status_t
+struct status_data {
+    bool in_motion = false;
+    bool ready_to_move = false;
+    bool error = false;
+};
+
+// Digital output pulse the controller fires at a trajectory point
+struct io_pulse_data {
+    int sequence = 0;       // of the point in the trajectory
+    int output = 0;         // DO index
+    double duration = 0;    // s, the robot stays at the point meanwhile
+};
+
+static_assert(std::is_trivially_copyable<joint_data>::value, "joint_data must be trivially copyable");
+static_assert(std::is_trivially_copyable<xyzwpr_data>::value, "xyzwpr_data must be trivially copyable");
+static_assert(std::is_trivially_copyable<joint_feedback_data>::value, "joint_feedback_data must be trivially copyable");
+static_assert(std::is_trivially_copyable<status_data>::value, "status_data must be trivially copyable");
+
 inline int fanuc_config_make(const xyzwpr_data &data)
 {
     uint32_t config = ((data.t1 & 0xFF) << 0) |
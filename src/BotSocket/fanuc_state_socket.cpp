@@ -2,14 +2,18 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <QTimer>
-#include <QSettings>
-#include "simple_message.h"
 #include "log/loguru.hpp"
 
 using namespace simple_message;
 
+static const double INTERVAL_SMOOTHING = 0.05;
+static const qint64 STATS_PERIOD_NS = 200000000; // publish summaries at most 5 times a second
+static const int HEALTH_CHECK_INTERVAL = 50;       // ms
+
 FanucStateSocket::FanucStateSocket(QObject *parent):
-    QObject(parent)
+    QObject(parent),
+    socket_(this),
+    health_timer_(this)
 {
     VLOG_CALL;
     connect(&socket_, &QAbstractSocket::connected, this, &FanucStateSocket::on_connected);
@@ -22,43 +26,143 @@ FanucStateSocket::FanucStateSocket(QObject *parent):
     connect(&socket_, SIGNAL(error(QAbstractSocket::SocketError)), SLOT(on_error(QAbstractSocket::SocketError)));
 #endif
 
-    connect(&watchdog_timer_, &QTimer::timeout, this, &FanucStateSocket::watchdog);
+    health_timer_.setInterval(HEALTH_CHECK_INTERVAL);
+    connect(&health_timer_, &QTimer::timeout, this, &FanucStateSocket::check_link);
+
+    handlers_.add<ping_t, &FanucStateSocket::on_ping>();
+    handlers_.add<joint_position_t, &FanucStateSocket::on_joint_position>();
+    handlers_.add<joint_traj_pt_t, &FanucStateSocket::on_joint_traj_pt>();
+    handlers_.add<xyzwpr_traj_pt_t, &FanucStateSocket::on_xyzwpr_traj_pt>();
+    handlers_.add<joint_feedback_t, &FanucStateSocket::on_joint_feedback>();
+    handlers_.add<status_t, &FanucStateSocket::on_status>();
+
+    clock_.start();
+}
+
+void FanucStateSocket::set_config(const fanuc_connection_config &config)
+{
+    bigendian_ = config.bigendian;
+    framer_.set_bigendian(bigendian_);
+    prefix1 = config.prefix1;
+    prefix2 = config.prefix2;
+    health_.set_timing(config.ping_interval / 1000., config.ping_timeout / 1000.);
+    ping_timeout_ = config.ping_timeout;
+}
+
+void FanucStateSocket::abort()
+{
+    health_timer_.stop();
+    socket_.abort();
+}
+
+void FanucStateSocket::set_capture(traffic_capture::writer *capture)
+{
+    capture_ = capture;
+}
 
-    start_connection();
+void FanucStateSocket::start_replay(bool bigendian)
+{
+    bigendian_ = bigendian;
+}
+
+void FanucStateSocket::replay_frame(const char *frame, size_t size)
+{
+    process_packet(packet_view(frame, size, bigendian_));
 }
 
 bool FanucStateSocket::connected() const
 {
-    return socket_.state() == QAbstractSocket::ConnectedState;
+    return connected_;
+}
+
+void FanucStateSocket::stats(BotSocket::SDiagnostics &diag) const
+{
+    stats_t stats;
+    stats_.load(stats);
+    diag.stateInterval = stats.interval;
+    diag.stateJitter = stats.jitter;
+    diag.stateDecode = stats.decode;
+    diag.statePing = stats.ping;
+    diag.stateRtt = stats.rtt;
+}
+
+void FanucStateSocket::reset_stats()
+{
+    interval_.reset();
+    jitter_.reset();
+    decode_.reset();
+    ping_.reset();
+    last_position_ns_ = -1;
+    interval_average_ = 0;
+    publish_stats(true);
+}
+
+void FanucStateSocket::publish_stats(bool force)
+{
+    const qint64 now = clock_.nsecsElapsed();
+    if(!force && now < stats_due_ns_)
+        return;
+    stats_due_ns_ = now + STATS_PERIOD_NS;
+
+    stats_t stats;
+    stats.interval = interval_.stats();
+    stats.jitter = jitter_.stats();
+    stats.decode = decode_.stats();
+    stats.ping = ping_.stats();
+    stats.rtt = health_.rtt() < 0 ? -1 : health_.rtt() * 1000;
+    stats_.store(stats);
+}
+
+double FanucStateSocket::now() const
+{
+    return clock_.nsecsElapsed() * 1e-9;
 }
 
 void FanucStateSocket::on_connected()
 {
     VLOG_CALL;
-    watchdog_ = true;
-    watchdog_timer_.start(5000);
+    framer_.reset();
+    health_.reset(now());
+    if(health_.enabled())
+        health_timer_.start();
+    connected_ = true;
     emit connection_state_changed(true);
 }
 
 void FanucStateSocket::on_disconnected()
 {
     VLOG_CALL;
-    watchdog_timer_.stop();
-    QTimer::singleShot(1000, this, &FanucStateSocket::start_connection);
+    health_timer_.stop();
+    last_position_ns_ = -1; // the gap is not a jitter
+    connected_ = false;
     emit connection_state_changed(false);
 }
 
-void FanucStateSocket::watchdog()
+// the state channel publishes all the time, so silence means a dead link
+// whatever the relay is doing
+void FanucStateSocket::check_link()
 {
-    if(watchdog_)
+    const double time = now();
+    if(!health_.alive(time))
     {
-        VLOG_CALL;
-        LOG_F(WARNING, "watchdog");
-        socket_.disconnectFromHost();
+        LOG_F(ERROR, "Nothing received in %d ms, dropping the connection", ping_timeout_);
+        health_timer_.stop();
+        last_position_ns_ = -1;
+        socket_.abort();
+        if(connected_)
+        {
+            connected_ = false;
+            emit connection_state_changed(false);
+        }
+        return;
     }
-    else
+
+    if(health_.ping_due(time) && socket_.state() == QAbstractSocket::ConnectedState)
     {
-        watchdog_ = true;
+        ping_t msg;
+        msg.header.comm_type = COMM_TYPE_SERVICE_REQUEST;
+        send_frame(encode(msg, bigendian_, send_buffer_, sizeof(send_buffer_)));
+        health_.on_ping_sent(time);
     }
 }
 
@@ -67,145 +171,143 @@ void FanucStateSocket::on_error(QAbstractSocket::SocketError error)
     VLOG_CALL;
     LOG_F(ERROR, "%d (%s)", error, socket_.errorString().toLocal8Bit().data());
     socket_.disconnectFromHost();
-    QTimer::singleShot(1000, this, &FanucStateSocket::start_connection);
+    connected_ = false;
     emit connection_state_changed(false);
 }
 
-// works with both floats and ints
-template <typename T>
-T bswap(T val) {
-    T retVal;
-    char *pVal = (char*) &val;
-    char *pRetVal = (char*)&retVal;
-    int size = sizeof(T);
-    for(int i=0; i<size; i++) {
-        pRetVal[size-1-i] = pVal[i];
-    }
-
-    return retVal;
-}
-
-static void bswap(QByteArray &array)
+void FanucStateSocket::on_readyread()
 {
-    for(int i=0; i<(array.size()/4)*4; i+=4)
+    while(socket_.bytesAvailable() > 0)
     {
-        char tmp0 = array[i+0], tmp1 = array[i+1];
-        array[i+0] = array[i+3];
-        array[i+1] = array[i+2];
-        array[i+2] = tmp1;
-        array[i+3] = tmp0;
+        qint64 size = socket_.read(framer_.write_ptr(), static_cast<qint64>(framer_.write_size()));
+        if(size <= 0)
+            break;
+        framer_.commit(static_cast<size_t>(size));
+
+        size_t packet_size = 0;
+        while(const char *packet = framer_.next_frame(packet_size))
+        {
+            if(capture_)
+                capture_->record(traffic_capture::CHANNEL_STATE, traffic_capture::DIRECTION_RX, packet, packet_size);
+            process_packet(packet_view(packet, packet_size, bigendian_));
+        }
     }
 }
 
-static bool get_prefix_header(QByteArray &packet, struct prefix_t **prefix, struct header_t **header)
+void FanucStateSocket::process_packet(const packet_view &packet)
 {
-    if(static_cast<size_t>(packet.size()) < sizeof(prefix_t) + sizeof(header_t))
-        return false;
+    if(!packet.valid())
+        return;
 
-    char *data = packet.data();
-    *prefix = reinterpret_cast<prefix_t*>(data);
-    *header = reinterpret_cast<header_t*>(data + sizeof(prefix_t));
+    health_.on_traffic(now());
 
-    return true;
+    const qint64 start = clock_.nsecsElapsed();
+    decode_packet(packet);
+    decode_.add((clock_.nsecsElapsed() - start) * 1e-6);
+    publish_stats(false);
 }
 
-void FanucStateSocket::on_readyread()
+void FanucStateSocket::decode_packet(const packet_view &packet)
 {
-    struct prefix_t *prefix = nullptr;
-    struct header_t *header = nullptr;
-    while(socket_.bytesAvailable() != 0)
+
+    const header_t &header = packet.header();
+    if(header.comm_type == COMM_TYPE_SERVICE_REQUEST)
     {
-        QByteArray packet = socket_.readAll();
+        LOG_F(ERROR, "Service request received, no support");
+        size_t size = encode_reply(packet, REPLY_CODE_FAILURE, send_buffer_, sizeof(send_buffer_));
+        if(size != 0)
+            send_frame(size);
+        return;
+    }
 
-        if(!get_prefix_header(packet, &prefix, &header))
-            continue;
+    if(header.comm_type != COMM_TYPE_TOPIC && header.comm_type != COMM_TYPE_SERVICE_REPLY)
+    {
+        LOG_F(ERROR, "Unknown comm_type %d", header.comm_type);
+        return;
+    }
 
-        watchdog_ = false;
+    handler_table<FanucStateSocket>::result_t result = handlers_.dispatch(*this, packet);
+    if(result == handler_table<FanucStateSocket>::BAD_LENGTH)
+        LOG_F(ERROR, "Received msg=%d, but length %d is not valid", header.msg_type, packet.prefix().length);
+    else if(result == handler_table<FanucStateSocket>::UNKNOWN_TYPE)
+        LOG_F(INFO, "Received l=%d msg=%d comm=%d reply=%d", packet.prefix().length, header.msg_type, header.comm_type, header.reply_code);
+}
 
-        if(bigendian_)
-            bswap(packet);
+void FanucStateSocket::on_joint_position(const joint_position_t &msg)
+{
+    joint_data_received(msg.joint_data, msg.sequence);
+}
 
-        if(header->comm_type == COMM_TYPE_SERVICE_REQUEST)
-        {
-            LOG_F(ERROR, "Service request received, no support");
-            header->comm_type = COMM_TYPE_SERVICE_REPLY;
-            header->reply_code = REPLY_CODE_FAILURE;
-            if(bigendian_)
-                bswap(packet);
-            socket_.write(packet);
-            continue;
-        }
+void FanucStateSocket::on_joint_traj_pt(const joint_traj_pt_t &msg)
+{
+    joint_data_received(msg.joint_data, msg.sequence);
+}
 
-        if(header->comm_type != COMM_TYPE_TOPIC && header->comm_type != COMM_TYPE_SERVICE_REPLY)
-        {
-            LOG_F(ERROR, "Unknown comm_type %d", header->comm_type);
-            continue;
-        }
+void FanucStateSocket::on_xyzwpr_traj_pt(const xyzwpr_traj_pt_t &msg)
+{
+    // position topic drives the GUI, its timing is what the operator sees
+    const qint64 now = clock_.nsecsElapsed();
+    if(last_position_ns_ >= 0)
+    {
+        const double interval = (now - last_position_ns_) * 1e-6;
+        if(interval_.count() == 0)
+            interval_average_ = interval;
+        interval_.add(interval);
+        jitter_.add(fabs(interval - interval_average_));
+        interval_average_ += (interval - interval_average_) * INTERVAL_SMOOTHING;
+    }
+    last_position_ns_ = now;
+
+    joint_data_received(msg.joint_data, msg.sequence);
+    if(msg.xyz_data.prefix1 != prefix1)
+        LOG_F(5, "prefix1: received %d, expected: %d", msg.xyz_data.prefix1, prefix1);
+    if(msg.xyz_data.prefix2 != prefix2)
+        LOG_F(5, "prefix2: received %d, expected: %d", msg.xyz_data.prefix2, prefix2);
+    xyzwpr_data_received(msg.xyz_data.xyzwpr, msg.xyz_data.config, msg.sequence);
+}
 
-        switch(header->msg_type)
-        {
-            case MSG_TYPE_JOINT_POSITION: {
-                if(prefix->length+sizeof(prefix_t) != sizeof(joint_position_t)) {
-                    LOG_F(ERROR, "Received joint position, but length is not valid");
-                    continue;
-                }
-
-                struct joint_position_t *msg = reinterpret_cast<struct joint_position_t *>(packet.data());
-                joint_data_received(msg->joint_data, msg->sequence);
-
-                break;
-            };
-            case MSG_TYPE_JOINT_TRAJ_PT: {
-                if(prefix->length+sizeof(prefix_t) != sizeof(joint_traj_pt_t)) {
-                    LOG_F(ERROR, "Received joint traj pt, but length is not valid");
-                    continue;
-                }
-
-                struct joint_traj_pt_t *msg = reinterpret_cast<struct joint_traj_pt_t *>(packet.data());
-                joint_data_received(msg->joint_data, msg->sequence);
-
-                break;
-            };
-            case MSG_TYPE_XYZWPR_TRAJ_PT: {
-                if(prefix->length+sizeof(prefix_t) != sizeof(xyzwpr_traj_pt_t)) {
-                    LOG_F(ERROR, "Received xyzwpr_traj_pt_t, but length is not valid");
-                    continue;
-                }
-
-                struct xyzwpr_traj_pt_t *msg = reinterpret_cast<struct xyzwpr_traj_pt_t *>(packet.data());
-                joint_data_received(msg->joint_data, msg->sequence);
-                if(msg->xyz_data.prefix1 != prefix1)
-                    LOG_F(5, "prefix1: received %d, expected: %d", msg->xyz_data.prefix1, prefix1);
-                if(msg->xyz_data.prefix2 != prefix2)
-                    LOG_F(5, "prefix2: received %d, expected: %d", msg->xyz_data.prefix2, prefix2);
-                xyzwpr_data_received(msg->xyz_data.xyzwpr, msg->xyz_data.config, msg->sequence);
-
-                break;
-            };
-            case MSG_TYPE_STATUS: {
-                if(prefix->length+sizeof(prefix_t) != sizeof(status_t)) {
-                    LOG_F(ERROR, "Received status, but length is not valid");
-                    continue;
-                }
-
-                struct status_t *msg = reinterpret_cast<struct status_t *>(packet.data());
-                LOG_F(INFO, "STATUS: in_motion=%d drives_powered=%d motion_possible=%d mode=%d e_stopped=%d in_error=%d error_code=%d",
-                                     msg->in_motion, msg->drives_powered, msg->motion_possible, msg->mode, msg->e_stopped, msg->in_error, msg->error_code);
-                emit status_received(msg->in_motion == TRI_STATE_ON,
-                                     msg->drives_powered == TRI_STATE_ON && msg->motion_possible == TRI_STATE_ON,
-                                     msg->in_error == TRI_STATE_ON || msg->e_stopped == TRI_STATE_ON);
-
-                break;
-            };
-            default:
-                LOG_F(INFO, "Received l=%d msg=%d comm=%d reply=%d", prefix->length, header->msg_type, header->comm_type, header->reply_code);
-        };
+void FanucStateSocket::on_joint_feedback(const joint_feedback_t &msg)
+{
+    joint_feedback_data fb;
+    fb.has_time = (msg.valid_fields & VALID_FIELD_TIME) != 0;
+    fb.has_position = (msg.valid_fields & VALID_FIELD_POSITION) != 0;
+    fb.has_velocity = (msg.valid_fields & VALID_FIELD_VELOCITY) != 0;
+    fb.time = msg.time;
+    for(int i=0; i<6; i++)
+    {
+        fb.position[i] = msg.positions[i] * 180/M_PI;
+        fb.velocity[i] = msg.velocities[i] * 180/M_PI;
     }
+    LOG_F(4, "JOINT FEEDBACK: t=%f valid=%d J1=%f J2=%f J3=%f J4=%f J5=%f J6=%f", fb.time, msg.valid_fields,
+                                                                                fb.position[0], fb.position[1], fb.position[2],
+                                                                                fb.position[3], fb.position[4], fb.position[5]);
+    if(fb.has_position)
+        emit joint_position_received(fb.position);
+    emit joint_feedback_received(fb);
+}
+
+void FanucStateSocket::on_status(const status_t &msg)
+{
+    LOG_F(INFO, "STATUS: in_motion=%d drives_powered=%d motion_possible=%d mode=%d e_stopped=%d in_error=%d error_code=%d",
+                         msg.in_motion, msg.drives_powered, msg.motion_possible, msg.mode, msg.e_stopped, msg.in_error, msg.error_code);
+    emit status_received(msg.in_motion == TRI_STATE_ON,
+                         msg.drives_powered == TRI_STATE_ON && msg.motion_possible == TRI_STATE_ON,
+                         msg.in_error == TRI_STATE_ON || msg.e_stopped == TRI_STATE_ON);
+}
+
+void FanucStateSocket::on_ping(const ping_t &msg)
+{
+    const double rtt = health_.on_ping_reply(now());
+    if(rtt < 0)
+        return;
+    LOG_F(5, "PING reply %d, %.3f ms", msg.header.reply_code, rtt * 1000);
+    ping_.add(rtt * 1000);
+    publish_stats(false);
 }
 
 void FanucStateSocket::joint_data_received(const simple_message::real_t   joint[10], int)
 {
-    joint_data pos(6);
+    joint_data pos;
     for(int i=0; i<6; i++)
         pos[i] = joint[i] * 180/M_PI;
     LOG_F(4, "JOINT POSITION: J1=%f J2=%f J3=%f J4=%f J5=%f J6=%f", pos[0], pos[1], pos[2],
@@ -215,11 +317,8 @@ void FanucStateSocket::joint_data_received(const simple_message::real_t   joint[
 void FanucStateSocket::xyzwpr_data_received(const simple_message::real_t   xyzwpr[6], int config, int)
 {
     xyzwpr_data pos;
-    pos.xyzwpr.resize(6);
     for(int i=0; i<6; i++)
         pos.xyzwpr[i] = xyzwpr[i];
-    if(bigendian_) // config is not byte-swapped
-        config = bswap(config);
     fanuc_config_parse(config, pos);
     LOG_F(4, "XYZWPR POSITION: X=%f Y=%f Z=%f W=%f P=%f R=%f, C=(%d,%d,%d,%d,%d,%d)",
                                                                pos.xyzwpr[0], pos.xyzwpr[1], pos.xyzwpr[2],
@@ -228,23 +327,24 @@ void FanucStateSocket::xyzwpr_data_received(const simple_message::real_t   xyzwp
     emit xyzwpr_position_received(pos);
 }
 
-void FanucStateSocket::start_connection()
+void FanucStateSocket::send_frame(size_t size)
+{
+    if(capture_)
+        capture_->record(traffic_capture::CHANNEL_STATE, traffic_capture::DIRECTION_TX, send_buffer_, size);
+    socket_.write(send_buffer_, static_cast<qint64>(size));
+}
+
+void FanucStateSocket::connect_to_host(const fanuc_connection_config &config)
 {
     VLOG_CALL;
 
     if(socket_.state() != QAbstractSocket::ConnectingState &&
        socket_.state() != QAbstractSocket::ConnectedState)
     {
-        QSettings settings("fanuc.ini", QSettings::IniFormat);
-
-        bigendian_ = settings.value("bigendian", false).toBool();
-        QString host = settings.value("server_ip", "127.0.0.1").toString();
-        int port = settings.value("server_state_port", 11002).toInt();
-        prefix1 = settings.value("prefix1", prefix1).toInt();
-        prefix2 = settings.value("prefix2", prefix2).toInt();
-        LOG_F(INFO, "Connecting to %s:%d", host.toLocal8Bit().data(), port);
+        set_config(config);
+        LOG_F(INFO, "Connecting to %s:%d", config.host.toLocal8Bit().data(), config.state_port);
         LOG_F(INFO, "Bigendian: %d, prefix1: %d, prefix2: %d", bigendian_, prefix1, prefix2);
 
-        socket_.connectToHost(host, port);
+        socket_.connectToHost(config.host, config.state_port);
     }
 }
@@ -1,10 +1,18 @@
 #pragma once
 
 #include <QObject>
+#include <atomic>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QtNetwork/QTcpSocket>
 #include "fanuc_socket_types.h"
-#include "simple_message.h"
+#include "simple_message_dispatch.h"
+#include "simple_message_framer.h"
+#include "traffic_capture.h"
+#include "fanuc_connection_manager.h"
+#include "latency_histogram.h"
+#include "link_health.h"
+#include "seqlock.h"
 
 class FanucStateSocket : public QObject
 {
@@ -12,11 +20,29 @@ class FanucStateSocket : public QObject
 public:
     explicit FanucStateSocket(QObject *parent = nullptr);
 
+    // records traffic into capture, call before start()
+    void set_capture(traffic_capture::writer *capture);
+
+    // feed captured frames instead of a connection, see TrafficReplay
+    void start_replay(bool bigendian);
+    void replay_frame(const char *frame, size_t size);
+
+    // thread safe
     bool connected() const;
+    void stats(BotSocket::SDiagnostics &diag) const; // fills state* fields
+
+    // connection is driven by FanucConnectionManager
+    void set_config(const fanuc_connection_config &config);
+    void connect_to_host(const fanuc_connection_config &config);
+    void abort();
+
+public slots:
+    void reset_stats();
 
 signals:
     void joint_position_received(const joint_data &pos);
     void xyzwpr_position_received(const xyzwpr_data &pos);
+    void joint_feedback_received(const joint_feedback_data &feedback);
     void connection_state_changed(bool connected);
     void status_received(bool moving, bool ready_to_move, bool error);
 
@@ -29,14 +55,42 @@ private slots:
     void joint_data_received(const simple_message::real_t   joint_data[10], int sequence);
     void xyzwpr_data_received(const simple_message::real_t   xyzwpr_data[6], int config, int sequence);
 
-    void watchdog();
+    void check_link();
 
 private:
-    void start_connection();
+    void send_frame(size_t size);
+    void process_packet(const simple_message::packet_view &packet);
+    void decode_packet(const simple_message::packet_view &packet);
+    void on_joint_position(const simple_message::joint_position_t &msg);
+    void on_joint_traj_pt(const simple_message::joint_traj_pt_t &msg);
+    void on_xyzwpr_traj_pt(const simple_message::xyzwpr_traj_pt_t &msg);
+    void on_joint_feedback(const simple_message::joint_feedback_t &msg);
+    void on_status(const simple_message::status_t &msg);
+    void on_ping(const simple_message::ping_t &msg);
+    void publish_stats(bool force);
+    double now() const; // s
 
     QTcpSocket socket_;
+    std::atomic<bool> connected_{false};
+    SimpleMessageFramer framer_;
+    traffic_capture::writer *capture_ = nullptr;
+    simple_message::handler_table<FanucStateSocket> handlers_;
+    char send_buffer_[SimpleMessageFramer::MAX_FRAME_SIZE];
     bool bigendian_ = false;
     simple_message::int_t prefix1 = 0, prefix2 = 0;
-    bool watchdog_ = true;
-    QTimer watchdog_timer_;
+    LinkHealth health_;
+    int ping_timeout_ = 0;  // ms
+    QTimer health_timer_;
+
+    struct stats_t {
+        BotSocket::SLatencyStats interval, jitter, decode, ping;
+        double rtt = -1;    // ms
+    };
+
+    QElapsedTimer clock_;
+    qint64 last_position_ns_ = -1;
+    double interval_average_ = 0;   // ms
+    qint64 stats_due_ns_ = 0;
+    LatencyHistogram interval_, jitter_, decode_, ping_;
+    SeqLock<stats_t> stats_;
 };
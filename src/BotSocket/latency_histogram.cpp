@@ -0,0 +1,114 @@
+#include "latency_histogram.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+constexpr double LatencyHistogram::MIN_VALUE;
+constexpr double LatencyHistogram::MAX_VALUE;
+constexpr double LatencyHistogram::GROWTH;
+const size_t LatencyHistogram::BUCKETS;
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::add(double value)
+{
+    if(!(value >= 0))
+        value = 0;
+
+    counts_[bucket(value)]++;
+    if(count_ == 0)
+    {
+        min_ = max_ = value;
+    }
+    else
+    {
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+    count_++;
+    sum_ += value;
+}
+
+void LatencyHistogram::reset()
+{
+    memset(counts_, 0, sizeof(counts_));
+    count_ = 0;
+    sum_ = min_ = max_ = 0;
+}
+
+size_t LatencyHistogram::count() const
+{
+    return count_;
+}
+
+double LatencyHistogram::min() const
+{
+    return min_;
+}
+
+double LatencyHistogram::max() const
+{
+    return max_;
+}
+
+double LatencyHistogram::mean() const
+{
+    return count_ > 0 ? sum_ / count_ : 0;
+}
+
+double LatencyHistogram::percentile(double fraction) const
+{
+    if(count_ == 0)
+        return 0;
+
+    // rank of the sample, 1 based
+    const double rank = std::max(1., ceil(std::min(std::max(fraction, 0.), 1.) * count_));
+    if(rank <= 1)
+        return min_;
+    if(rank >= count_)
+        return max_;
+
+    size_t seen = 0;
+    for(size_t i=0; i<BUCKETS; i++)
+    {
+        seen += counts_[i];
+        if(seen >= rank)
+            return bucket_value(i);
+    }
+    return max_;
+}
+
+BotSocket::SLatencyStats LatencyHistogram::stats() const
+{
+    BotSocket::SLatencyStats result;
+    result.count = count_;
+    result.min = min_;
+    result.mean = mean();
+    result.p50 = percentile(0.5);
+    result.p90 = percentile(0.9);
+    result.p99 = percentile(0.99);
+    result.max = max_;
+    return result;
+}
+
+size_t LatencyHistogram::bucket(double value)
+{
+    if(value <= MIN_VALUE)
+        return 0;
+    const double index = ceil(log(value / MIN_VALUE) / log(GROWTH));
+    return std::min(static_cast<size_t>(index), BUCKETS - 1);
+}
+
+// geometric middle of the bucket, kept within the observed range
+double LatencyHistogram::bucket_value(size_t index) const
+{
+    if(index == 0)
+        return min_;
+    if(index == BUCKETS - 1)
+        return max_;
+    const double value = MIN_VALUE * pow(GROWTH, index - 0.5);
+    return std::min(std::max(value, min_), max_);
+}
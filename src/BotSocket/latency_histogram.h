@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bot_socket_types.h"
+
+// Constant memory latency histogram with log spaced buckets.
+// Bucket bounds grow by GROWTH, so percentiles have a relative error of a few
+// percent over the whole range from MIN_VALUE to MAX_VALUE; values outside
+// the range fall into the edge buckets. Values are in ms.
+class LatencyHistogram
+{
+public:
+    static constexpr double MIN_VALUE = 1e-4; // 0.1 us
+    static constexpr double MAX_VALUE = 1e5;  // 100 s
+    static constexpr double GROWTH = 1.05;
+    static const size_t BUCKETS = 426;        // 1 + ceil(log(MAX_VALUE / MIN_VALUE) / log(GROWTH))
+
+    LatencyHistogram();
+
+    void add(double value);
+    void reset();
+
+    size_t count() const;
+    double min() const;
+    double max() const;
+    double mean() const;
+
+    // value below which the given fraction [0, 1] of samples falls
+    double percentile(double fraction) const;
+
+    BotSocket::SLatencyStats stats() const;
+
+private:
+    static size_t bucket(double value);
+    double bucket_value(size_t index) const;
+
+    uint32_t counts_[BUCKETS];
+    size_t count_ = 0;
+    double sum_ = 0;
+    double min_ = 0, max_ = 0;
+};
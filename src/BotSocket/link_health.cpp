@@ -0,0 +1,68 @@
+#include "link_health.h"
+
+static const double RTT_SMOOTHING = 0.2;
+
+void LinkHealth::set_timing(double interval, double timeout)
+{
+    interval_ = interval;
+    timeout_ = timeout;
+}
+
+bool LinkHealth::enabled() const
+{
+    return interval_ > 0;
+}
+
+double LinkHealth::interval() const
+{
+    return interval_;
+}
+
+void LinkHealth::reset(double time)
+{
+    last_heard_ = time;
+    next_ping_ = time;
+    ping_sent_ = -1;
+    rtt_ = -1;
+}
+
+bool LinkHealth::ping_due(double time) const
+{
+    if(!enabled() || time < next_ping_)
+        return false;
+    // a PING the peer ignored is sent again after timeout
+    return ping_sent_ < 0 || time - ping_sent_ >= timeout_;
+}
+
+void LinkHealth::on_ping_sent(double time)
+{
+    next_ping_ = time + interval_;
+    ping_sent_ = time;
+}
+
+double LinkHealth::on_ping_reply(double time)
+{
+    on_traffic(time);
+    if(ping_sent_ < 0)
+        return -1;
+
+    const double rtt = time - ping_sent_;
+    ping_sent_ = -1;
+    rtt_ = rtt_ < 0 ? rtt : rtt_ + (rtt - rtt_) * RTT_SMOOTHING;
+    return rtt;
+}
+
+void LinkHealth::on_traffic(double time)
+{
+    last_heard_ = time;
+}
+
+bool LinkHealth::alive(double time) const
+{
+    return !enabled() || time - last_heard_ <= timeout_;
+}
+
+double LinkHealth::rtt() const
+{
+    return rtt_;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+// Liveness of a SimpleMessage channel.
+// A PING is sent every interval while nothing else is waiting for an answer, its
+// reply gives the round trip time. Any packet from the peer counts as a sign of
+// life, so a controller that does not answer PING but publishes topics is still
+// alive. The link is lost when nothing was heard for timeout.
+// Times are in seconds of any monotonic clock.
+class LinkHealth
+{
+public:
+    void set_timing(double interval, double timeout); // interval <= 0 disables the check
+    bool enabled() const;
+    double interval() const;
+
+    void reset(double time);          // on connect
+    bool ping_due(double time) const;
+    void on_ping_sent(double time);
+    double on_ping_reply(double time); // round trip, s, <0 if no PING was in flight
+    void on_traffic(double time);
+    bool alive(double time) const;
+
+    double rtt() const;               // smoothed round trip, s, <0 if unknown
+
+private:
+    double interval_ = 0.2;
+    double timeout_ = 0.8;
+    double last_heard_ = 0;
+    double next_ping_ = 0;
+    double ping_sent_ = -1;           // PING in flight since, <0 if none
+    double rtt_ = -1;
+};
@@ -0,0 +1,123 @@
+#include "motion_state_tracker.h"
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+
+typedef double matrix_t[3][3];
+
+// W, P, R are rotations about fixed X, Y, Z axes: R = Rz * Ry * Rx
+static void wpr_matrix(const xyzwpr_data &pos, matrix_t m)
+{
+    const double w = pos.xyzwpr[3] * M_PI/180, p = pos.xyzwpr[4] * M_PI/180, r = pos.xyzwpr[5] * M_PI/180;
+    const double cw = cos(w), sw = sin(w), cp = cos(p), sp = sin(p), cr = cos(r), sr = sin(r);
+    m[0][0] = cr*cp; m[0][1] = cr*sp*sw - sr*cw; m[0][2] = cr*sp*cw + sr*sw;
+    m[1][0] = sr*cp; m[1][1] = sr*sp*sw + cr*cw; m[1][2] = sr*sp*cw - cr*sw;
+    m[2][0] = -sp;   m[2][1] = cp*sw;            m[2][2] = cp*cw;
+}
+
+void MotionStateTracker::set_config(const config_t &config)
+{
+    config_ = config;
+}
+
+const MotionStateTracker::config_t &MotionStateTracker::config() const
+{
+    return config_;
+}
+
+void MotionStateTracker::start(double time, const xyzwpr_data &target)
+{
+    state_ = MOVING;
+    target_ = target;
+    has_pose_ = false;
+    in_motion_ = false;
+    start_time_ = last_motion_ = time;
+    settle_since_ = -1;
+}
+
+void MotionStateTracker::reset()
+{
+    state_ = IDLE;
+}
+
+void MotionStateTracker::on_pose(double time, const xyzwpr_data &pos)
+{
+    if(state_ != MOVING)
+        return;
+
+    if(has_pose_ && (distance(pos, last_pose_) > config_.motion_threshold ||
+                     rotation_angle(pos, last_pose_) > config_.motion_threshold))
+        last_motion_ = time;
+    last_pose_ = pos;
+    has_pose_ = true;
+
+    const bool at_target = distance(pos, target_) <= config_.position_tolerance &&
+                           rotation_angle(pos, target_) <= config_.rotation_tolerance;
+    if(!at_target || in_motion_)
+        settle_since_ = -1;
+    else if(settle_since_ < 0)
+        settle_since_ = time;
+}
+
+void MotionStateTracker::on_status(double time, bool in_motion)
+{
+    if(state_ != MOVING)
+        return;
+
+    in_motion_ = in_motion;
+    if(in_motion)
+    {
+        last_motion_ = time;
+        settle_since_ = -1;
+    }
+    else if(has_pose_)
+    {
+        // stopped at the target: settling is counted from the last pose
+        on_pose(time, last_pose_);
+    }
+}
+
+MotionStateTracker::state_t MotionStateTracker::update(double time)
+{
+    if(state_ != MOVING)
+        return state_;
+
+    if(settle_since_ >= 0 && time - settle_since_ >= config_.settle_time)
+        state_ = SETTLED;
+    else if(time - last_motion_ >= std::max(config_.timeout, config_.settle_time))
+        state_ = TIMED_OUT;
+    return state_;
+}
+
+MotionStateTracker::state_t MotionStateTracker::state() const
+{
+    return state_;
+}
+
+double MotionStateTracker::started() const
+{
+    return start_time_;
+}
+
+double MotionStateTracker::distance(const xyzwpr_data &a, const xyzwpr_data &b)
+{
+    const double dx = a.xyzwpr[0] - b.xyzwpr[0];
+    const double dy = a.xyzwpr[1] - b.xyzwpr[1];
+    const double dz = a.xyzwpr[2] - b.xyzwpr[2];
+    return sqrt(dx*dx + dy*dy + dz*dz);
+}
+
+// angle of the rotation between two orientations, works near gimbal lock
+// where the same orientation has different W, P, R
+double MotionStateTracker::rotation_angle(const xyzwpr_data &a, const xyzwpr_data &b)
+{
+    matrix_t ma, mb;
+    wpr_matrix(a, ma);
+    wpr_matrix(b, mb);
+    double trace = 0;
+    for(int i=0; i<3; i++)
+        for(int j=0; j<3; j++)
+            trace += ma[j][i] * mb[j][i];
+    const double c = std::min(1., std::max(-1., (trace - 1) / 2));
+    return acos(c) * 180/M_PI;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "fanuc_socket_types.h"
+
+// Decides when the robot has actually arrived at a commanded point.
+// "Trajectory enqueued" only means the controller accepted the point; the robot
+// is settled once it reports no motion and its pose has stayed within tolerance
+// of the target for settle_time. If there is no sign of motion for timeout
+// (no status, pose out of tolerance but not changing), the wait ends anyway.
+// Times are in seconds of any monotonic clock, poses in controller coordinates.
+class MotionStateTracker
+{
+public:
+    enum state_t {
+        IDLE,
+        MOVING,
+        SETTLED,
+        TIMED_OUT
+    };
+
+    struct config_t {
+        double position_tolerance = 0.5;  // mm
+        double rotation_tolerance = 0.5;  // deg
+        double motion_threshold = 0.05;   // mm or deg between poses counted as motion
+        double settle_time = 0.2;         // s
+        double timeout = 3.0;             // s without any sign of motion
+    };
+
+    void set_config(const config_t &config);
+    const config_t &config() const;
+
+    void start(double time, const xyzwpr_data &target);
+    void reset();
+
+    void on_pose(double time, const xyzwpr_data &pos);
+    void on_status(double time, bool in_motion);
+    state_t update(double time);
+
+    state_t state() const;
+    double started() const;
+
+    static double distance(const xyzwpr_data &a, const xyzwpr_data &b);
+    static double rotation_angle(const xyzwpr_data &a, const xyzwpr_data &b); // deg
+
+private:
+    config_t config_;
+    state_t state_ = IDLE;
+    xyzwpr_data target_;
+    xyzwpr_data last_pose_;
+    bool has_pose_ = false;
+    bool in_motion_ = false;
+    double start_time_ = 0;
+    double last_motion_ = 0;     // last sign of motion
+    double settle_since_ = -1;   // pose is at the target since, <0 if not
+};
@@ -0,0 +1,259 @@
+#include "opw_kinematics.h"
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <limits>
+
+static const double DEG = M_PI / 180.;
+
+void OpwKinematics::set_parameters(const parameters_t &parameters)
+{
+    p_ = parameters;
+    tool_ = frame_t(to_isometry(p_.tool));
+    tool_inverse_ = tool_.inverse();
+}
+
+const OpwKinematics::parameters_t &OpwKinematics::parameters() const
+{
+    return p_;
+}
+
+bool OpwKinematics::valid() const
+{
+    return p_.c2 > 0 && (p_.a2 != 0 || p_.c3 != 0);
+}
+
+OpwKinematics::model_t OpwKinematics::to_model(const joint_data &joints) const
+{
+    joint_data j = joints;
+    j[2] -= p_.j23_factor * j[1];
+    model_t q;
+    for(int i=0; i<6; i++)
+        q[i] = (j[i] * p_.signs[i] - p_.offsets[i]) * DEG;
+    return q;
+}
+
+joint_data OpwKinematics::to_joints(const model_t &q) const
+{
+    joint_data j;
+    for(int i=0; i<6; i++)
+        j[i] = (q[i] / DEG + p_.offsets[i]) * p_.signs[i];
+    j[2] += p_.j23_factor * j[1];
+    return j;
+}
+
+Eigen::Isometry3d OpwKinematics::forward(const joint_data &joints) const
+{
+    const model_t q = to_model(joints);
+
+    const double psi3 = atan2(p_.a2, p_.c3);
+    const double k = sqrt(p_.a2 * p_.a2 + p_.c3 * p_.c3);
+
+    // wrist center
+    const double cx1 = p_.c2 * sin(q[1]) + k * sin(q[1] + q[2] + psi3) + p_.a1;
+    const double cy1 = p_.b;
+    const double cz1 = p_.c2 * cos(q[1]) + k * cos(q[1] + q[2] + psi3);
+    const Eigen::Vector3d c(cx1 * cos(q[0]) - cy1 * sin(q[0]),
+                            cx1 * sin(q[0]) + cy1 * cos(q[0]),
+                            cz1 + p_.c1);
+
+    const double s1 = sin(q[0]), s2 = sin(q[1]), s3 = sin(q[2]), s4 = sin(q[3]), s5 = sin(q[4]), s6 = sin(q[5]);
+    const double c1 = cos(q[0]), c2 = cos(q[1]), c3 = cos(q[2]), c4 = cos(q[3]), c5 = cos(q[4]), c6 = cos(q[5]);
+
+    Eigen::Matrix3d r_0c;
+    r_0c << c1 * c2 * c3 - c1 * s2 * s3, -s1, c1 * c2 * s3 + c1 * s2 * c3,
+            s1 * c2 * c3 - s1 * s2 * s3,  c1, s1 * c2 * s3 + s1 * s2 * c3,
+            -s2 * c3 - c2 * s3,            0, -s2 * s3 + c2 * c3;
+
+    Eigen::Matrix3d r_ce;
+    r_ce << c4 * c5 * c6 - s4 * s6, -c4 * c5 * s6 - s4 * c6, c4 * s5,
+            s4 * c5 * c6 + c4 * s6, -s4 * c5 * s6 + c4 * c6, s4 * s5,
+            -s5 * c6,                s5 * s6,                c5;
+
+    Eigen::Isometry3d flange = Eigen::Isometry3d::Identity();
+    flange.linear() = r_0c * r_ce;
+    flange.translation() = c + p_.c4 * flange.linear().col(2);
+    return flange * tool_;
+}
+
+OpwKinematics::solutions_t OpwKinematics::inverse(const Eigen::Isometry3d &pose) const
+{
+    const Eigen::Isometry3d flange = pose * tool_inverse_;
+    const Eigen::Matrix3d &r = flange.linear();
+    const Eigen::Vector3d c = flange.translation() - p_.c4 * r.col(2);
+
+    // arm: J1 facing the wrist center or turned away, elbow up or down
+    const double nx1 = sqrt(c.x() * c.x() + c.y() * c.y() - p_.b * p_.b) - p_.a1;
+
+    const double tmp1 = atan2(c.y(), c.x());
+    const double tmp2 = atan2(p_.b, nx1 + p_.a1);
+    const double theta1[2] = { tmp1 - tmp2, tmp1 + tmp2 - M_PI };
+
+    const double dz = c.z() - p_.c1;
+    const double s1_2 = nx1 * nx1 + dz * dz;
+    const double tmp4 = nx1 + 2 * p_.a1;
+    const double s2_2 = tmp4 * tmp4 + dz * dz;
+    const double kappa_2 = p_.a2 * p_.a2 + p_.c3 * p_.c3;
+    const double c2_2 = p_.c2 * p_.c2;
+    const double s1 = sqrt(s1_2), s2 = sqrt(s2_2);
+
+    // acos of more than 1 gives NaN, the point is out of reach for that arm
+    const double tmp13 = acos((s1_2 + c2_2 - kappa_2) / (2 * s1 * p_.c2));
+    const double tmp14 = atan2(nx1, dz);
+    const double tmp15 = acos((s2_2 + c2_2 - kappa_2) / (2 * s2 * p_.c2));
+    const double tmp16 = atan2(nx1 + 2 * p_.a1, dz);
+    const double theta2[4] = { -tmp13 + tmp14, tmp13 + tmp14, -tmp15 - tmp16, tmp15 - tmp16 };
+
+    const double tmp9 = 2 * p_.c2 * sqrt(kappa_2);
+    const double tmp10 = atan2(p_.a2, p_.c3);
+    const double tmp11 = acos((s1_2 - c2_2 - kappa_2) / tmp9);
+    const double tmp12 = acos((s2_2 - c2_2 - kappa_2) / tmp9);
+    const double theta3[4] = { tmp11 - tmp10, -tmp11 - tmp10, tmp12 - tmp10, -tmp12 - tmp10 };
+
+    solutions_t result;
+    for(int i=0; i<4; i++)
+    {
+        const double sin1 = sin(theta1[i / 2]), cos1 = cos(theta1[i / 2]);
+        const double s23 = sin(theta2[i] + theta3[i]), c23 = cos(theta2[i] + theta3[i]);
+
+        // wrist: J5 positive or negative
+        const double m = r(0, 2) * s23 * cos1 + r(1, 2) * s23 * sin1 + r(2, 2) * c23;
+        const double theta4 = atan2(r(1, 2) * cos1 - r(0, 2) * sin1,
+                                    r(0, 2) * c23 * cos1 + r(1, 2) * c23 * sin1 - r(2, 2) * s23);
+        const double theta5 = atan2(sqrt(std::max(0., 1 - m * m)), m);
+        const double theta6 = atan2(r(0, 1) * s23 * cos1 + r(1, 1) * s23 * sin1 + r(2, 1) * c23,
+                                    -r(0, 0) * s23 * cos1 - r(1, 0) * s23 * sin1 - r(2, 0) * c23);
+
+        const model_t q = {{ theta1[i / 2], theta2[i], theta3[i], theta4, theta5, theta6 }};
+        const model_t flip = {{ theta1[i / 2], theta2[i], theta3[i], theta4 + M_PI, -theta5, theta6 - M_PI }};
+        result[i] = to_joints(q);
+        result[i + 4] = to_joints(flip);
+    }
+    return result;
+}
+
+bool OpwKinematics::singular(const model_t &q) const
+{
+    if(fabs(sin(q[4])) < sin(p_.wrist_margin * DEG))
+        return true;
+
+    const double psi3 = atan2(p_.a2, p_.c3);
+    if(fabs(sin(q[2] + psi3)) < sin(p_.elbow_margin * DEG))
+        return true;
+
+    // distance of the wrist center from the J1 axis
+    const double k = sqrt(p_.a2 * p_.a2 + p_.c3 * p_.c3);
+    const double cx1 = p_.c2 * sin(q[1]) + k * sin(q[1] + q[2] + psi3) + p_.a1;
+    return sqrt(cx1 * cx1 + p_.b * p_.b) < p_.shoulder_margin;
+}
+
+// a joint may be reached one turn either way, take the turn closest to seed
+bool OpwKinematics::fit_limits(joint_data &joints, const joint_data &seed) const
+{
+    for(int i=0; i<6; i++)
+    {
+        bool found = false;
+        double best = 0;
+        for(int turn=-2; turn<=2; turn++)
+        {
+            const double v = joints[i] + 360. * turn;
+            if(v < p_.joint_min[i] || v > p_.joint_max[i])
+                continue;
+            if(!found || fabs(v - seed[i]) < fabs(best - seed[i]))
+                best = v;
+            found = true;
+        }
+        if(!found)
+            return false;
+        joints[i] = best;
+    }
+    return true;
+}
+
+OpwKinematics::error_t OpwKinematics::select(const solutions_t &solutions, const joint_data &seed,
+                                             joint_data &result) const
+{
+    error_t error = IK_UNREACHABLE;
+    double best = std::numeric_limits<double>::infinity();
+    for(const joint_data &solution : solutions)
+    {
+        bool finite = true;
+        for(double v : solution)
+            finite = finite && std::isfinite(v);
+        if(!finite)
+            continue;
+
+        joint_data joints = solution;
+        if(!fit_limits(joints, seed))
+        {
+            if(error == IK_UNREACHABLE)
+                error = IK_JOINT_LIMIT;
+            continue;
+        }
+        if(singular(to_model(joints)))
+        {
+            error = IK_SINGULAR;
+            continue;
+        }
+
+        double distance = 0;
+        for(int i=0; i<6; i++)
+            distance += (joints[i] - seed[i]) * (joints[i] - seed[i]);
+        if(distance < best)
+        {
+            best = distance;
+            result = joints;
+        }
+    }
+    return std::isfinite(best) ? IK_OK : error;
+}
+
+OpwKinematics::error_t OpwKinematics::solve(const xyzwpr_data &pose, const joint_data &seed,
+                                            joint_data &result) const
+{
+    return select(inverse(to_isometry(pose)), seed, result);
+}
+
+// W, P, R are fixed angles around X, Y, Z: R = Rz(r) * Ry(p) * Rx(w)
+Eigen::Isometry3d OpwKinematics::to_isometry(const xyzwpr_data &pose)
+{
+    Eigen::Isometry3d result = Eigen::Isometry3d::Identity();
+    result.linear() = (Eigen::AngleAxisd(pose.xyzwpr[5] * DEG, Eigen::Vector3d::UnitZ()) *
+                       Eigen::AngleAxisd(pose.xyzwpr[4] * DEG, Eigen::Vector3d::UnitY()) *
+                       Eigen::AngleAxisd(pose.xyzwpr[3] * DEG, Eigen::Vector3d::UnitX())).toRotationMatrix();
+    result.translation() = Eigen::Vector3d(pose.xyzwpr[0], pose.xyzwpr[1], pose.xyzwpr[2]);
+    return result;
+}
+
+xyzwpr_data OpwKinematics::to_xyzwpr(const Eigen::Isometry3d &pose)
+{
+    const Eigen::Matrix3d r = pose.linear();
+    const double cy = sqrt(r(0, 0) * r(0, 0) + r(1, 0) * r(1, 0));
+    double w, p = atan2(-r(2, 0), cy), z;
+    if(cy > 16 * std::numeric_limits<double>::epsilon())
+    {
+        w = atan2(r(2, 1), r(2, 2));
+        z = atan2(r(1, 0), r(0, 0));
+    }
+    else
+    {
+        w = atan2(-r(1, 2), r(1, 1));
+        z = 0;
+    }
+
+    xyzwpr_data result;
+    result.xyzwpr = {{ pose.translation().x(), pose.translation().y(), pose.translation().z(),
+                       w / DEG, p / DEG, z / DEG }};
+    return result;
+}
+
+const char *OpwKinematics::error_string(error_t error)
+{
+    switch(error)
+    {
+        case IK_OK:          return "ok";
+        case IK_UNREACHABLE: return "unreachable";
+        case IK_JOINT_LIMIT: return "joint limit";
+        case IK_SINGULAR:    return "singularity";
+    }
+    return "unknown";
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <Eigen/Geometry>
+#include "fanuc_socket_types.h"
+
+// Closed form kinematics of 6 axis arms with an ortho-parallel base and a
+// spherical wrist (M. Brandstoetter et al., "An analytical solution of the inverse
+// kinematics problem of industrial serial manipulators with an ortho-parallel
+// basis and a spherical wrist", 2014), which covers the FANUC arms we drive.
+// Lengths are in mm, angles in degrees, joints follow the controller convention:
+// model zero shifted by offsets, turned by signs, J3 coupled to J2 by j23_factor.
+// Poses are the TCP in the robot base frame, tool is the TCP in the flange frame.
+class OpwKinematics
+{
+public:
+    struct parameters_t {
+        double a1 = 0, a2 = 0, b = 0;
+        double c1 = 0, c2 = 0, c3 = 0, c4 = 0;
+        joint_data offsets = {{0, 0, 0, 0, 0, 0}};
+        joint_data signs = {{1, 1, 1, 1, 1, 1}};
+        double j23_factor = 0;        // 1 on FANUC, J3 is measured from the horizon
+        joint_data joint_min = {{-180, -180, -180, -180, -180, -180}};
+        joint_data joint_max = {{ 180,  180,  180,  180,  180,  180}};
+        xyzwpr_data tool;
+        double wrist_margin = 1;      // deg of J5 from the wrist singularity
+        double elbow_margin = 1;      // deg from the stretched arm
+        double shoulder_margin = 10;  // mm of the wrist center from the J1 axis
+    };
+
+    enum error_t {
+        IK_OK,
+        IK_UNREACHABLE,
+        IK_JOINT_LIMIT,
+        IK_SINGULAR
+    };
+
+    static const int SOLUTIONS = 8;
+    typedef std::array<joint_data, SOLUTIONS> solutions_t;
+
+    void set_parameters(const parameters_t &parameters);
+    const parameters_t &parameters() const;
+    bool valid() const;     // arm lengths are set
+
+    Eigen::Isometry3d forward(const joint_data &joints) const;
+    // every configuration, the ones out of reach are NaN
+    solutions_t inverse(const Eigen::Isometry3d &pose) const;
+
+    // the configuration nearest to seed, within the limits and away from
+    // singularities; joints that can turn further than 360 deg take the turn
+    // closest to seed
+    error_t select(const solutions_t &solutions, const joint_data &seed, joint_data &result) const;
+    error_t solve(const xyzwpr_data &pose, const joint_data &seed, joint_data &result) const;
+
+    static Eigen::Isometry3d to_isometry(const xyzwpr_data &pose);
+    static xyzwpr_data to_xyzwpr(const Eigen::Isometry3d &pose);
+    static const char *error_string(error_t error);
+
+private:
+    typedef std::array<double, 6> model_t; // model joints, rad
+
+    model_t to_model(const joint_data &joints) const;
+    joint_data to_joints(const model_t &q) const;
+    bool singular(const model_t &q) const;
+    bool fit_limits(joint_data &joints, const joint_data &seed) const;
+
+    // unaligned, the owner may live on the heap
+    typedef Eigen::Transform<double, 3, Eigen::Isometry, Eigen::DontAlign> frame_t;
+
+    parameters_t p_;
+    frame_t tool_ = frame_t::Identity();
+    frame_t tool_inverse_ = frame_t::Identity();
+};
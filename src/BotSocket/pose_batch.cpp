@@ -0,0 +1,182 @@
+#include "pose_batch.h"
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <cfloat>
+#include <Eigen/Geometry>
+
+static const double NORMAL_EPS = 1e-9;
+
+void PoseBatch::set_transform(const transform_t &user2world)
+{
+    transform_ = user2world;
+    converted_ = false;
+}
+
+void PoseBatch::set_reach(double reach)
+{
+    reach_ = reach;
+    converted_ = false;
+}
+
+void PoseBatch::clear()
+{
+    size_ = 0;
+    converted_ = false;
+    poses_.clear();
+    errors_.clear();
+}
+
+void PoseBatch::reserve(size_t size)
+{
+    if(static_cast<Eigen::Index>(size) <= pos_.cols())
+        return;
+    pos_.conservativeResize(3, static_cast<Eigen::Index>(size));
+    angle_.conservativeResize(3, static_cast<Eigen::Index>(size));
+    normal_.conservativeResize(3, static_cast<Eigen::Index>(size));
+}
+
+void PoseBatch::add(const GUI_TYPES::SVertex &pos, const GUI_TYPES::SRotationAngle &angle,
+                    const GUI_TYPES::SVertex &normal)
+{
+    if(static_cast<Eigen::Index>(size_) == pos_.cols())
+        reserve(std::max<size_t>(16, size_ * 2));
+
+    const Eigen::Index i = static_cast<Eigen::Index>(size_);
+    pos_.col(i) << pos.x, pos.y, pos.z;
+    angle_.col(i) << angle.x, angle.y, angle.z;
+    normal_.col(i) << normal.x, normal.y, normal.z;
+    size_++;
+    converted_ = false;
+}
+
+bool PoseBatch::same_input(const PoseBatch &other) const
+{
+    if(size_ != other.size_ || transform_ != other.transform_ || reach_ != other.reach_)
+        return false;
+    const Eigen::Index n = static_cast<Eigen::Index>(size_);
+    return pos_.leftCols(n) == other.pos_.leftCols(n) &&
+           angle_.leftCols(n) == other.angle_.leftCols(n) &&
+           normal_.leftCols(n) == other.normal_.leftCols(n);
+}
+
+// R = Rz(c) * Ry(b) * Rx(a), gp_Extrinsic_XYZ of OCCT
+static Eigen::Matrix3d euler_xyz(const double sa, const double ca,
+                                 const double sb, const double cb,
+                                 const double sc, const double cc)
+{
+    Eigen::Matrix3d r;
+    r << cb * cc, sa * sb * cc - ca * sc, ca * sb * cc + sa * sc,
+         cb * sc, sa * sb * sc + ca * cc, ca * sb * sc - sa * cc,
+         -sb,     sa * cb,                ca * cb;
+    return r;
+}
+
+// inverse of euler_xyz(), the same branch as gp_Quaternion::GetEulerAngles()
+static Eigen::Vector3d euler_xyz(const Eigen::Matrix3d &r)
+{
+    const double cy = sqrt(r(0, 0) * r(0, 0) + r(1, 0) * r(1, 0));
+    if(cy > 16 * DBL_EPSILON)
+        return Eigen::Vector3d(atan2(r(2, 1), r(2, 2)), atan2(-r(2, 0), cy), atan2(r(1, 0), r(0, 0)));
+    return Eigen::Vector3d(atan2(-r(1, 2), r(1, 1)), atan2(-r(2, 0), cy), 0);
+}
+
+// shortest arc from Z to the unit normal n, as gp_Quaternion(gp_Vec, gp_Vec) builds it
+static Eigen::Matrix3d normal_rotation(const Eigen::Vector3d &n)
+{
+    Eigen::Quaterniond q(n.z() + 1, -n.y(), n.x(), 0);
+    if(q.w() <= DBL_MIN)
+        q = Eigen::Quaterniond(0, 0, 1, 0); // opposite to Z, any perpendicular axis works
+    return q.normalized().toRotationMatrix();
+}
+
+void PoseBatch::convert()
+{
+    const Eigen::Index n = static_cast<Eigen::Index>(size_);
+    poses_.assign(size_, xyzwpr_data());
+    errors_.assign(size_, POSE_OK);
+
+    Eigen::Matrix3d t_rot;
+    Eigen::Vector3d t_pos;
+    for(int r=0; r<3; r++)
+    {
+        for(int c=0; c<3; c++)
+            t_rot(r, c) = transform_[r * 4 + c];
+        t_pos(r) = transform_[r * 4 + 3];
+    }
+    // like gp_Trsf, the scale moves points but does not turn the tool
+    const Eigen::Matrix3d t_turn = t_rot / std::cbrt(t_rot.determinant());
+
+    // trigonometry of the whole batch at once
+    const Eigen::Array3Xd rad = angle_.leftCols(n).array() * (M_PI / 180.);
+    const Eigen::Array3Xd s = rad.sin(), c = rad.cos();
+    const Eigen::Array<double, 1, Eigen::Dynamic> norms = normal_.leftCols(n).colwise().norm().array();
+    const Eigen::Matrix3Xd world_pos = (t_rot * pos_.leftCols(n)).colwise() + t_pos;
+
+    for(Eigen::Index i=0; i<n; i++)
+    {
+        error_t &error = errors_[static_cast<size_t>(i)];
+        if(!pos_.col(i).allFinite() || !angle_.col(i).allFinite() || !normal_.col(i).allFinite())
+        {
+            error = POSE_NOT_FINITE;
+            continue;
+        }
+        if(norms(i) <= NORMAL_EPS)
+        {
+            error = POSE_BAD_NORMAL;
+            continue;
+        }
+
+        const Eigen::Matrix3d tool = euler_xyz(s(0, i), c(0, i), s(1, i), c(1, i), s(2, i), c(2, i));
+        const Eigen::Matrix3d turn = t_turn * normal_rotation(normal_.col(i) / norms(i)) * tool;
+        const Eigen::Vector3d wpr = euler_xyz(turn) * (180. / M_PI);
+
+        xyzwpr_data &pose = poses_[static_cast<size_t>(i)];
+        pose.xyzwpr = {{world_pos(0, i), world_pos(1, i), world_pos(2, i), wpr(0), wpr(1), wpr(2)}};
+
+        if(!world_pos.col(i).allFinite() || !wpr.allFinite())
+            error = POSE_NOT_FINITE;
+        else if(reach_ > 0 && world_pos.col(i).norm() > reach_)
+            error = POSE_OUT_OF_REACH;
+    }
+    converted_ = true;
+}
+
+bool PoseBatch::converted() const
+{
+    return converted_;
+}
+
+size_t PoseBatch::size() const
+{
+    return size_;
+}
+
+const xyzwpr_data &PoseBatch::pose(size_t i) const
+{
+    return poses_[i];
+}
+
+PoseBatch::error_t PoseBatch::error(size_t i) const
+{
+    return errors_[i];
+}
+
+size_t PoseBatch::first_error() const
+{
+    for(size_t i=0; i<errors_.size(); i++)
+        if(errors_[i] != POSE_OK)
+            return i;
+    return errors_.size();
+}
+
+const char *PoseBatch::error_string(error_t error)
+{
+    switch(error)
+    {
+        case POSE_OK:           return "ok";
+        case POSE_NOT_FINITE:   return "not a number";
+        case POSE_BAD_NORMAL:   return "zero normal";
+        case POSE_OUT_OF_REACH: return "out of reach";
+    }
+    return "unknown";
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <Eigen/Core>
+#include "fanuc_socket_types.h"
+#include "../gui_types.h"
+
+// Converts task points (position, tool angles, surface normal in user coordinates)
+// to controller poses in one pass. Points are kept as structure of arrays, the
+// trigonometry runs over whole columns and the per point work is a couple of 3x3
+// products. The result matches the gp_Quaternion/gp_Trsf conversion it replaced
+// up to rounding. Every pose is validated before anything is sent to the robot.
+class PoseBatch
+{
+public:
+    enum error_t {
+        POSE_OK,
+        POSE_NOT_FINITE,    // NaN or infinite input or result
+        POSE_BAD_NORMAL,    // zero length normal
+        POSE_OUT_OF_REACH   // farther than reach from the robot base
+    };
+
+    typedef std::array<double, 12> transform_t; // 3 rows of [R | t], row major
+
+    void set_transform(const transform_t &user2world);
+    void set_reach(double reach);   // mm, <= 0 - no check
+
+    void clear();
+    void reserve(size_t size);
+    void add(const GUI_TYPES::SVertex &pos, const GUI_TYPES::SRotationAngle &angle,
+             const GUI_TYPES::SVertex &normal);
+
+    // same points, transform and limits, the converted poses can be reused
+    bool same_input(const PoseBatch &other) const;
+
+    void convert();
+    bool converted() const;
+
+    size_t size() const;
+    const xyzwpr_data &pose(size_t i) const;
+    error_t error(size_t i) const;
+    size_t first_error() const;     // size() if every pose is valid
+
+    static const char *error_string(error_t error);
+
+private:
+    transform_t transform_ = {{1, 0, 0, 0,
+                               0, 1, 0, 0,
+                               0, 0, 1, 0}};
+    double reach_ = 0;
+
+    Eigen::Matrix3Xd pos_, angle_, normal_;  // one point per column, angles in degrees
+    size_t size_ = 0;
+
+    bool converted_ = false;
+    std::vector<xyzwpr_data> poses_;
+    std::vector<error_t> errors_;
+};
@@ -0,0 +1,106 @@
+#include "pose_history.h"
+#include <math.h>
+
+const size_t PoseHistory::CAPACITY;
+
+static const double INTERVAL_SMOOTHING = 0.1;
+static const double MAX_DELAY = 0.5; // s, do not lag more even at low publish rates
+
+static double lerp(double a, double b, double k)
+{
+    return a + (b - a) * k;
+}
+
+// shortest way between two angles in degrees
+static double lerp_angle(double a, double b, double k)
+{
+    double d = fmod(b - a, 360.);
+    if(d > 180.)
+        d -= 360.;
+    else if(d < -180.)
+        d += 360.;
+    return a + d * k;
+}
+
+void PoseHistory::push(double time, const BotSocket::SBotPosition &pos)
+{
+    if(count_ > 0)
+    {
+        double last = latest_time();
+        if(time < last)
+            time = last; // keep history monotonic
+        double dt = time - last;
+        interval_ = interval_ == 0 ? dt : lerp(interval_, dt, INTERVAL_SMOOTHING);
+    }
+
+    samples_[head_] = sample_t{time, pos};
+    head_ = (head_ + 1) % CAPACITY;
+    if(count_ < CAPACITY)
+        count_++;
+}
+
+void PoseHistory::clear()
+{
+    head_ = count_ = 0;
+    interval_ = 0;
+}
+
+bool PoseHistory::empty() const
+{
+    return count_ == 0;
+}
+
+const PoseHistory::sample_t &PoseHistory::at(size_t i) const
+{
+    return samples_[(head_ + CAPACITY - count_ + i) % CAPACITY];
+}
+
+double PoseHistory::interval() const
+{
+    return interval_;
+}
+
+double PoseHistory::delay() const
+{
+    return interval_ < MAX_DELAY ? interval_ : MAX_DELAY;
+}
+
+double PoseHistory::latest_time() const
+{
+    return count_ > 0 ? at(count_ - 1).time : 0;
+}
+
+bool PoseHistory::sample(double time, BotSocket::SBotPosition &pos) const
+{
+    if(count_ == 0)
+        return false;
+
+    if(time <= at(0).time)
+    {
+        pos = at(0).pos;
+        return true;
+    }
+    if(time >= at(count_ - 1).time)
+    {
+        pos = at(count_ - 1).pos;
+        return true;
+    }
+
+    // newest samples are the most likely match
+    size_t i = count_ - 1;
+    while(at(i - 1).time > time)
+        i--;
+
+    const sample_t &a = at(i - 1), &b = at(i);
+    double span = b.time - a.time;
+    double k = span > 0 ? (time - a.time) / span : 1.;
+
+    // rotation steps between packets are small, per angle interpolation is enough
+    pos = BotSocket::SBotPosition(lerp(a.pos.globalPos.x, b.pos.globalPos.x, k),
+                                  lerp(a.pos.globalPos.y, b.pos.globalPos.y, k),
+                                  lerp(a.pos.globalPos.z, b.pos.globalPos.z, k),
+                                  lerp_angle(a.pos.globalRotation.x, b.pos.globalRotation.x, k),
+                                  lerp_angle(a.pos.globalRotation.y, b.pos.globalRotation.y, k),
+                                  lerp_angle(a.pos.globalRotation.z, b.pos.globalRotation.z, k));
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stddef.h>
+#include "bot_socket_types.h"
+
+// Timestamped laser head poses for display interpolation.
+// Poses arrive at the controller publish rate; sample() returns the pose at any
+// time in between, so the viewport can move the head at its own refresh rate.
+// Rendering is meant to lag by delay() to always have a pose on both sides.
+class PoseHistory
+{
+public:
+    static const size_t CAPACITY = 32;
+
+    void push(double time, const BotSocket::SBotPosition &pos);
+    void clear();
+    bool empty() const;
+
+    // interpolated pose, clamped to the oldest/newest sample; false if empty
+    bool sample(double time, BotSocket::SBotPosition &pos) const;
+
+    // smoothed interval between samples, s
+    double interval() const;
+    double delay() const;
+    double latest_time() const;
+
+private:
+    struct sample_t {
+        double time;
+        BotSocket::SBotPosition pos;
+    };
+
+    const sample_t &at(size_t i) const; // 0 is the oldest
+
+    sample_t samples_[CAPACITY];
+    size_t head_ = 0;  // next write index
+    size_t count_ = 0;
+    double interval_ = 0;
+};
@@ -0,0 +1,45 @@
+#include "pulse_reply_tracker.h"
+
+#include <algorithm>
+
+void PulseReplyTracker::reset(size_t points)
+{
+    current_.assign(points, 0);
+    stale_.assign(points, 0);
+}
+
+void PulseReplyTracker::on_point_sent(int sequence)
+{
+    stale_[sequence] += current_[sequence];
+    current_[sequence] = 0;
+}
+
+void PulseReplyTracker::on_pulse_sent(int sequence)
+{
+    current_[sequence]++;
+}
+
+// the relay answers in the order of the requests, the earlier sends come first
+PulseReplyTracker::reply_t PulseReplyTracker::on_reply(int sequence)
+{
+    if(sequence < 0 || static_cast<size_t>(sequence) >= current_.size())
+        return REPLY_UNEXPECTED;
+    if(stale_[sequence] > 0)
+    {
+        stale_[sequence]--;
+        return REPLY_STALE;
+    }
+    if(current_[sequence] > 0)
+    {
+        current_[sequence]--;
+        return REPLY_CURRENT;
+    }
+    return REPLY_UNEXPECTED;
+}
+
+bool PulseReplyTracker::pending() const
+{
+    const auto waiting = [](int count) { return count > 0; };
+    return std::any_of(current_.begin(), current_.end(), waiting) ||
+           std::any_of(stale_.begin(), stale_.end(), waiting);
+}
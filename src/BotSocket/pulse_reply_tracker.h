@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Replies expected for the output pulses of a trajectory, by point sequence.
+// Pulses go out right after their point, before it is acknowledged. A rejected
+// point is sent again with its pulses, while the replies to the first pulses are
+// still on the way; they come before the new ones and are told apart as stale.
+class PulseReplyTracker
+{
+public:
+    enum reply_t {
+        REPLY_CURRENT,      // to a pulse of the last send of the point
+        REPLY_STALE,        // to a pulse of an earlier send, to be dropped
+        REPLY_UNEXPECTED    // no pulse of the point is waiting for one
+    };
+
+    void reset(size_t points);
+    void on_point_sent(int sequence);   // before its pulses, the first send or a retry
+    void on_pulse_sent(int sequence);
+    reply_t on_reply(int sequence);
+    bool pending() const;               // any reply, stale ones too, not there yet
+
+private:
+    std::vector<int> current_;
+    std::vector<int> stale_;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// Single writer / many readers latest-value publication.
+// Writer never blocks, readers retry while a write is in progress.
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs trivially copyable type");
+
+public:
+    SeqLock() {
+        for(std::atomic<uint64_t> &w : data_)
+            w.store(0, std::memory_order_relaxed);
+    }
+
+    void store(const T &value) {
+        uint64_t words[WORDS] = {0};
+        memcpy(words, &value, sizeof(T));
+
+        unsigned seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for(size_t i=0; i<WORDS; i++)
+            data_[i].store(words[i], std::memory_order_relaxed);
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // returns version of the value, 0 if nothing was stored yet
+    unsigned load(T &value) const {
+        uint64_t words[WORDS];
+        unsigned seq0, seq1;
+        do {
+            seq0 = seq_.load(std::memory_order_acquire);
+            for(size_t i=0; i<WORDS; i++)
+                words[i] = data_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            seq1 = seq_.load(std::memory_order_relaxed);
+        } while((seq0 & 1) != 0 || seq0 != seq1);
+
+        memcpy(&value, words, sizeof(T));
+        return seq0 / 2;
+    }
+
+    unsigned version() const {
+        return seq_.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static const size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<unsigned> seq_{0};
+    std::atomic<uint64_t> data_[WORDS];
+};
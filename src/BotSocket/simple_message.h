@@ -21,7 +21,10 @@ namespace simple_message
         MSG_TYPE_JOINT_FEEDBACK     = 15,
         MSG_TYPE_READ_INPUT         = 20,
         MSG_TYPE_READ_OUTPUT        = 21,
-        MSG_TYPE_XYZWPR_TRAJ_PT     = 65010
+        MSG_TYPE_XYZWPR_TRAJ_PT     = 65010,
+        // relay extensions, like XYZWPR_TRAJ_PT
+        MSG_TYPE_WRITE_OUTPUT       = 65011,
+        MSG_TYPE_OUTPUT_PULSE       = 65012
     };
 
     enum COMM_TYPE: int_t {
@@ -50,6 +53,13 @@ namespace simple_message
         TRI_STATE_OFF     = 1,
     };
 
+    enum VALID_FIELD: int_t {
+        VALID_FIELD_TIME         = 0x01,
+        VALID_FIELD_POSITION     = 0x02,
+        VALID_FIELD_VELOCITY     = 0x04,
+        VALID_FIELD_ACCELERATION = 0x08
+    };
+
     enum MODE: int_t {
         MODE_UNKNOWN = -1,
         MODE_MANUAL  = 1,
@@ -67,6 +77,12 @@ namespace simple_message
         REPLY_CODE reply_code = REPLY_CODE_INVALID;
     };
 
+    // link check, carries no data
+    struct ping_t {
+        prefix_t prefix;
+        header_t header;
+    };
+
     struct joint_position_t {
         prefix_t prefix;
         header_t header;
@@ -99,6 +115,50 @@ namespace simple_message
         xyzwpr_t xyz_data;
     };
 
+    struct joint_feedback_t {
+        prefix_t prefix;
+        header_t header;
+        int_t    robot_id = 0;
+        int_t    valid_fields = 0; // VALID_FIELD mask
+        real_t   time = 0;
+        real_t   positions[10] = {0};
+        real_t   velocities[10] = {0};
+        real_t   accelerations[10] = {0};
+    };
+
+    // digital port by index, the reply carries its value
+    struct read_input_t {
+        prefix_t prefix;
+        header_t header;
+        int_t    index = 0;
+        int_t    value = 0;
+    };
+
+    struct read_output_t {
+        prefix_t prefix;
+        header_t header;
+        int_t    index = 0;
+        int_t    value = 0;
+    };
+
+    // the reply echoes the value set
+    struct write_output_t {
+        prefix_t prefix;
+        header_t header;
+        int_t    index = 0;
+        int_t    value = 0;
+    };
+
+    // Queued after the trajectory point with this sequence: once the robot is
+    // there the output is on for duration, then the motion goes on
+    struct output_pulse_t {
+        prefix_t prefix;
+        header_t header;
+        int_t    sequence = 0;
+        int_t    index = 0;
+        real_t   duration = 0; // s
+    };
+
     struct status_t {
         prefix_t prefix;
         header_t  header;
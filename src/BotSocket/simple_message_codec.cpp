@@ -0,0 +1,78 @@
+#include "simple_message_codec.h"
+
+namespace simple_message
+{
+
+static void read_header(reader &r, header_t &header)
+{
+    header.msg_type = r.get<MSG_TYPE>();
+    header.comm_type = r.get<COMM_TYPE>();
+    header.reply_code = r.get<REPLY_CODE>();
+}
+
+static void write_header(writer &w, const header_t &header)
+{
+    w.put(header.msg_type);
+    w.put(header.comm_type);
+    w.put(header.reply_code);
+}
+
+packet_view::packet_view(const char *data, size_t size, bool bigendian):
+    data_(data),
+    size_(size),
+    bigendian_(bigendian)
+{
+    if(size_ < sizeof(prefix_t) + sizeof(header_t))
+        return;
+
+    reader r(data_, bigendian_);
+    prefix_.length = r.get<int_t>();
+    read_header(r, header_);
+    valid_ = true;
+}
+
+bool packet_view::sequence(int_t &sequence) const
+{
+    switch(header_.msg_type)
+    {
+        case MSG_TYPE_JOINT_POSITION:
+            if(!length_valid(sizeof(joint_position_t)))
+                return false;
+            break;
+        case MSG_TYPE_JOINT_TRAJ_PT:
+            if(!length_valid(sizeof(joint_traj_pt_t)))
+                return false;
+            break;
+        case MSG_TYPE_XYZWPR_TRAJ_PT:
+            if(!length_valid(sizeof(xyzwpr_traj_pt_t)))
+                return false;
+            break;
+        case MSG_TYPE_OUTPUT_PULSE:
+            if(!length_valid(sizeof(output_pulse_t)))
+                return false;
+            break;
+        default:
+            return false;
+    }
+
+    reader r(data_ + sizeof(prefix_t) + sizeof(header_t), bigendian_);
+    sequence = r.get<int_t>();
+    return true;
+}
+
+size_t encode_reply(const packet_view &request, REPLY_CODE reply_code, char *buffer, size_t size)
+{
+    if(!request.valid() || size < request.size())
+        return 0;
+
+    header_t header = request.header();
+    header.comm_type = COMM_TYPE_SERVICE_REPLY;
+    header.reply_code = reply_code;
+
+    memcpy(buffer, request.data(), request.size());
+    writer w(buffer + sizeof(prefix_t), request.bigendian());
+    write_header(w, header);
+    return request.size();
+}
+
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+#include "simple_message.h"
+#include "simple_message_traits.h"
+
+// Wire format encoding/decoding of SimpleMessage packets.
+// Decoding reads fields straight from the receive buffer (it is never modified),
+// encoding writes into a caller provided buffer. Byte order is handled per word
+// as described by message_traits: every field follows the stream byte order except
+// xyzwpr_t::config, which the controller always sends in little endian.
+namespace simple_message
+{
+    // works with both floats and ints
+    template <typename T>
+    inline T bswap(T val) {
+        T retVal;
+        char *pVal = (char*) &val;
+        char *pRetVal = (char*)&retVal;
+        int size = sizeof(T);
+        for(int i=0; i<size; i++) {
+            pRetVal[size-1-i] = pVal[i];
+        }
+
+        return retVal;
+    }
+
+    inline uint32_t bswap32(uint32_t v) {
+        return (v >> 24) | ((v >> 8) & 0xff00u) | ((v << 8) & 0xff0000u) | (v << 24);
+    }
+
+    // Copy a message swapping the words marked in its swap_mask.
+    // Branch free fixed size loop, compilers turn it into byte shuffles.
+    template <typename Msg>
+    inline void swap_words(const char *src, char *dst) {
+        const uint64_t mask = swap_mask<Msg>();
+        uint32_t words[word_count<Msg>()];
+        memcpy(words, src, sizeof(Msg));
+        for(size_t i=0; i<word_count<Msg>(); i++)
+            words[i] = ((mask >> i) & 1) ? bswap32(words[i]) : words[i];
+        memcpy(dst, words, sizeof(Msg));
+    }
+
+    class reader
+    {
+    public:
+        reader(const char *data, bool bigendian): data_(data), bigendian_(bigendian) {}
+
+        template <typename T>
+        T get() {
+            T val;
+            memcpy(&val, data_, sizeof(T));
+            data_ += sizeof(T);
+            return bigendian_ ? bswap(val) : val;
+        }
+
+        template <typename T>
+        T get_raw() {
+            T val;
+            memcpy(&val, data_, sizeof(T));
+            data_ += sizeof(T);
+            return val;
+        }
+
+        template <typename T, size_t N>
+        void get(T (&vals)[N]) {
+            for(size_t i=0; i<N; i++)
+                vals[i] = get<T>();
+        }
+
+    private:
+        const char *data_;
+        bool bigendian_;
+    };
+
+    class writer
+    {
+    public:
+        writer(char *data, bool bigendian): data_(data), bigendian_(bigendian) {}
+
+        template <typename T>
+        void put(T val) {
+            if(bigendian_)
+                val = bswap(val);
+            memcpy(data_, &val, sizeof(T));
+            data_ += sizeof(T);
+        }
+
+        template <typename T>
+        void put_raw(T val) {
+            memcpy(data_, &val, sizeof(T));
+            data_ += sizeof(T);
+        }
+
+        template <typename T, size_t N>
+        void put(const T (&vals)[N]) {
+            for(size_t i=0; i<N; i++)
+                put(vals[i]);
+        }
+
+    private:
+        char *data_;
+        bool bigendian_;
+    };
+
+    // Read-only view of one framed packet (prefix included)
+    class packet_view
+    {
+    public:
+        packet_view(const char *data, size_t size, bool bigendian);
+
+        bool valid() const { return valid_; }
+        const char *data() const { return data_; }
+        size_t size() const { return size_; }
+        bool bigendian() const { return bigendian_; }
+        const prefix_t &prefix() const { return prefix_; }
+        const header_t &header() const { return header_; }
+
+        // false if packet length does not match the message type
+        template <typename Msg>
+        bool decode(Msg &msg) const {
+            if(!valid_ || !length_valid(sizeof(Msg)))
+                return false;
+            if(bigendian_)
+                swap_words<Msg>(data_, reinterpret_cast<char *>(&msg));
+            else
+                memcpy(&msg, data_, sizeof(Msg));
+            return true;
+        }
+
+        // sequence number of any trajectory/position message
+        bool sequence(int_t &sequence) const;
+
+    private:
+        bool length_valid(size_t msg_size) const {
+            return size_ == msg_size &&
+                   static_cast<size_t>(prefix_.length) + sizeof(prefix_t) == msg_size;
+        }
+
+        const char *data_;
+        size_t size_;
+        bool bigendian_;
+        bool valid_ = false;
+        prefix_t prefix_;
+        header_t header_;
+    };
+
+    // Encode message into buffer, prefix length and msg_type are filled in.
+    // Returns encoded size or 0 if buffer is too small.
+    template <typename Msg>
+    size_t encode(const Msg &msg, bool bigendian, char *buffer, size_t size) {
+        if(size < sizeof(Msg))
+            return 0;
+
+        Msg out = msg;
+        out.prefix.length = static_cast<int_t>(sizeof(Msg) - sizeof(prefix_t));
+        out.header.msg_type = message_traits<Msg>::type;
+        if(bigendian)
+            swap_words<Msg>(reinterpret_cast<const char *>(&out), buffer);
+        else
+            memcpy(buffer, &out, sizeof(Msg));
+        return sizeof(Msg);
+    }
+
+    // Encode the reply for a received service request, the payload is echoed back
+    size_t encode_reply(const packet_view &request, REPLY_CODE reply_code, char *buffer, size_t size);
+}
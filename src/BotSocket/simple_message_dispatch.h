@@ -0,0 +1,57 @@
+#pragma once
+
+#include <assert.h>
+#include "simple_message_codec.h"
+
+namespace simple_message
+{
+    // Table of message handlers indexed by msg_type.
+    // Handlers are member functions of Owner taking the decoded message:
+    //     table.add<status_t, &Owner::on_status>();
+    //     table.dispatch(owner, packet);
+    template <typename Owner>
+    class handler_table
+    {
+    public:
+        enum result_t {
+            HANDLED,
+            UNKNOWN_TYPE,
+            BAD_LENGTH
+        };
+
+        template <typename Msg, void (Owner::*Handler)(const Msg &)>
+        void add() {
+            assert(count_ < CAPACITY);
+            entries_[count_].type = message_traits<Msg>::type;
+            entries_[count_].invoke = &invoke<Msg, Handler>;
+            count_++;
+        }
+
+        result_t dispatch(Owner &owner, const packet_view &packet) const {
+            const MSG_TYPE type = packet.header().msg_type;
+            for(size_t i=0; i<count_; i++)
+                if(entries_[i].type == type)
+                    return entries_[i].invoke(owner, packet) ? HANDLED : BAD_LENGTH;
+            return UNKNOWN_TYPE;
+        }
+
+    private:
+        template <typename Msg, void (Owner::*Handler)(const Msg &)>
+        static bool invoke(Owner &owner, const packet_view &packet) {
+            Msg msg;
+            if(!packet.decode(msg))
+                return false;
+            (owner.*Handler)(msg);
+            return true;
+        }
+
+        struct entry_t {
+            MSG_TYPE type;
+            bool (*invoke)(Owner &owner, const packet_view &packet);
+        };
+
+        static const size_t CAPACITY = 16;
+        entry_t entries_[CAPACITY];
+        size_t count_ = 0;
+    };
+}
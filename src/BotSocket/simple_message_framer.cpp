@@ -0,0 +1,101 @@
+#include "simple_message_framer.h"
+#include <string.h>
+#include "simple_message_codec.h"
+#include "log/loguru.hpp"
+
+using namespace simple_message;
+
+const size_t SimpleMessageFramer::BUFFER_SIZE;
+const size_t SimpleMessageFramer::MAX_FRAME_SIZE;
+
+static_assert((SimpleMessageFramer::BUFFER_SIZE & (SimpleMessageFramer::BUFFER_SIZE - 1)) == 0,
+              "BUFFER_SIZE must be power of 2");
+static_assert(SimpleMessageFramer::MAX_FRAME_SIZE < SimpleMessageFramer::BUFFER_SIZE,
+              "frame must fit into buffer");
+
+SimpleMessageFramer::SimpleMessageFramer(bool bigendian):
+    bigendian_(bigendian)
+{
+}
+
+void SimpleMessageFramer::set_bigendian(bool bigendian)
+{
+    bigendian_ = bigendian;
+}
+
+void SimpleMessageFramer::reset()
+{
+    head_ = tail_ = 0;
+}
+
+size_t SimpleMessageFramer::used() const
+{
+    return tail_ - head_;
+}
+
+size_t SimpleMessageFramer::pending() const
+{
+    return used();
+}
+
+size_t SimpleMessageFramer::dropped() const
+{
+    return dropped_;
+}
+
+char *SimpleMessageFramer::write_ptr()
+{
+    return buffer_ + (tail_ & (BUFFER_SIZE - 1));
+}
+
+size_t SimpleMessageFramer::write_size() const
+{
+    size_t free_size = BUFFER_SIZE - used();
+    size_t till_end = BUFFER_SIZE - (tail_ & (BUFFER_SIZE - 1));
+    return free_size < till_end ? free_size : till_end;
+}
+
+void SimpleMessageFramer::commit(size_t size)
+{
+    tail_ += size;
+}
+
+int_t SimpleMessageFramer::peek_length() const
+{
+    char raw[sizeof(prefix_t)];
+    for(size_t i=0; i<sizeof(raw); i++)
+        raw[i] = buffer_[(head_ + i) & (BUFFER_SIZE - 1)];
+    return reader(raw, bigendian_).get<int_t>();
+}
+
+const char *SimpleMessageFramer::next_frame(size_t &size)
+{
+    if(used() < sizeof(prefix_t))
+        return nullptr;
+
+    int_t length = peek_length();
+    if(length < static_cast<int_t>(sizeof(header_t)) ||
+       static_cast<size_t>(length) + sizeof(prefix_t) > MAX_FRAME_SIZE)
+    {
+        // stream is out of sync, no way to find next frame boundary
+        LOG_F(ERROR, "Invalid frame length %d, dropping %zu bytes", length, used());
+        dropped_ += used();
+        reset();
+        return nullptr;
+    }
+
+    size = static_cast<size_t>(length) + sizeof(prefix_t);
+    if(used() < size)
+        return nullptr;
+
+    size_t offset = head_ & (BUFFER_SIZE - 1);
+    head_ += size;
+    if(offset + size <= BUFFER_SIZE)
+        return buffer_ + offset;
+
+    // frame wraps around the end of the buffer
+    size_t first = BUFFER_SIZE - offset;
+    memcpy(frame_, buffer_ + offset, first);
+    memcpy(frame_ + first, buffer_, size - first);
+    return frame_;
+}
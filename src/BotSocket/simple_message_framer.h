@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include "simple_message.h"
+
+// Incremental length-prefix decoder for a SimpleMessage byte stream.
+// Incoming bytes are written straight into a fixed ring buffer (see write_ptr/commit),
+// then every complete frame is pulled out with next_frame(). Bytes of an incomplete
+// frame stay in the buffer until the rest of it arrives. No heap allocations after
+// construction.
+class SimpleMessageFramer
+{
+public:
+    static const size_t BUFFER_SIZE = 64 * 1024; // must be power of 2
+    static const size_t MAX_FRAME_SIZE = 1024;
+
+    explicit SimpleMessageFramer(bool bigendian = false);
+
+    void set_bigendian(bool bigendian);
+    void reset();
+
+    // contiguous free space to read socket data into
+    char *write_ptr();
+    size_t write_size() const;
+    void commit(size_t size);
+
+    // returns next complete frame (prefix included) or nullptr;
+    // pointer is valid until the next call of commit()/next_frame()
+    const char *next_frame(size_t &size);
+
+    size_t pending() const;
+    size_t dropped() const;
+
+private:
+    size_t used() const;
+    simple_message::int_t peek_length() const;
+
+    char buffer_[BUFFER_SIZE];
+    char frame_[MAX_FRAME_SIZE];
+    size_t head_ = 0, tail_ = 0; // free running, masked on access
+    size_t dropped_ = 0;
+    bool bigendian_ = false;
+};
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+#include "simple_message.h"
+
+// Compile-time layout description of SimpleMessage packets.
+// Every message is a sequence of 4 byte words. A field lists the words it occupies
+// and whether they follow the stream byte order; byte swapping code is generated
+// from these descriptors (see swap_mask() and simple_message_codec.h).
+//
+// To add a message type: define the packed struct in simple_message.h, specialize
+// message_traits with its type and fields, and add the wire size check below.
+namespace simple_message
+{
+    struct field_t {
+        size_t offset;
+        size_t size;
+        bool   swap; // false for fields sent in little endian regardless of stream order
+    };
+
+    template <typename Msg>
+    struct message_traits;
+
+#define SIMPLE_MESSAGE_FIELD(msg, member) \
+    field_t{offsetof(msg, member), sizeof(static_cast<msg *>(nullptr)->member), true}
+#define SIMPLE_MESSAGE_RAW_FIELD(msg, member) \
+    field_t{offsetof(msg, member), sizeof(static_cast<msg *>(nullptr)->member), false}
+
+    template <>
+    struct message_traits<ping_t> {
+        static constexpr MSG_TYPE type = MSG_TYPE_PING;
+        static constexpr std::array<field_t, 2> fields() {
+            return {{
+                SIMPLE_MESSAGE_FIELD(ping_t, prefix),
+                SIMPLE_MESSAGE_FIELD(ping_t, header)
+            }};
+        }
+    };
+
+    template <>
+    struct message_traits<joint_position_t> {
+        static constexpr MSG_TYPE type = MSG_TYPE_JOINT_POSITION;
+        static constexpr std::array<field_t, 4> fields() {
+            return {{
+                SIMPLE_MESSAGE_FIELD(joint_position_t, prefix),
+                SIMPLE_MESSAGE_FIELD(joint_position_t, header),
+                SIMPLE_MESSAGE_FIELD(joint_position_t, sequence),
+                SIMPLE_MESSAGE_FIELD(joint_position_t, joint_data)
+            }};
+        }
+    };
+
+    template <>
+    struct message_traits<joint_traj_pt_t> {
+        static constexpr MSG_TYPE type = MSG_TYPE_JOINT_TRAJ_PT;
+        static constexpr std::array<field_t, 6> fields() {
+            return {{
+                SIMPLE_MESSAGE_FIELD(joint_traj_pt_t, prefix),
+                SIMPLE_MESSAGE_FIELD(joint_traj_pt_t, header),
+                SIMPLE_MESSAGE_FIELD(joint_traj_pt_t, sequence),
+                SIMPLE_MESSAGE_FIELD(joint_traj_pt_t, joint_data),
+                SIMPLE_MESSAGE_FIELD(joint_traj_pt_t, velocity),
+                SIMPLE_MESSAGE_FIELD(joint_traj_pt_t, duration)
+            }};
+        }
+    };
+
+    template <>
+    struct message_traits<xyzwpr_traj_pt_t> {
+        static constexpr MSG_TYPE type = MSG_TYPE_XYZWPR_TRAJ_PT;
+        static constexpr std::array<field_t, 10> fields() {
+            return {{
+                SIMPLE_MESSAGE_FIELD(xyzwpr_traj_pt_t, prefix),
+                SIMPLE_MESSAGE_FIELD(xyzwpr_traj_pt_t, header),
+                SIMPLE_MESSAGE_FIELD(xyzwpr_traj_pt_t, sequence),
+                SIMPLE_MESSAGE_FIELD(xyzwpr_traj_pt_t, joint_data),
+                SIMPLE_MESSAGE_FIELD(xyzwpr_traj_pt_t, velocity),
+                SIMPLE_MESSAGE_FIELD(xyzwpr_traj_pt_t, duration),
+                SIMPLE_MESSAGE_FIELD(xyzwpr_traj_pt_t, xyz_data.prefix1),
+                SIMPLE_MESSAGE_FIELD(xyzwpr_traj_pt_t, xyz_data.prefix2),
+                SIMPLE_MESSAGE_FIELD(xyzwpr_traj_pt_t, xyz_data.xyzwpr),
+                SIMPLE_MESSAGE_RAW_FIELD(xyzwpr_traj_pt_t, xyz_data.config) // controller never swaps it
+            }};
+        }
+    };
+
+    template <>
+    struct message_traits<joint_feedback_t> {
+        static constexpr MSG_TYPE type = MSG_TYPE_JOINT_FEEDBACK;
+        static constexpr std::array<field_t, 8> fields() {
+            return {{
+                SIMPLE_MESSAGE_FIELD(joint_feedback_t, prefix),
+                SIMPLE_MESSAGE_FIELD(joint_feedback_t, header),
+                SIMPLE_MESSAGE_FIELD(joint_feedback_t, robot_id),
+                SIMPLE_MESSAGE_FIELD(joint_feedback_t, valid_fields),
+                SIMPLE_MESSAGE_FIELD(joint_feedback_t, time),
+                SIMPLE_MESSAGE_FIELD(joint_feedback_t, positions),
+                SIMPLE_MESSAGE_FIELD(joint_feedback_t, velocities),
+                SIMPLE_MESSAGE_FIELD(joint_feedback_t, accelerations)
+            }};
+        }
+    };
+
+    template <>
+    struct message_traits<status_t> {
+        static constexpr MSG_TYPE type = MSG_TYPE_STATUS;
+        static constexpr std::array<field_t, 9> fields() {
+            return {{
+                SIMPLE_MESSAGE_FIELD(status_t, prefix),
+                SIMPLE_MESSAGE_FIELD(status_t, header),
+                SIMPLE_MESSAGE_FIELD(status_t, drives_powered),
+                SIMPLE_MESSAGE_FIELD(status_t, e_stopped),
+                SIMPLE_MESSAGE_FIELD(status_t, error_code),
+                SIMPLE_MESSAGE_FIELD(status_t, in_error),
+                SIMPLE_MESSAGE_FIELD(status_t, in_motion),
+                SIMPLE_MESSAGE_FIELD(status_t, mode),
+                SIMPLE_MESSAGE_FIELD(status_t, motion_possible)
+            }};
+        }
+    };
+
+    template <>
+    struct message_traits<read_input_t> {
+        static constexpr MSG_TYPE type = MSG_TYPE_READ_INPUT;
+        static constexpr std::array<field_t, 4> fields() {
+            return {{
+                SIMPLE_MESSAGE_FIELD(read_input_t, prefix),
+                SIMPLE_MESSAGE_FIELD(read_input_t, header),
+                SIMPLE_MESSAGE_FIELD(read_input_t, index),
+                SIMPLE_MESSAGE_FIELD(read_input_t, value)
+            }};
+        }
+    };
+
+    template <>
+    struct message_traits<read_output_t> {
+        static constexpr MSG_TYPE type = MSG_TYPE_READ_OUTPUT;
+        static constexpr std::array<field_t, 4> fields() {
+            return {{
+                SIMPLE_MESSAGE_FIELD(read_output_t, prefix),
+                SIMPLE_MESSAGE_FIELD(read_output_t, header),
+                SIMPLE_MESSAGE_FIELD(read_output_t, index),
+                SIMPLE_MESSAGE_FIELD(read_output_t, value)
+            }};
+        }
+    };
+
+    template <>
+    struct message_traits<write_output_t> {
+        static constexpr MSG_TYPE type = MSG_TYPE_WRITE_OUTPUT;
+        static constexpr std::array<field_t, 4> fields() {
+            return {{
+                SIMPLE_MESSAGE_FIELD(write_output_t, prefix),
+                SIMPLE_MESSAGE_FIELD(write_output_t, header),
+                SIMPLE_MESSAGE_FIELD(write_output_t, index),
+                SIMPLE_MESSAGE_FIELD(write_output_t, value)
+            }};
+        }
+    };
+
+    template <>
+    struct message_traits<output_pulse_t> {
+        static constexpr MSG_TYPE type = MSG_TYPE_OUTPUT_PULSE;
+        static constexpr std::array<field_t, 5> fields() {
+            return {{
+                SIMPLE_MESSAGE_FIELD(output_pulse_t, prefix),
+                SIMPLE_MESSAGE_FIELD(output_pulse_t, header),
+                SIMPLE_MESSAGE_FIELD(output_pulse_t, sequence),
+                SIMPLE_MESSAGE_FIELD(output_pulse_t, index),
+                SIMPLE_MESSAGE_FIELD(output_pulse_t, duration)
+            }};
+        }
+    };
+
+#undef SIMPLE_MESSAGE_FIELD
+#undef SIMPLE_MESSAGE_RAW_FIELD
+
+    // fields are contiguous, word aligned and cover the whole struct
+    template <typename Msg>
+    constexpr bool layout_valid() {
+        const auto fields = message_traits<Msg>::fields();
+        size_t offset = 0;
+        for(size_t i=0; i<fields.size(); i++) {
+            if(fields[i].offset != offset || fields[i].size % sizeof(int_t) != 0)
+                return false;
+            offset += fields[i].size;
+        }
+        return offset == sizeof(Msg);
+    }
+
+    // bit i is set if word i follows the stream byte order
+    template <typename Msg>
+    constexpr uint64_t swap_mask() {
+        const auto fields = message_traits<Msg>::fields();
+        uint64_t mask = 0;
+        for(size_t i=0; i<fields.size(); i++) {
+            if(!fields[i].swap)
+                continue;
+            for(size_t w=0; w<fields[i].size / sizeof(int_t); w++)
+                mask |= uint64_t(1) << (fields[i].offset / sizeof(int_t) + w);
+        }
+        return mask;
+    }
+
+    template <typename Msg>
+    constexpr size_t word_count() {
+        return sizeof(Msg) / sizeof(int_t);
+    }
+
+#define SIMPLE_MESSAGE_CHECK(msg, wire_size) \
+    static_assert(sizeof(msg) == (wire_size), #msg " does not match the wire size"); \
+    static_assert(layout_valid<msg>(), #msg " fields do not cover the struct"); \
+    static_assert(word_count<msg>() <= 64, #msg " is too large for swap_mask")
+
+    SIMPLE_MESSAGE_CHECK(ping_t, 16);
+    SIMPLE_MESSAGE_CHECK(joint_position_t, 60);
+    SIMPLE_MESSAGE_CHECK(joint_traj_pt_t, 68);
+    SIMPLE_MESSAGE_CHECK(xyzwpr_traj_pt_t, 104);
+    SIMPLE_MESSAGE_CHECK(joint_feedback_t, 148);
+    SIMPLE_MESSAGE_CHECK(status_t, 44);
+    SIMPLE_MESSAGE_CHECK(read_input_t, 24);
+    SIMPLE_MESSAGE_CHECK(read_output_t, 24);
+    SIMPLE_MESSAGE_CHECK(write_output_t, 24);
+    SIMPLE_MESSAGE_CHECK(output_pulse_t, 28);
+
+#undef SIMPLE_MESSAGE_CHECK
+}
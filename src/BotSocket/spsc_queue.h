@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+// Bounded single producer / single consumer queue
+template <typename T, size_t N>
+class SpscQueue
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be power of 2");
+
+public:
+    // false if queue is full
+    bool push(const T &value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if(tail - head_.load(std::memory_order_acquire) == N)
+            return false;
+        items_[tail & (N - 1)] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // false if queue is empty
+    bool pop(T &value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if(head == tail_.load(std::memory_order_acquire))
+            return false;
+        value = items_[head & (N - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    T items_[N];
+    std::atomic<size_t> head_{0}, tail_{0};
+};
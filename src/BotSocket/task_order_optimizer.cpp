@@ -0,0 +1,278 @@
+#include "task_order_optimizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const double EPSILON = 1e-9;
+
+// Open path over a local cost matrix. Node 0 is the fixed start, the last node is
+// the fixed end if the segment has one, the rest can be moved.
+class Segment
+{
+public:
+    Segment(const std::vector<size_t> &nodes, bool fixed_end, const TaskOrderOptimizer::cost_t &cost) :
+        nodes_(nodes),
+        size_(nodes.size()),
+        fixed_end_(fixed_end),
+        cost_(size_ * size_, 0)
+    {
+        for (size_t a = 0; a < size_; ++a)
+            for (size_t b = a + 1; b < size_; ++b)
+                cost_[a * size_ + b] = cost_[b * size_ + a] = cost(nodes[a], nodes[b]);
+    }
+
+    // the nodes in the order they were given
+    void given_order()
+    {
+        tour_.resize(size_);
+        for (size_t i = 0; i < size_; ++i)
+            tour_[i] = i;
+    }
+
+    double tour_cost() const
+    {
+        double result = 0;
+        for (size_t i = 1; i < tour_.size(); ++i)
+            result += cost(tour_[i - 1], tour_[i]);
+        return result;
+    }
+
+    // greedy tour from the start, the fixed end stays last
+    void nearest_neighbour()
+    {
+        const size_t free_end = fixed_end_ ? size_ - 1 : size_;
+        std::vector<bool> used(size_, false);
+        tour_.assign(1, 0);
+        used[0] = true;
+        for (size_t step = 1; step < free_end; ++step)
+        {
+            const size_t from = tour_.back();
+            size_t best = 0;
+            double best_cost = std::numeric_limits<double>::infinity();
+            for (size_t n = 1; n < free_end; ++n)
+                if (!used[n] && (best == 0 || cost(from, n) < best_cost))
+                {
+                    best = n;
+                    best_cost = cost(from, n);
+                }
+            used[best] = true;
+            tour_.push_back(best);
+        }
+        if (fixed_end_)
+            tour_.push_back(size_ - 1);
+    }
+
+    // reverses tour_[i..j] if that shortens the path
+    template <typename Stop>
+    bool two_opt(const Stop &stop)
+    {
+        bool improved = false;
+        const size_t last = last_free();
+        for (size_t i = 1; i < last; ++i)
+        {
+            if (stop())
+                return improved;
+            for (size_t j = i + 1; j <= last; ++j)
+            {
+                const size_t prev = tour_[i - 1];
+                const double removed = cost(prev, tour_[i]) + next_cost(tour_[j], j + 1);
+                const double added = cost(prev, tour_[j]) + next_cost(tour_[i], j + 1);
+                if (added < removed - EPSILON)
+                {
+                    std::reverse(tour_.begin() + i, tour_.begin() + j + 1);
+                    improved = true;
+                }
+            }
+        }
+        return improved;
+    }
+
+    // moves a run of up to three points, possibly reversed, to a better place
+    template <typename Stop>
+    bool or_opt(const Stop &stop)
+    {
+        bool improved = false;
+        for (size_t len = 1; len <= 3; ++len)
+        {
+            for (size_t i = 1; i + len - 1 <= last_free(); ++i)
+            {
+                if (stop())
+                    return improved;
+                const size_t first = tour_[i], last = tour_[i + len - 1];
+                const size_t prev = tour_[i - 1];
+                // path without the run
+                const double gain = cost(prev, first) + next_cost(last, i + len)
+                                  - next_cost(prev, i + len);
+
+                double best = -EPSILON;
+                size_t best_pos = 0;
+                bool best_reversed = false;
+                // the run goes between tour_[p] and tour_[p + 1]
+                const size_t end = fixed_end_ ? size_ - 1 : size_;
+                for (size_t p = 0; p < end; ++p)
+                {
+                    if (p + 1 >= i && p < i + len)
+                        continue;
+                    const double edge = next_cost(tour_[p], p + 1);
+                    const double forward = cost(tour_[p], first) + next_cost(last, p + 1) - edge;
+                    const double backward = cost(tour_[p], last) + next_cost(first, p + 1) - edge;
+                    if (forward - gain < best)
+                    {
+                        best = forward - gain;
+                        best_pos = p;
+                        best_reversed = false;
+                    }
+                    if (backward - gain < best)
+                    {
+                        best = backward - gain;
+                        best_pos = p;
+                        best_reversed = true;
+                    }
+                }
+                if (best < -EPSILON)
+                {
+                    std::vector<size_t> run(tour_.begin() + i, tour_.begin() + i + len);
+                    if (best_reversed)
+                        std::reverse(run.begin(), run.end());
+                    tour_.erase(tour_.begin() + i, tour_.begin() + i + len);
+                    const size_t insert = best_pos < i ? best_pos + 1 : best_pos + 1 - len;
+                    tour_.insert(tour_.begin() + insert, run.begin(), run.end());
+                    improved = true;
+                }
+            }
+        }
+        return improved;
+    }
+
+    // input indices, the fixed end excluded (it starts the next segment)
+    void append_order(std::vector<size_t> &order) const
+    {
+        const size_t count = fixed_end_ ? tour_.size() - 1 : tour_.size();
+        for (size_t i = 0; i < count; ++i)
+            order.push_back(nodes_[tour_[i]]);
+    }
+
+private:
+    double cost(size_t a, size_t b) const { return cost_[a * size_ + b]; }
+
+    // cost from node to the tour position pos, nothing past the open end
+    double next_cost(size_t node, size_t pos) const
+    {
+        return pos < tour_.size() ? cost(node, tour_[pos]) : 0;
+    }
+
+    size_t last_free() const { return fixed_end_ ? tour_.size() - 2 : tour_.size() - 1; }
+
+    std::vector<size_t> nodes_;
+    size_t size_;
+    bool fixed_end_;
+    std::vector<double> cost_;
+    std::vector<size_t> tour_;
+};
+
+double path_cost(const std::vector<size_t> &order, const TaskOrderOptimizer::cost_t &cost)
+{
+    double result = 0;
+    for (size_t i = 1; i < order.size(); ++i)
+        result += cost(order[i - 1], order[i]);
+    return result;
+}
+
+}
+
+void TaskOrderOptimizer::set_cost(const cost_t &cost)
+{
+    cost_ = cost;
+}
+
+void TaskOrderOptimizer::set_time_budget(double seconds)
+{
+    budget_ = seconds;
+}
+
+void TaskOrderOptimizer::set_cancel(const std::atomic<bool> *cancel)
+{
+    cancel_ = cancel;
+}
+
+bool TaskOrderOptimizer::fixed(const std::vector<GUI_TYPES::STaskPoint> &points, size_t i)
+{
+    return i == 0 || points[i].bUseHomePnt || points[i].bNeedCalib;
+}
+
+TaskOrderOptimizer::result_t TaskOrderOptimizer::optimize(const std::vector<GUI_TYPES::STaskPoint> &points) const
+{
+    typedef std::chrono::steady_clock clock;
+    const clock::time_point deadline = clock::now() + std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double>(budget_ > 0 ? budget_ : 0));
+    bool stopped = false;
+    const auto stop = [&]() {
+        if (!stopped)
+            stopped = (cancel_ && cancel_->load()) || (budget_ > 0 && clock::now() >= deadline);
+        return stopped;
+    };
+
+    result_t result;
+    std::vector<size_t> input(points.size());
+    for (size_t i = 0; i < input.size(); ++i)
+        input[i] = i;
+    result.before = path_cost(input, cost_);
+
+    size_t start = 0;
+    while (start < points.size())
+    {
+        size_t end = start + 1;
+        while (end < points.size() && !fixed(points, end))
+            ++end;
+        const bool fixed_end = end < points.size();
+        std::vector<size_t> nodes(input.begin() + start, input.begin() + (fixed_end ? end + 1 : end));
+
+        Segment segment(nodes, fixed_end, cost_);
+        segment.given_order();
+        const double given = segment.tour_cost();
+        segment.nearest_neighbour();
+        // a hand tuned order may beat the greedy one, the search never ends above its start
+        if (segment.tour_cost() >= given)
+            segment.given_order();
+        while (!stop() && (segment.two_opt(stop) | segment.or_opt(stop)))
+            ;
+        segment.append_order(result.order);
+        start = end;
+    }
+
+    result.after = path_cost(result.order, cost_);
+    result.complete = !stopped;
+    return result;
+}
+
+std::vector<GUI_TYPES::STaskPoint> TaskOrderOptimizer::reorder(const std::vector<GUI_TYPES::STaskPoint> &points,
+                                                               const std::vector<size_t> &order)
+{
+    std::vector<GUI_TYPES::STaskPoint> result;
+    result.reserve(order.size());
+    for (const size_t i : order)
+        result.push_back(points[i]);
+    return result;
+}
+
+TaskOrderOptimizer::cost_t TaskOrderOptimizer::distance_cost(const std::vector<GUI_TYPES::STaskPoint> &points)
+{
+    std::vector<GUI_TYPES::SVertex> positions;
+    positions.reserve(points.size());
+    for (const GUI_TYPES::STaskPoint &p : points)
+        positions.push_back(p.globalPos);
+    return [positions](size_t from, size_t to) {
+        const GUI_TYPES::SVertex &a = positions[from], &b = positions[to];
+        return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z));
+    };
+}
+
+TaskOrderOptimizer::cost_t TaskOrderOptimizer::time_cost(const std::vector<joint_data> &joints, const CycleTimeModel &model)
+{
+    return [joints, model](size_t from, size_t to) {
+        return model.move_time(joints[from], joints[to]);
+    };
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "cycle_time_model.h"
+#include "../gui_types.h"
+
+// Reorders task points to shorten the travel between them.
+// The first point, points after a home move (bUseHomePnt) and calibration points
+// (bNeedCalib) stay where they are and split the list into segments; the points
+// between two of them are free. Every segment starts as a nearest neighbour tour
+// from its first point, or in the given order if that is not longer, and is
+// improved by 2-opt and Or-opt (moving runs of up to three points) until no move
+// helps or the time budget runs out, so it never gets longer. A segment ends at
+// the next fixed point, the last one is open. The cost of a move has to be
+// symmetric: cost(a, b) == cost(b, a).
+class TaskOrderOptimizer
+{
+public:
+    typedef std::function<double(size_t from, size_t to)> cost_t; // indices of the input points
+
+    struct result_t {
+        std::vector<size_t> order;  // input indices in the new order
+        double before = 0;          // sum of costs in the input order
+        double after = 0;
+        bool complete = false;      // local optimum reached, not stopped by the budget
+    };
+
+    void set_cost(const cost_t &cost);
+    void set_time_budget(double seconds);               // <= 0 - unlimited
+    void set_cancel(const std::atomic<bool> *cancel);   // checked between moves
+
+    result_t optimize(const std::vector<GUI_TYPES::STaskPoint> &points) const;
+
+    static bool fixed(const std::vector<GUI_TYPES::STaskPoint> &points, size_t i);
+    static std::vector<GUI_TYPES::STaskPoint> reorder(const std::vector<GUI_TYPES::STaskPoint> &points,
+                                                      const std::vector<size_t> &order);
+
+    // mm between globalPos
+    static cost_t distance_cost(const std::vector<GUI_TYPES::STaskPoint> &points);
+    // s of the joint move between the solutions of the points
+    static cost_t time_cost(const std::vector<joint_data> &joints, const CycleTimeModel &model);
+
+private:
+    cost_t cost_;
+    double budget_ = 1;
+    const std::atomic<bool> *cancel_ = nullptr;
+};
@@ -0,0 +1,217 @@
+#include "tool_spin_planner.h"
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+
+static const double DEG = M_PI / 180.;
+
+const size_t ToolSpinPlanner::npos;
+
+void ToolSpinPlanner::set_steps(int steps)
+{
+    steps_ = steps;
+}
+
+void ToolSpinPlanner::set_kinematics(const OpwKinematics *kinematics)
+{
+    kinematics_ = kinematics;
+}
+
+void ToolSpinPlanner::set_poses(const std::vector<xyzwpr_data> &poses, const std::vector<bool> &symmetric)
+{
+    candidates_.clear();
+    spins_.clear();
+    first_.clear();
+    for(size_t i=0; i<poses.size(); i++)
+    {
+        first_.push_back(candidates_.size());
+        const int count = i < symmetric.size() && symmetric[i] && steps_ > 1 ? steps_ : 1;
+        // no turn first, it wins the ties
+        for(int k=0; k<count; k++)
+        {
+            const double spin = remainder(360. * k / count, 360.);
+            candidates_.push_back(turned(poses[i], spin));
+            spins_.push_back(spin);
+        }
+    }
+    first_.push_back(candidates_.size());
+    solutions_.assign(kinematics_ ? candidates_.size() : 0, OpwKinematics::solutions_t());
+}
+
+size_t ToolSpinPlanner::candidate_count() const
+{
+    return candidates_.size();
+}
+
+void ToolSpinPlanner::solve(size_t first, size_t last)
+{
+    if(!kinematics_)
+        return;
+    for(size_t i=first; i<last && i<candidates_.size(); i++)
+        solutions_[i] = kinematics_->inverse(OpwKinematics::to_isometry(candidates_[i]));
+}
+
+ToolSpinPlanner::result_t ToolSpinPlanner::plan(const joint_data &start) const
+{
+    return plan(&start, nullptr);
+}
+
+ToolSpinPlanner::result_t ToolSpinPlanner::plan(const xyzwpr_data &start) const
+{
+    return plan(nullptr, &start);
+}
+
+xyzwpr_data ToolSpinPlanner::turned(const xyzwpr_data &pose, double spin)
+{
+    if(spin == 0)
+        return pose;
+    Eigen::Isometry3d frame = OpwKinematics::to_isometry(pose);
+    frame.linear() = frame.linear() * Eigen::AngleAxisd(spin * DEG, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+    xyzwpr_data result = pose;
+    result.xyzwpr = OpwKinematics::to_xyzwpr(frame).xyzwpr;
+    return result;
+}
+
+double ToolSpinPlanner::joint_cost(const joint_data &from, const joint_data &to) const
+{
+    const OpwKinematics::parameters_t &p = kinematics_->parameters();
+    double cost = 0;
+    for(int i=0; i<6; i++)
+    {
+        double d = to[i] - from[i];
+        if(p.joint_max[i] - p.joint_min[i] >= 360)
+            d = remainder(d, 360.);
+        cost += d * d;
+    }
+    return cost;
+}
+
+// the most specific error of the candidates, as select() reports it for one pose
+static OpwKinematics::error_t worse(OpwKinematics::error_t a, OpwKinematics::error_t b)
+{
+    return std::max(a, b);
+}
+
+void ToolSpinPlanner::make_states(size_t point, std::vector<state_t> &states, OpwKinematics::error_t &error) const
+{
+    states.clear();
+    error = OpwKinematics::IK_UNREACHABLE;
+    for(size_t c=first_[point]; c<first_[point + 1]; c++)
+    {
+        if(!kinematics_)
+        {
+            states.push_back(state_t{c, joint_data()});
+            continue;
+        }
+        for(const joint_data &solution : solutions_[c])
+        {
+            // one configuration at a time, select() checks the limits and singularities
+            OpwKinematics::solutions_t pinned;
+            pinned.fill(joint_data{{NAN, NAN, NAN, NAN, NAN, NAN}});
+            pinned[0] = solution;
+            state_t state{c, joint_data()};
+            const OpwKinematics::error_t e = kinematics_->select(pinned, solution, state.joints);
+            if(e == OpwKinematics::IK_OK)
+                states.push_back(state);
+            else
+                error = worse(error, e);
+        }
+    }
+    if(!states.empty())
+        error = OpwKinematics::IK_OK;
+}
+
+ToolSpinPlanner::result_t ToolSpinPlanner::plan(const joint_data *start_joints, const xyzwpr_data *start_pose) const
+{
+    result_t result;
+    const size_t count = first_.empty() ? 0 : first_.size() - 1;
+    if(count == 0)
+        return result;
+
+    std::vector<Eigen::Quaterniond> turns;
+    if(!kinematics_)
+    {
+        turns.reserve(candidates_.size());
+        for(const xyzwpr_data &pose : candidates_)
+            turns.emplace_back(OpwKinematics::to_isometry(pose).linear());
+    }
+    const auto cost = [this, &turns](const state_t &from, const state_t &to) {
+        if(kinematics_)
+            return joint_cost(from.joints, to.joints);
+        const double angle = turns[from.candidate].angularDistance(turns[to.candidate]) / DEG;
+        return angle * angle;
+    };
+
+    std::vector<std::vector<state_t>> states(count);
+    std::vector<std::vector<double>> totals(count);
+    std::vector<std::vector<size_t>> back(count);
+    for(size_t i=0; i<count; i++)
+    {
+        OpwKinematics::error_t error;
+        make_states(i, states[i], error);
+        if(states[i].empty())
+        {
+            result.failed = i;
+            result.error = error;
+            return result;
+        }
+
+        totals[i].assign(states[i].size(), 0);
+        back[i].assign(states[i].size(), npos);
+        for(size_t s=0; s<states[i].size(); s++)
+        {
+            const state_t &state = states[i][s];
+            if(i == 0)
+            {
+                if(kinematics_ && start_joints)
+                    totals[i][s] = joint_cost(*start_joints, state.joints);
+                else if(!kinematics_ && start_pose)
+                {
+                    const Eigen::Quaterniond start(OpwKinematics::to_isometry(*start_pose).linear());
+                    const double angle = start.angularDistance(turns[state.candidate]) / DEG;
+                    totals[i][s] = angle * angle;
+                }
+                continue;
+            }
+
+            double best = std::numeric_limits<double>::infinity();
+            for(size_t p=0; p<states[i - 1].size(); p++)
+            {
+                const double total = totals[i - 1][p] + cost(states[i - 1][p], state);
+                if(total < best)
+                {
+                    best = total;
+                    back[i][s] = p;
+                }
+            }
+            totals[i][s] = best;
+        }
+    }
+
+    std::vector<size_t> path(count);
+    path[count - 1] = static_cast<size_t>(std::min_element(totals[count - 1].begin(), totals[count - 1].end()) -
+                                          totals[count - 1].begin());
+    result.cost = totals[count - 1][path[count - 1]];
+    for(size_t i=count - 1; i>0; i--)
+        path[i - 1] = back[i][path[i]];
+
+    joint_data seed = start_joints ? *start_joints : states[0][path[0]].joints;
+    for(size_t i=0; i<count; i++)
+    {
+        const state_t &state = states[i][path[i]];
+        result.poses.push_back(candidates_[state.candidate]);
+        result.spins.push_back(spins_[state.candidate]);
+        if(!kinematics_)
+            continue;
+
+        // the same configuration on the turn of the joints nearest to the previous point
+        OpwKinematics::solutions_t pinned;
+        pinned.fill(joint_data{{NAN, NAN, NAN, NAN, NAN, NAN}});
+        pinned[0] = state.joints;
+        joint_data joints = state.joints;
+        kinematics_->select(pinned, seed, joints);
+        result.joints.push_back(joints);
+        seed = joints;
+    }
+    return result;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+#include "fanuc_socket_types.h"
+#include "opw_kinematics.h"
+
+// Turns of axially symmetric tools (STaskPoint::zSimmetry) about their Z axis.
+// Every symmetric point gets steps candidate poses turned by 360 / steps deg, the
+// others keep their pose. A Viterbi pass over the whole sequence picks one state per
+// point so that the sum of moves between neighbours is the smallest, starting from
+// where the robot stands. A move costs the sum of squared joint differences in deg,
+// the measure of OpwKinematics::select(); without kinematics it is the squared
+// angle between the tool orientations. With kinematics a state is a candidate and
+// one of its arm configurations, joints that can turn past 360 deg are compared
+// over the shorter way and take that turn in the result.
+class ToolSpinPlanner
+{
+public:
+    static const size_t npos = std::numeric_limits<size_t>::max();
+
+    struct result_t {
+        std::vector<xyzwpr_data> poses;     // turned input poses
+        std::vector<joint_data> joints;     // joints of poses, empty without kinematics
+        std::vector<double> spins;          // deg about the tool Z of every pose
+        size_t failed = npos;               // first point without a solution
+        OpwKinematics::error_t error = OpwKinematics::IK_OK;
+        double cost = 0;                    // of the chosen path
+    };
+
+    void set_steps(int steps);                              // < 2 - no turns
+    void set_kinematics(const OpwKinematics *kinematics);   // nullptr - orientation cost
+
+    // symmetric[i] - poses[i] may turn about its Z
+    void set_poses(const std::vector<xyzwpr_data> &poses, const std::vector<bool> &symmetric);
+
+    // inverse kinematics of candidates [first, last), ranges may be solved in parallel
+    size_t candidate_count() const;
+    void solve(size_t first, size_t last);
+
+    // after every candidate is solved; joints are the start with kinematics, the pose without
+    result_t plan(const joint_data &start) const;
+    result_t plan(const xyzwpr_data &start) const;
+
+    static xyzwpr_data turned(const xyzwpr_data &pose, double spin);
+
+private:
+    struct state_t {
+        size_t candidate;
+        joint_data joints;
+    };
+
+    double joint_cost(const joint_data &from, const joint_data &to) const;
+    void make_states(size_t point, std::vector<state_t> &states, OpwKinematics::error_t &error) const;
+    result_t plan(const joint_data *start_joints, const xyzwpr_data *start_pose) const;
+
+    int steps_ = 24;
+    const OpwKinematics *kinematics_ = nullptr;
+    std::vector<xyzwpr_data> candidates_;
+    std::vector<double> spins_;                 // of candidates_
+    std::vector<size_t> first_;                 // first candidate of every point, one past the end last
+    std::vector<OpwKinematics::solutions_t> solutions_;
+};
@@ -0,0 +1,134 @@
+#include "traffic_capture.h"
+#include <string.h>
+#include "log/loguru.hpp"
+
+namespace traffic_capture
+{
+
+static const char MAGIC[8] = {'F', 'N', 'C', 'A', 'P', '0', '1', '\0'};
+static const uint32_t FLAG_BIGENDIAN = 0x01;
+static const size_t RECORD_HEADER_SIZE = sizeof(uint64_t) + 2 * sizeof(uint8_t) + sizeof(uint16_t);
+static const size_t FLUSH_SIZE = 64 * 1024;
+
+template <typename T>
+static void append(std::vector<char> &buffer, T val)
+{
+    const char *p = reinterpret_cast<const char *>(&val);
+    buffer.insert(buffer.end(), p, p + sizeof(T));
+}
+
+template <typename T>
+static T take(const char *&p)
+{
+    T val;
+    memcpy(&val, p, sizeof(T));
+    p += sizeof(T);
+    return val;
+}
+
+writer::~writer()
+{
+    close();
+}
+
+bool writer::open(const QString &file_name, bool bigendian)
+{
+    close();
+    file_.setFileName(file_name);
+    if(!file_.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        LOG_F(ERROR, "Cannot open capture %s: %s", file_name.toLocal8Bit().data(),
+              file_.errorString().toLocal8Bit().data());
+        return false;
+    }
+
+    buffer_.reserve(2 * FLUSH_SIZE);
+    buffer_.insert(buffer_.end(), MAGIC, MAGIC + sizeof(MAGIC));
+    append<uint32_t>(buffer_, bigendian ? FLAG_BIGENDIAN : 0);
+    records_ = 0;
+    clock_.start();
+    LOG_F(INFO, "Capturing traffic to %s", file_name.toLocal8Bit().data());
+    return true;
+}
+
+void writer::close()
+{
+    if(!file_.isOpen())
+        return;
+    flush();
+    file_.close();
+    LOG_F(INFO, "Capture closed, %zu records", records_);
+}
+
+bool writer::is_open() const
+{
+    return file_.isOpen();
+}
+
+void writer::record(channel_t channel, direction_t direction, const char *frame, size_t size)
+{
+    if(!file_.isOpen() || size > UINT16_MAX)
+        return;
+
+    append<uint64_t>(buffer_, static_cast<uint64_t>(clock_.nsecsElapsed()));
+    append<uint8_t>(buffer_, channel);
+    append<uint8_t>(buffer_, direction);
+    append<uint16_t>(buffer_, static_cast<uint16_t>(size));
+    buffer_.insert(buffer_.end(), frame, frame + size);
+    records_++;
+
+    if(buffer_.size() >= FLUSH_SIZE)
+        flush();
+}
+
+void writer::flush()
+{
+    if(!buffer_.empty())
+        file_.write(buffer_.data(), static_cast<qint64>(buffer_.size()));
+    buffer_.clear();
+}
+
+bool reader::open(const QString &file_name)
+{
+    file_.setFileName(file_name);
+    if(!file_.open(QIODevice::ReadOnly))
+    {
+        LOG_F(ERROR, "Cannot open capture %s: %s", file_name.toLocal8Bit().data(),
+              file_.errorString().toLocal8Bit().data());
+        return false;
+    }
+
+    char header[sizeof(MAGIC) + sizeof(uint32_t)];
+    if(file_.read(header, sizeof(header)) != static_cast<qint64>(sizeof(header)) || memcmp(header, MAGIC, sizeof(MAGIC)) != 0)
+    {
+        LOG_F(ERROR, "%s is not a traffic capture", file_name.toLocal8Bit().data());
+        file_.close();
+        return false;
+    }
+    const char *p = header + sizeof(MAGIC);
+    bigendian_ = (take<uint32_t>(p) & FLAG_BIGENDIAN) != 0;
+    return true;
+}
+
+bool reader::next(record_t &record)
+{
+    char header[RECORD_HEADER_SIZE];
+    if(!file_.isOpen() || file_.read(header, sizeof(header)) != static_cast<qint64>(sizeof(header)))
+        return false;
+
+    const char *p = header;
+    record.time_ns = take<uint64_t>(p);
+    record.channel = static_cast<channel_t>(take<uint8_t>(p));
+    record.direction = static_cast<direction_t>(take<uint8_t>(p));
+    uint16_t size = take<uint16_t>(p);
+
+    record.frame.resize(size);
+    if(file_.read(record.frame.data(), size) != size)
+    {
+        LOG_F(WARNING, "Truncated capture record");
+        return false;
+    }
+    return true;
+}
+
+}
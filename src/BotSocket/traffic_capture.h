@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <QFile>
+#include <QElapsedTimer>
+
+// Binary capture of framed SimpleMessage traffic.
+// File layout (little endian):
+//     file header:  char magic[8] = "FNCAP01\0", uint32 flags (bit 0 - big endian stream)
+//     record:       uint64 time_ns, uint8 channel, uint8 direction, uint16 size, frame bytes
+// time_ns is monotonic, counted from the moment the capture was opened.
+namespace traffic_capture
+{
+    enum channel_t: uint8_t {
+        CHANNEL_STATE = 0,
+        CHANNEL_RELAY = 1
+    };
+
+    enum direction_t: uint8_t {
+        DIRECTION_RX = 0,
+        DIRECTION_TX = 1
+    };
+
+    struct record_t {
+        uint64_t time_ns = 0;
+        channel_t channel = CHANNEL_STATE;
+        direction_t direction = DIRECTION_RX;
+        std::vector<char> frame;
+    };
+
+    class writer
+    {
+    public:
+        ~writer();
+
+        bool open(const QString &file_name, bool bigendian);
+        void close();
+        bool is_open() const;
+
+        void record(channel_t channel, direction_t direction, const char *frame, size_t size);
+        size_t records() const { return records_; }
+
+    private:
+        void flush();
+
+        QFile file_;
+        QElapsedTimer clock_;
+        std::vector<char> buffer_;
+        size_t records_ = 0;
+    };
+
+    class reader
+    {
+    public:
+        bool open(const QString &file_name);
+        bool bigendian() const { return bigendian_; }
+
+        // false at the end of file or on a truncated record
+        bool next(record_t &record);
+
+    private:
+        QFile file_;
+        bool bigendian_ = false;
+    };
+}
@@ -0,0 +1,84 @@
+#include "traffic_replay.h"
+#include "fanuc_state_socket.h"
+#include "log/loguru.hpp"
+
+using namespace traffic_capture;
+
+// frames handed over per event loop turn at max speed, rendering has to keep up
+static const size_t MAX_SPEED_BATCH = 256;
+
+TrafficReplay::TrafficReplay(const QString &file_name, double speed, FanucStateSocket *state, QObject *parent):
+    QObject(parent),
+    file_name_(file_name),
+    speed_(speed),
+    state_(state),
+    timer_(this)
+{
+    timer_.setSingleShot(true);
+    timer_.setTimerType(Qt::PreciseTimer);
+    connect(&timer_, &QTimer::timeout, this, &TrafficReplay::play);
+}
+
+void TrafficReplay::start()
+{
+    VLOG_CALL;
+
+    if(!reader_.open(file_name_))
+    {
+        emit finished();
+        return;
+    }
+    LOG_F(INFO, "Replaying %s at speed %f", file_name_.toLocal8Bit().data(), speed_);
+
+    state_->start_replay(reader_.bigendian());
+    have_record_ = read_next();
+    first_time_ns_ = have_record_ ? record_.time_ns : 0;
+    frames_ = 0;
+    clock_.start();
+    play();
+}
+
+bool TrafficReplay::read_next()
+{
+    // only what the state socket received can be fed back into it
+    while(reader_.next(record_))
+        if(record_.channel == CHANNEL_STATE && record_.direction == DIRECTION_RX)
+            return true;
+    return false;
+}
+
+void TrafficReplay::play()
+{
+    size_t batch = 0;
+    while(have_record_)
+    {
+        if(speed_ > 0)
+        {
+            qint64 due_ns = static_cast<qint64>((record_.time_ns - first_time_ns_) / speed_);
+            qint64 wait_ms = (due_ns - clock_.nsecsElapsed()) / 1000000;
+            if(wait_ms > 0)
+            {
+                timer_.start(static_cast<int>(wait_ms));
+                return;
+            }
+        }
+        else if(batch++ == MAX_SPEED_BATCH)
+        {
+            timer_.start(0);
+            return;
+        }
+
+        state_->replay_frame(record_.frame.data(), record_.frame.size());
+        frames_++;
+        have_record_ = read_next();
+    }
+    finish();
+}
+
+void TrafficReplay::finish()
+{
+    double seconds = clock_.nsecsElapsed() * 1e-9;
+    LOG_F(INFO, "Replay finished: %zu frames in %f s (%f frames/s)",
+          frames_, seconds, seconds > 0 ? frames_ / seconds : 0.);
+    emit finished();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "traffic_capture.h"
+
+class FanucStateSocket;
+
+// Feeds received state frames of a traffic capture into FanucStateSocket,
+// keeping the recorded timing scaled by speed (speed <= 0 - as fast as possible).
+// Has to live in the thread of the socket.
+class TrafficReplay : public QObject
+{
+    Q_OBJECT
+public:
+    TrafficReplay(const QString &file_name, double speed, FanucStateSocket *state, QObject *parent = nullptr);
+
+public slots:
+    void start();
+
+signals:
+    void finished();
+
+private slots:
+    void play();
+
+private:
+    bool read_next();
+    void finish();
+
+    QString file_name_;
+    double speed_;
+    FanucStateSocket *state_;
+    traffic_capture::reader reader_;
+    traffic_capture::record_t record_;
+    bool have_record_ = false;
+    uint64_t first_time_ns_ = 0;
+    QTimer timer_;
+    QElapsedTimer clock_;
+    size_t frames_ = 0;
+};
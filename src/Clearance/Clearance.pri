@@ -0,0 +1,11 @@
+SOURCES += \
+    $$PWD/triangle_bvh.cpp \
+    $$PWD/swept_clearance.cpp \
+    $$PWD/shape_triangles.cpp
+
+HEADERS += \
+    $$PWD/triangle_bvh.h \
+    $$PWD/swept_clearance.h \
+    $$PWD/shape_triangles.h
+
+INCLUDEPATH += $$quote($$(EIGEN_INCLUDE_DIRS))
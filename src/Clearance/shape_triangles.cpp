@@ -0,0 +1,43 @@
+#include "shape_triangles.h"
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <BRep_Tool.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Shape.hxx>
+
+static const double ANGULAR_DEFLECTION = 0.5; // rad
+
+static Eigen::Vector3d to_eigen(const gp_Pnt &point)
+{
+    return Eigen::Vector3d(point.X(), point.Y(), point.Z());
+}
+
+void append_shape_triangles(const TopoDS_Shape &shape, const gp_Trsf &trsf, int owner, double deflection,
+                            std::vector<TriangleBvh::triangle_t> &triangles)
+{
+    if(shape.IsNull())
+        return;
+
+    // keeps a finer triangulation the viewer already made
+    BRepMesh_IncrementalMesh(shape, deflection, Standard_False, ANGULAR_DEFLECTION, Standard_True);
+
+    for(TopExp_Explorer explorer(shape, TopAbs_FACE); explorer.More(); explorer.Next()) {
+        TopLoc_Location location;
+        const Handle(Poly_Triangulation) mesh = BRep_Tool::Triangulation(TopoDS::Face(explorer.Current()), location);
+        if(mesh.IsNull())
+            continue;
+
+        const gp_Trsf placement = trsf * location.Transformation();
+        for(Standard_Integer i=1; i<=mesh->NbTriangles(); i++) {
+            Standard_Integer n1, n2, n3;
+            mesh->Triangle(i).Get(n1, n2, n3);
+            TriangleBvh::triangle_t triangle;
+            triangle.a = to_eigen(mesh->Node(n1).Transformed(placement));
+            triangle.b = to_eigen(mesh->Node(n2).Transformed(placement));
+            triangle.c = to_eigen(mesh->Node(n3).Transformed(placement));
+            triangle.owner = owner;
+            triangles.push_back(triangle);
+        }
+    }
+}
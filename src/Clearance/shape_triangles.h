@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vector>
+#include <gp_Trsf.hxx>
+#include "triangle_bvh.h"
+
+class TopoDS_Shape;
+
+// Appends the triangles of the shape faces placed by trsf. Faces without a
+// triangulation are meshed first with the given linear deflection (mm), so the
+// triangles are within the deflection of the exact surface.
+void append_shape_triangles(const TopoDS_Shape &shape, const gp_Trsf &trsf, int owner, double deflection,
+                            std::vector<TriangleBvh::triangle_t> &triangles);
@@ -0,0 +1,189 @@
+#include "swept_clearance.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <map>
+
+static const double GROUP_CELLS = 4;    // group edge, cells
+
+static std::array<long, 3> cell_of(const Eigen::Vector3d &point, double size)
+{
+    return {{std::lround(std::floor(point.x() / size)),
+             std::lround(std::floor(point.y() / size)),
+             std::lround(std::floor(point.z() / size))}};
+}
+
+static SweptClearance::sphere_t bounding_sphere(const std::vector<SweptClearance::sphere_t> &spheres,
+                                                size_t first, size_t count)
+{
+    Eigen::AlignedBox3d box;
+    box.setEmpty();
+    for(size_t i=first; i<first + count; i++)
+        box.extend(spheres[i].center);
+
+    SweptClearance::sphere_t bound{box.center(), 0};
+    for(size_t i=first; i<first + count; i++)
+        bound.radius = std::max(bound.radius, (spheres[i].center - bound.center).norm() + spheres[i].radius);
+    return bound;
+}
+
+void SweptClearance::set_obstacles(std::vector<TriangleBvh::triangle_t> triangles)
+{
+    obstacles_.build(std::move(triangles));
+}
+
+void SweptClearance::set_tool(const std::vector<TriangleBvh::triangle_t> &triangles)
+{
+    spheres_ = cover(triangles, cell_);
+    groups_.clear();
+    reach_ = 0;
+
+    // spheres of one group are kept together
+    std::map<std::array<long, 3>, std::vector<sphere_t>> groups;
+    for(const sphere_t &sphere : spheres_)
+        groups[cell_of(sphere.center, cell_ * GROUP_CELLS)].push_back(sphere);
+
+    spheres_.clear();
+    for(const auto &group : groups) {
+        group_t g;
+        g.first = spheres_.size();
+        g.count = group.second.size();
+        spheres_.insert(spheres_.end(), group.second.begin(), group.second.end());
+        g.bound = bounding_sphere(spheres_, g.first, g.count);
+        groups_.push_back(g);
+    }
+
+    for(const sphere_t &sphere : spheres_)
+        reach_ = std::max(reach_, sphere.center.norm());
+}
+
+void SweptClearance::set_cell(double cell)
+{
+    if(cell > 0)
+        cell_ = cell;
+}
+
+void SweptClearance::set_margin(double margin)
+{
+    margin_ = std::max(0., margin);
+}
+
+double SweptClearance::cell() const
+{
+    return cell_;
+}
+
+double SweptClearance::margin() const
+{
+    return margin_;
+}
+
+bool SweptClearance::ready() const
+{
+    return !spheres_.empty() && !obstacles_.empty();
+}
+
+const std::vector<SweptClearance::sphere_t> &SweptClearance::spheres() const
+{
+    return spheres_;
+}
+
+std::vector<SweptClearance::sphere_t> SweptClearance::cover(const std::vector<TriangleBvh::triangle_t> &triangles,
+                                                            double cell)
+{
+    // Samples on a barycentric grid with edges up to half a cell: every point of
+    // a triangle is within step / sqrt(3) of a sample.
+    const double step = cell / 2;
+    std::map<std::array<long, 3>, std::vector<Eigen::Vector3d>> cells;
+    for(const TriangleBvh::triangle_t &t : triangles) {
+        const double edge = std::max({(t.b - t.a).norm(), (t.c - t.b).norm(), (t.a - t.c).norm()});
+        if(!std::isfinite(edge))
+            continue;
+        const int n = std::max(1, static_cast<int>(std::ceil(edge / step)));
+        for(int i=0; i<=n; i++)
+            for(int j=0; i + j<=n; j++) {
+                const Eigen::Vector3d p = t.a + (t.b - t.a) * (double(i) / n) + (t.c - t.a) * (double(j) / n);
+                cells[cell_of(p, cell)].push_back(p);
+            }
+    }
+
+    std::vector<sphere_t> spheres;
+    spheres.reserve(cells.size());
+    for(const auto &c : cells) {
+        // center of the bounds, samples are within half a cell diagonal of it
+        Eigen::AlignedBox3d box;
+        box.setEmpty();
+        for(const Eigen::Vector3d &p : c.second)
+            box.extend(p);
+        const Eigen::Vector3d center = box.center();
+
+        double radius = 0;
+        for(const Eigen::Vector3d &p : c.second)
+            radius = std::max(radius, (p - center).norm());
+        spheres.push_back({center, radius + step / std::sqrt(3.)});
+    }
+    return spheres;
+}
+
+double SweptClearance::clearance(const pose_t &pose, int &owner) const
+{
+    double best = margin_ + cell_;
+    owner = -1;
+    for(const group_t &group : groups_) {
+        const Eigen::Vector3d center = pose.rotation * group.bound.center + pose.translation;
+        if(obstacles_.nearest(center, best + group.bound.radius).owner < 0)
+            continue;
+
+        for(size_t i=group.first; i<group.first + group.count; i++) {
+            const sphere_t &sphere = spheres_[i];
+            const TriangleBvh::hit_t hit = obstacles_.nearest(pose.rotation * sphere.center + pose.translation,
+                                                              best + sphere.radius);
+            if(hit.owner >= 0) {
+                best = hit.distance - sphere.radius;
+                owner = hit.owner;
+                if(best <= 0)
+                    return 0;
+            }
+        }
+    }
+    return std::max(0., best);
+}
+
+SweptClearance::result_t SweptClearance::pose(const pose_t &pose) const
+{
+    result_t result;
+    result.clearance = clearance(pose, result.owner);
+    return result;
+}
+
+SweptClearance::result_t SweptClearance::segment(const pose_t &from, const pose_t &to) const
+{
+    const Eigen::Quaterniond qa(from.rotation), qb(to.rotation);
+    const Eigen::Vector3d move = to.translation - from.translation;
+    // no sphere center moves faster than this per unit of the segment
+    const double speed = move.norm() + qa.angularDistance(qb) * reach_;
+    const double min_step = cell_ / 2;
+
+    result_t result;
+    result.clearance = std::numeric_limits<double>::infinity();
+    double s = 0;
+    for(;;) {
+        pose_t p;
+        p.rotation = qa.slerp(s, qb).toRotationMatrix();
+        p.translation = from.translation + move * s;
+
+        int owner;
+        const double c = clearance(p, owner);
+        if(c < result.clearance) {
+            result.clearance = c;
+            result.at = s;
+            result.owner = owner;
+        }
+
+        if(s >= 1 || speed <= 0)
+            break;
+        s = std::min(1., s + std::max(c - margin_, min_step) / speed);
+    }
+    return result;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include "triangle_bvh.h"
+
+// Clearance between a tool moving along straight segments and static obstacles.
+// The tool surface is covered by spheres (surface samples clustered in cubic cells),
+// the spheres are grouped by larger cells and a group is skipped when its bounding
+// sphere is farther than the best clearance found. A segment interpolates the
+// position linearly and the rotation by slerp, as a linear robot move does.
+//
+// Segments are walked by conservative advancement: no sphere moves farther than
+// (clearance - margin) before the next pose, so parts of the segment that were not
+// sampled stay clear of the margin. Where the clearance is below the margin the
+// step is half a cell. Clearances are underestimated by about a cell at most because
+// of the sphere cover, values above margin + cell are lower bounds.
+class SweptClearance
+{
+public:
+    struct sphere_t {
+        Eigen::Vector3d center;
+        double radius;
+    };
+
+    struct pose_t {
+        Eigen::Matrix3d rotation = Eigen::Matrix3d::Identity();    // tool to world
+        Eigen::Vector3d translation = Eigen::Vector3d::Zero();
+    };
+
+    struct result_t {
+        double clearance = 0;   // smallest on the segment, 0 - touching or overlapping
+        double at = 0;          // where, 0 - start, 1 - end of the segment
+        int owner = -1;         // owner of the nearest obstacle triangle, -1 if nothing is near
+    };
+
+    void set_obstacles(std::vector<TriangleBvh::triangle_t> triangles);
+    void set_tool(const std::vector<TriangleBvh::triangle_t> &triangles);   // tool coordinates
+    void set_cell(double cell);     // mm, set before set_tool
+    void set_margin(double margin); // mm
+
+    double cell() const;
+    double margin() const;
+    bool ready() const;             // tool and obstacles are set
+    const std::vector<sphere_t> &spheres() const;
+
+    // safe to call from several threads at once
+    result_t pose(const pose_t &pose) const;
+    result_t segment(const pose_t &from, const pose_t &to) const;
+
+    static std::vector<sphere_t> cover(const std::vector<TriangleBvh::triangle_t> &triangles, double cell);
+
+private:
+    struct group_t {
+        sphere_t bound;
+        size_t first, count;    // range of spheres_
+    };
+
+    double clearance(const pose_t &pose, int &owner) const;
+
+    TriangleBvh obstacles_;
+    std::vector<sphere_t> spheres_;
+    std::vector<group_t> groups_;
+    double reach_ = 0;  // farthest sphere center from the tool origin
+    double cell_ = 10;
+    double margin_ = 5;
+};
@@ -0,0 +1,163 @@
+#include "triangle_bvh.h"
+#include <algorithm>
+#include <cmath>
+
+static const uint32_t LEAF_SIZE = 4;
+static const int MAX_DEPTH = 64;
+
+void TriangleBvh::build(std::vector<triangle_t> triangles)
+{
+    clear();
+    if(triangles.empty())
+        return;
+
+    std::vector<Eigen::Vector3d> centroids(triangles.size());
+    std::vector<uint32_t> index(triangles.size());
+    for(size_t i=0; i<triangles.size(); i++) {
+        centroids[i] = (triangles[i].a + triangles[i].b + triangles[i].c) / 3.;
+        index[i] = static_cast<uint32_t>(i);
+    }
+
+    nodes_.reserve(2 * triangles.size() / LEAF_SIZE + 1);
+    build_node(triangles, centroids, index, 0, static_cast<uint32_t>(index.size()));
+
+    // leaves address their triangles as one range
+    triangles_.reserve(triangles.size());
+    for(uint32_t i : index)
+        triangles_.push_back(triangles[i]);
+}
+
+void TriangleBvh::build_node(const std::vector<triangle_t> &triangles, const std::vector<Eigen::Vector3d> &centroids,
+                             std::vector<uint32_t> &index, uint32_t first, uint32_t count)
+{
+    const size_t node = nodes_.size();
+    nodes_.emplace_back();
+
+    Eigen::AlignedBox3d box, centers;
+    box.setEmpty();
+    centers.setEmpty();
+    for(uint32_t i=first; i<first + count; i++) {
+        const triangle_t &t = triangles[index[i]];
+        box.extend(t.a).extend(t.b).extend(t.c);
+        centers.extend(centroids[index[i]]);
+    }
+    nodes_[node].box = box;
+
+    if(count <= LEAF_SIZE) {
+        nodes_[node].first = first;
+        nodes_[node].count = count;
+        return;
+    }
+
+    // median split halves the range every level, the depth stays log2(n)
+    int axis;
+    centers.sizes().maxCoeff(&axis);
+    const uint32_t half = count / 2;
+    std::nth_element(index.begin() + first, index.begin() + first + half, index.begin() + first + count,
+                     [&centroids, axis](uint32_t l, uint32_t r) { return centroids[l][axis] < centroids[r][axis]; });
+
+    build_node(triangles, centroids, index, first, half);
+    nodes_[node].right = static_cast<uint32_t>(nodes_.size());
+    build_node(triangles, centroids, index, first + half, count - half);
+}
+
+void TriangleBvh::clear()
+{
+    triangles_.clear();
+    nodes_.clear();
+}
+
+bool TriangleBvh::empty() const
+{
+    return triangles_.empty();
+}
+
+size_t TriangleBvh::size() const
+{
+    return triangles_.size();
+}
+
+const Eigen::AlignedBox3d &TriangleBvh::bounds() const
+{
+    static const Eigen::AlignedBox3d none;
+    return nodes_.empty() ? none : nodes_.front().box;
+}
+
+TriangleBvh::hit_t TriangleBvh::nearest(const Eigen::Vector3d &point, double limit) const
+{
+    hit_t hit;
+    hit.distance = limit;
+    if(nodes_.empty())
+        return hit;
+
+    double best = limit * limit;
+    uint32_t stack[MAX_DEPTH];
+    int top = 0;
+    stack[top++] = 0;
+    while(top > 0) {
+        const node_t &node = nodes_[stack[--top]];
+        if(node.box.squaredExteriorDistance(point) >= best)
+            continue;
+
+        if(node.right == 0) {
+            for(uint32_t i=node.first; i<node.first + node.count; i++) {
+                const double d = (closest_point(point, triangles_[i]) - point).squaredNorm();
+                if(d < best) {
+                    best = d;
+                    hit.owner = triangles_[i].owner;
+                }
+            }
+            continue;
+        }
+
+        uint32_t near = static_cast<uint32_t>(&node - nodes_.data()) + 1, far = node.right;
+        const double near_d = nodes_[near].box.squaredExteriorDistance(point);
+        const double far_d = nodes_[far].box.squaredExteriorDistance(point);
+        if(far_d < near_d)
+            std::swap(near, far);
+        if(std::max(near_d, far_d) < best)
+            stack[top++] = far;
+        if(std::min(near_d, far_d) < best)
+            stack[top++] = near;
+    }
+
+    if(hit.owner >= 0)
+        hit.distance = std::sqrt(best);
+    return hit;
+}
+
+// Ericson, Real-Time Collision Detection, 5.1.5
+Eigen::Vector3d TriangleBvh::closest_point(const Eigen::Vector3d &p, const triangle_t &t)
+{
+    const Eigen::Vector3d ab = t.b - t.a, ac = t.c - t.a, ap = p - t.a;
+    const double d1 = ab.dot(ap), d2 = ac.dot(ap);
+    if(d1 <= 0 && d2 <= 0)
+        return t.a;
+
+    const Eigen::Vector3d bp = p - t.b;
+    const double d3 = ab.dot(bp), d4 = ac.dot(bp);
+    if(d3 >= 0 && d4 <= d3)
+        return t.b;
+
+    const double vc = d1 * d4 - d3 * d2;
+    if(vc <= 0 && d1 >= 0 && d3 <= 0)
+        return t.a + ab * (d1 / (d1 - d3));
+
+    const Eigen::Vector3d cp = p - t.c;
+    const double d5 = ab.dot(cp), d6 = ac.dot(cp);
+    if(d6 >= 0 && d5 <= d6)
+        return t.c;
+
+    const double vb = d5 * d2 - d1 * d6;
+    if(vb <= 0 && d2 >= 0 && d6 <= 0)
+        return t.a + ac * (d2 / (d2 - d6));
+
+    const double va = d3 * d6 - d5 * d4;
+    if(va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+        return t.b + (t.c - t.b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    const double denom = va + vb + vc;
+    if(denom <= 0) // degenerate triangle, all the edges were tested above
+        return t.a;
+    return t.a + ab * (vb / denom) + ac * (vc / denom);
+}
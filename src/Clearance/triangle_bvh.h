@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+// Bounding volume hierarchy over a static triangle soup answering nearest distance
+// queries. Nodes are axis aligned boxes split at the median of the triangle
+// centroids along the longest axis and stored depth first in one array, the left
+// child right after its parent. A query walks the nearer child first and skips
+// every box farther than the best distance found so far, so a small limit keeps
+// queries far from the geometry down to a couple of box tests.
+class TriangleBvh
+{
+public:
+    struct triangle_t {
+        Eigen::Vector3d a, b, c;
+        int owner = 0;  // caller defined, e.g. which model the triangle came from
+    };
+
+    struct hit_t {
+        double distance;
+        int owner = -1; // -1 if nothing is closer than the limit
+    };
+
+    void build(std::vector<triangle_t> triangles);
+    void clear();
+
+    bool empty() const;
+    size_t size() const;
+    const Eigen::AlignedBox3d &bounds() const;
+
+    // nearest triangle to the point, {limit, -1} if every triangle is farther
+    hit_t nearest(const Eigen::Vector3d &point, double limit) const;
+
+    static Eigen::Vector3d closest_point(const Eigen::Vector3d &point, const triangle_t &triangle);
+
+private:
+    struct node_t {
+        Eigen::AlignedBox3d box;
+        uint32_t right = 0;     // index of the right child, 0 for a leaf
+        uint32_t first = 0;     // first triangle of a leaf
+        uint32_t count = 0;
+    };
+
+    void build_node(const std::vector<triangle_t> &triangles, const std::vector<Eigen::Vector3d> &centroids,
+                    std::vector<uint32_t> &index, uint32_t first, uint32_t count);
+
+    std::vector<triangle_t> triangles_;
+    std::vector<node_t> nodes_;
+};
@@ -2,15 +2,56 @@
 #include "ui_ctaskpointsorderdialog.h"
 
 #include <QAbstractTableModel>
+#include <QFutureWatcher>
 #include <QProxyStyle>
 #include <QMimeData>
 #include <QPainter>
 #include <QStyledItemDelegate>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <atomic>
 
 #include "cbottaskdialogfacade.h"
+#include "../../BotSocket/fanuc_robot_config.h"
+#include "../../BotSocket/task_order_optimizer.h"
 
 namespace {
 
+enum EN_OptimizeCost
+{
+    ENOC_DISTANCE,
+    ENOC_TIME
+};
+
+// Joint move times between the points if fanuc.ini describes the arm and every
+// point is reachable, empty otherwise. Configurations are chosen in the current
+// order, reordering keeps them.
+TaskOrderOptimizer::cost_t jointTimeCost(const std::vector<GUI_TYPES::STaskPoint> &points)
+{
+    const fanuc_robot_config robot = fanuc_robot_config::load("fanuc.ini");
+    OpwKinematics kinematics;
+    kinematics.set_parameters(robot.kinematics);
+    if (!kinematics.valid())
+        return TaskOrderOptimizer::cost_t();
+
+    PoseBatch batch = robot.make_batch(points, points.size());
+    batch.convert();
+    if (batch.first_error() != batch.size())
+        return TaskOrderOptimizer::cost_t();
+
+    std::vector <joint_data> joints(points.size());
+    joint_data seed = {{0, 0, 0, 0, 0, 0}};
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (kinematics.solve(robot.robot_pose(batch, i), seed, joints[i]) != OpwKinematics::IK_OK)
+            return TaskOrderOptimizer::cost_t();
+        seed = joints[i];
+    }
+
+    CycleTimeModel model;
+    model.set_config(robot.motion);
+    return TaskOrderOptimizer::time_cost(joints, model);
+}
+
 class CTaskPointsOrderModel : public QAbstractTableModel
 {
 private:
@@ -50,6 +91,17 @@ public:
         return result;
     }
 
+    // rows in the given order of the current ones, names stay with their points
+    void reorder(const std::vector<size_t> &order) {
+        beginResetModel();
+        std::vector <SPoint> result;
+        result.reserve(order.size());
+        for(const size_t row : order)
+            result.push_back(points[row]);
+        points.swap(result);
+        endResetModel();
+    }
+
     int columnCount(const QModelIndex &parent = QModelIndex()) const final {
         (void)parent;
         return ENC_LAST;
@@ -282,6 +334,10 @@ class CTaskPointsOrderDialogPrivate
     friend class CTaskPointsOrderDialog;
 
     CTaskPointsOrderModel mdl;
+    QFutureWatcher <TaskOrderOptimizer::result_t> optimizer;
+    std::atomic <bool> cancelOptimize{false};
+    bool timeCost = false;      // result in s, else in mm
+    bool modelMissing = false;  // time was asked, but the robot model could not be used
 };
 
 
@@ -303,10 +359,14 @@ CTaskPointsOrderDialog::CTaskPointsOrderDialog(const std::vector<GUI_TYPES::STas
 
     connect(ui->pbOk, &QAbstractButton::clicked, this, &QDialog::accept);
     connect(ui->pbCancel, &QAbstractButton::clicked, this, &QDialog::reject);
+    connect(ui->pbOptimize, &QAbstractButton::clicked, this, &CTaskPointsOrderDialog::slOptimize);
+    connect(&d_ptr->optimizer, &QFutureWatcherBase::finished, this, &CTaskPointsOrderDialog::slOptimizeFinished);
 }
 
 CTaskPointsOrderDialog::~CTaskPointsOrderDialog()
 {
+    d_ptr->cancelOptimize = true;
+    d_ptr->optimizer.waitForFinished();
     delete ui;
     delete d_ptr;
 }
@@ -315,3 +375,67 @@ std::vector<GUI_TYPES::STaskPoint> CTaskPointsOrderDialog::getTaskPoints() const
 {
     return d_ptr->mdl.getTaskPoints();
 }
+
+void CTaskPointsOrderDialog::slOptimize()
+{
+    const std::vector<GUI_TYPES::STaskPoint> points = d_ptr->mdl.getTaskPoints();
+    TaskOrderOptimizer::cost_t cost;
+    d_ptr->timeCost = ui->cbCost->currentIndex() == ENOC_TIME;
+    if (d_ptr->timeCost)
+        cost = jointTimeCost(points);
+    d_ptr->modelMissing = d_ptr->timeCost && !cost;
+    if (!cost) {
+        d_ptr->timeCost = false;
+        cost = TaskOrderOptimizer::distance_cost(points);
+    }
+
+    TaskOrderOptimizer optimizer;
+    optimizer.set_cost(cost);
+    optimizer.set_time_budget(ui->dsbBudget->value());
+    optimizer.set_cancel(&d_ptr->cancelOptimize);
+    d_ptr->cancelOptimize = false;
+
+    setOptimizing(true);
+    ui->lPathCost->setText(tr("Оптимизация..."));
+    d_ptr->optimizer.setFuture(QtConcurrent::run([optimizer, points]() {
+        return optimizer.optimize(points);
+    }));
+}
+
+void CTaskPointsOrderDialog::slOptimizeFinished()
+{
+    setOptimizing(false);
+    const TaskOrderOptimizer::result_t result = d_ptr->optimizer.result();
+    if (result.order.size() != static_cast <size_t> (d_ptr->mdl.rowCount()))
+        return;
+
+    QString text;
+    // the user's own order stays unless a shorter one was found
+    if (result.after < result.before) {
+        d_ptr->mdl.reorder(result.order);
+        const double gain = (1. - result.after / result.before) * 100.;
+        text = d_ptr->timeCost
+                ? tr("Время перемещений: было %1 с, стало %2 с (-%3%)")
+                  .arg(result.before, 0, 'f', 1).arg(result.after, 0, 'f', 1).arg(gain, 0, 'f', 1)
+                : tr("Длина пути: было %1 мм, стало %2 мм (-%3%)")
+                  .arg(result.before, 0, 'f', 0).arg(result.after, 0, 'f', 0).arg(gain, 0, 'f', 1);
+    } else {
+        text = d_ptr->timeCost
+                ? tr("Время перемещений: %1 с, порядок не изменён").arg(result.before, 0, 'f', 1)
+                : tr("Длина пути: %1 мм, порядок не изменён").arg(result.before, 0, 'f', 0);
+    }
+    if (!result.complete)
+        text += tr(", остановлено по времени");
+    if (d_ptr->modelMissing)
+        text = tr("Модель робота недоступна. ") + text;
+    ui->lPathCost->setText(text);
+}
+
+void CTaskPointsOrderDialog::setOptimizing(const bool optimizing)
+{
+    ui->tableView->setEnabled(!optimizing);
+    ui->cbCost->setEnabled(!optimizing);
+    ui->dsbBudget->setEnabled(!optimizing);
+    ui->pbOptimize->setEnabled(!optimizing);
+    ui->pbOk->setEnabled(!optimizing);
+}
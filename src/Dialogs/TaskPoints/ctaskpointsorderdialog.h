@@ -22,6 +22,13 @@ public:
 
     std::vector<GUI_TYPES::STaskPoint> getTaskPoints() const;
 
+private slots:
+    void slOptimize();
+    void slOptimizeFinished();
+
+private:
+    void setOptimizing(const bool optimizing);
+
 private:
     Ui::CTaskPointsOrderDialog *ui;
 
@@ -1,4 +1,4 @@
-QT       += core gui network
+QT       += core gui network concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -14,6 +14,24 @@ SOURCES += \
     BotSocket/cfanucbotsocket.cpp \
     BotSocket/fanuc_relay_socket.cpp \
     BotSocket/fanuc_state_socket.cpp \
+    BotSocket/simple_message_codec.cpp \
+    BotSocket/simple_message_framer.cpp \
+    BotSocket/pose_history.cpp \
+    BotSocket/latency_histogram.cpp \
+    BotSocket/motion_state_tracker.cpp \
+    BotSocket/link_health.cpp \
+    BotSocket/pulse_reply_tracker.cpp \
+    BotSocket/pose_batch.cpp \
+    BotSocket/opw_kinematics.cpp \
+    BotSocket/fanuc_robot_config.cpp \
+    BotSocket/cycle_time_model.cpp \
+    BotSocket/csimbotsocket.cpp \
+    BotSocket/task_order_optimizer.cpp \
+    BotSocket/tool_spin_planner.cpp \
+    BotSocket/calibration_channel.cpp \
+    BotSocket/fanuc_connection_manager.cpp \
+    BotSocket/traffic_capture.cpp \
+    BotSocket/traffic_replay.cpp \
     Primitives/cpathvec.cpp \
     cadvanceddepthmapviewport.cpp \
     cadvancedsnapshotviewport.cpp \
@@ -40,6 +58,7 @@ SOURCES += \
     Primitives/claservec.cpp \
     Primitives/ctaskpnt.cpp \
     caspectwindow.cpp \
+    cdiagnosticsdialog.cpp \
     cguisettingswidget.cpp \
     cinteractivecontext.cpp \
     cmainviewport.cpp \
@@ -57,6 +76,28 @@ HEADERS += \
     BotSocket/fanuc_relay_socket.h \
     BotSocket/fanuc_state_socket.h \
     BotSocket/simple_message.h \
+    BotSocket/simple_message_codec.h \
+    BotSocket/simple_message_framer.h \
+    BotSocket/simple_message_traits.h \
+    BotSocket/simple_message_dispatch.h \
+    BotSocket/seqlock.h \
+    BotSocket/spsc_queue.h \
+    BotSocket/pose_history.h \
+    BotSocket/latency_histogram.h \
+    BotSocket/motion_state_tracker.h \
+    BotSocket/link_health.h \
+    BotSocket/pulse_reply_tracker.h \
+    BotSocket/pose_batch.h \
+    BotSocket/opw_kinematics.h \
+    BotSocket/fanuc_robot_config.h \
+    BotSocket/cycle_time_model.h \
+    BotSocket/csimbotsocket.h \
+    BotSocket/task_order_optimizer.h \
+    BotSocket/tool_spin_planner.h \
+    BotSocket/calibration_channel.h \
+    BotSocket/fanuc_connection_manager.h \
+    BotSocket/traffic_capture.h \
+    BotSocket/traffic_replay.h \
     Primitives/cpathvec.h \
     cabstractpointssaver.h \
     cadvanceddepthmapviewport.h \
@@ -85,6 +126,7 @@ HEADERS += \
     Primitives/ctaskpnt.h \
     cabstractsettingsstorage.h \
     caspectwindow.h \
+    cdiagnosticsdialog.h \
     cguisettingswidget.h \
     cinteractivecontext.h \
     cmainviewport.h \
@@ -104,6 +146,7 @@ FORMS += \
     Dialogs/TaskPoints/cmarkbottaskdialog.ui \
     Dialogs/TaskPoints/cmovebottaskdialog.ui \
     Dialogs/TaskPoints/ctaskpointsorderdialog.ui \
+    cdiagnosticsdialog.ui \
     cguisettingswidget.ui \
     csnapshotdialog.ui \
     mainwindow.ui
@@ -150,3 +193,5 @@ RESOURCES += \
     data.qrc
 
 include(PartReference/PartReference.pri)
+include(Clearance/Clearance.pri)
+include(Registration/Registration.pri)
@@ -11,7 +11,8 @@ CPathVec::CPathVec(const gp_Pnt2d& thePnt1,
                    Standard_Real theArrowLength)
 : myPnt (gp_Pnt (thePnt1.X(), thePnt1.Y(), 0.0)),
   myLength (0.0),
-  myArrowLength (theArrowLength)
+  myArrowLength (theArrowLength),
+  myColor (Quantity_NOC_DARKSLATEGRAY)
 {
   gp_Vec aVec (thePnt2.X() - thePnt1.X(), thePnt2.Y() - thePnt1.Y(), 0.0);
   myDir = gp_Dir(aVec);
@@ -36,7 +37,7 @@ void CPathVec::Compute (const Handle(PrsMgr_PresentationManager3d)& ,
 
   // Draw Line
   {
-    myDrawer->SetLineAspect(new Prs3d_LineAspect(Quantity_NOC_DARKSLATEGRAY, Aspect_TOL_DOT, 1.));
+    myDrawer->SetLineAspect(new Prs3d_LineAspect(myColor, Aspect_TOL_DOT, 1.));
     Handle(Graphic3d_Group) aLineGroup = thePrs->NewGroup();
     aLineGroup->SetGroupPrimitivesAspect (myDrawer->LineAspect()->Aspect());
     Handle(Graphic3d_ArrayOfSegments) aPrims = new Graphic3d_ArrayOfSegments(2);
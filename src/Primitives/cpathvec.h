@@ -2,6 +2,7 @@
 #define CPATHVEC_H
 
 #include <AIS_InteractiveObject.hxx>
+#include <Quantity_Color.hxx>
 
 //! AIS interactive Object for vector with arrow and text
 class CPathVec : public AIS_InteractiveObject
@@ -11,7 +12,8 @@ class CPathVec : public AIS_InteractiveObject
 
         CPathVec()
       : myLength (1.0),
-        myArrowLength (1.0)
+        myArrowLength (1.0),
+        myColor (Quantity_NOC_DARKSLATEGRAY)
     {}
 
     CPathVec (const gp_Pnt& thePnt,
@@ -21,7 +23,8 @@ class CPathVec : public AIS_InteractiveObject
         : myPnt (thePnt),
           myDir (theDir),
           myLength (theLength),
-          myArrowLength (theArrowLength)
+          myArrowLength (theArrowLength),
+          myColor (Quantity_NOC_DARKSLATEGRAY)
     {
         //
     }
@@ -32,7 +35,8 @@ class CPathVec : public AIS_InteractiveObject
         : myPnt (thePnt),
           myDir (theVec),
           myLength (theVec.Magnitude()),
-          myArrowLength (theArrowLength)
+          myArrowLength (theArrowLength),
+          myColor (Quantity_NOC_DARKSLATEGRAY)
     {
         //
     }
@@ -43,7 +47,8 @@ class CPathVec : public AIS_InteractiveObject
         : myPnt (thePnt1),
           myDir (gp_Vec(thePnt1, thePnt2)),
           myLength (gp_Vec(thePnt1, thePnt2).Magnitude()),
-          myArrowLength (theArrowLength)
+          myArrowLength (theArrowLength),
+          myColor (Quantity_NOC_DARKSLATEGRAY)
     {
         //
     }
@@ -55,7 +60,8 @@ class CPathVec : public AIS_InteractiveObject
         : myPnt (gp_Pnt(thePnt2d.X(), thePnt2d.Y(), 0.0)),
           myDir (gp_Dir(theDir2d.X(), theDir2d.Y(), 0.0)),
           myLength (theLength),
-          myArrowLength (theArrowLength)
+          myArrowLength (theArrowLength),
+          myColor (Quantity_NOC_DARKSLATEGRAY)
     {
         //
     }
@@ -66,7 +72,8 @@ class CPathVec : public AIS_InteractiveObject
         : myPnt (gp_Pnt(thePnt2d.X(), thePnt2d.Y(), 0.0)),
           myDir (gp_Dir(theVec2d.X(), theVec2d.Y(), 0.0)),
           myLength (theVec2d.Magnitude()),
-          myArrowLength (theArrowLength)
+          myArrowLength (theArrowLength),
+          myColor (Quantity_NOC_DARKSLATEGRAY)
     {
         //
     }
@@ -85,6 +92,11 @@ class CPathVec : public AIS_InteractiveObject
         myDrawer->SetLineAspect(theAspect);
     }
 
+    void SetLineColor (const Quantity_Color& theColor)
+    {
+        myColor = theColor;
+    }
+
 private:
 
     //! Return TRUE for supported display modes (only mode 0 is supported).
@@ -104,6 +116,7 @@ private:
     gp_Dir myDir;
     Standard_Real myLength;
     Standard_Real myArrowLength;
+    Quantity_Color myColor;
     TCollection_AsciiString myText;
 };
 
@@ -0,0 +1,7 @@
+SOURCES += \
+    $$PWD/snapshot_registration.cpp
+
+HEADERS += \
+    $$PWD/snapshot_registration.h
+
+INCLUDEPATH += $$quote($$(EIGEN_INCLUDE_DIRS))
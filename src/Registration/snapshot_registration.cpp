@@ -0,0 +1,302 @@
+#include "snapshot_registration.h"
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <Eigen/Core>
+
+namespace {
+
+const size_t ROWS_PER_JOB = 16;
+const size_t TRANSPOSE_BLOCK = 32;
+const float PHASE_FLOOR = 1e-4f;   // of the strongest frequency
+
+typedef Eigen::Map<Eigen::ArrayXf> row_t;
+typedef Eigen::Map<const Eigen::ArrayXf> const_row_t;
+
+// split complex image, rows one after another
+struct plane_t {
+    std::vector<float> re, im;
+    size_t rows = 0, cols = 0;
+
+    plane_t(size_t r, size_t c) : re(r * c, 0.f), im(r * c, 0.f), rows(r), cols(c) {}
+};
+
+size_t power_of_two(int size)
+{
+    size_t n = 1;
+    while (n < static_cast<size_t>(size))
+        n *= 2;
+    return n;
+}
+
+// Radix-2 decimation in time of one length, unscaled both ways
+class Fft
+{
+public:
+    explicit Fft(size_t n) : n_(n), reversed_(n), wr_(n), wi_(n)
+    {
+        size_t bits = 0;
+        while ((size_t(1) << bits) < n)
+            bits++;
+        for (size_t i = 0; i < n; ++i)
+        {
+            size_t r = 0;
+            for (size_t b = 0; b < bits; ++b)
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            reversed_[i] = r;
+        }
+        // twiddles of the stage with half length h are [h, 2h)
+        for (size_t h = 1; h < n; h *= 2)
+            for (size_t j = 0; j < h; ++j)
+            {
+                wr_[h + j] = static_cast<float>(cos(M_PI * j / h));
+                wi_[h + j] = static_cast<float>(-sin(M_PI * j / h));
+            }
+    }
+
+    size_t size() const { return n_; }
+
+    // tr, ti - scratch of n / 2
+    void transform(float *re, float *im, bool inverse, float *tr, float *ti) const
+    {
+        for (size_t i = 0; i < n_; ++i)
+        {
+            const size_t j = reversed_[i];
+            if (i < j)
+            {
+                std::swap(re[i], re[j]);
+                std::swap(im[i], im[j]);
+            }
+        }
+
+        for (size_t i = 0; i + 1 < n_; i += 2)
+        {
+            const float ur = re[i], ui = im[i];
+            re[i] = ur + re[i + 1];
+            im[i] = ui + im[i + 1];
+            re[i + 1] = ur - re[i + 1];
+            im[i + 1] = ui - im[i + 1];
+        }
+
+        // the inverse turns the other way, w* = (wr, -wi)
+        const float sign = inverse ? -1.f : 1.f;
+        for (size_t h = 2; h < n_; h *= 2)
+        {
+            const const_row_t wr(wr_.data() + h, static_cast<Eigen::Index>(h));
+            const const_row_t wi(wi_.data() + h, static_cast<Eigen::Index>(h));
+            row_t sr(tr, static_cast<Eigen::Index>(h)), si(ti, static_cast<Eigen::Index>(h));
+            for (size_t i = 0; i < n_; i += 2 * h)
+            {
+                row_t ur(re + i, static_cast<Eigen::Index>(h)), ui(im + i, static_cast<Eigen::Index>(h));
+                row_t vr(re + i + h, static_cast<Eigen::Index>(h)), vi(im + i + h, static_cast<Eigen::Index>(h));
+                sr = vr * wr - sign * vi * wi;
+                si = sign * vr * wi + vi * wr;
+                vr = ur - sr;
+                vi = ui - si;
+                ur += sr;
+                ui += si;
+            }
+        }
+    }
+
+private:
+    size_t n_;
+    std::vector<size_t> reversed_;
+    std::vector<float> wr_, wi_;
+};
+
+} // namespace
+
+void SnapshotRegistration::set_parallel(const parallel_t &parallel)
+{
+    parallel_ = parallel;
+}
+
+void SnapshotRegistration::run(size_t count, const std::function<void(size_t)> &job) const
+{
+    if (parallel_)
+    {
+        parallel_(count, job);
+        return;
+    }
+    for (size_t i = 0; i < count; ++i)
+        job(i);
+}
+
+std::vector<float> SnapshotRegistration::gray(const uint32_t *pixels, int width, int height, int pixels_per_line)
+{
+    std::vector<float> result(static_cast<size_t>(std::max(0, width * height)));
+    for (int y = 0; y < height; ++y)
+    {
+        const uint32_t *row = pixels + static_cast<ptrdiff_t>(y) * pixels_per_line;
+        float *out = result.data() + static_cast<size_t>(y) * width;
+        // weights of qGray()
+        for (int x = 0; x < width; ++x)
+            out[x] = (((row[x] >> 16) & 0xff) * 11 + ((row[x] >> 8) & 0xff) * 16 + (row[x] & 0xff) * 5) / 32.f;
+    }
+    return result;
+}
+
+SnapshotRegistration::result_t SnapshotRegistration::align(const std::vector<float> &reference,
+                                                           const std::vector<float> &moved,
+                                                           int width, int height) const
+{
+    result_t result;
+    const size_t pixels = static_cast<size_t>(std::max(0, width) * std::max(0, height));
+    if (pixels == 0 || reference.size() < pixels || moved.size() < pixels)
+        return result;
+
+    const size_t w = power_of_two(width), h = power_of_two(height);
+    const Fft fft_w(w), fft_h(h);
+
+    // Hann window of the image sizes
+    const auto window = [](int size) {
+        std::vector<float> result(static_cast<size_t>(size));
+        for (int i = 0; i < size; ++i)
+            result[static_cast<size_t>(i)] = static_cast<float>(0.5 - 0.5 * cos(2 * M_PI * (i + 0.5) / size));
+        return result;
+    };
+    const std::vector<float> window_x = window(width), window_y = window(height);
+
+    // rows of a plane in jobs of ROWS_PER_JOB
+    const auto rows = [this](const plane_t &plane, const std::function<void(size_t)> &row) {
+        run((plane.rows + ROWS_PER_JOB - 1) / ROWS_PER_JOB, [&plane, &row](size_t job) {
+            for (size_t r = job * ROWS_PER_JOB; r < std::min(plane.rows, (job + 1) * ROWS_PER_JOB); ++r)
+                row(r);
+        });
+    };
+    const auto transform = [&rows](plane_t &plane, const Fft &fft, bool inverse) {
+        rows(plane, [&plane, &fft, inverse](size_t r) {
+            thread_local std::vector<float> tr, ti;
+            tr.resize(fft.size() / 2 + 1);
+            ti.resize(fft.size() / 2 + 1);
+            fft.transform(plane.re.data() + r * plane.cols, plane.im.data() + r * plane.cols, inverse,
+                          tr.data(), ti.data());
+        });
+    };
+    const auto transpose = [this](const plane_t &src, plane_t &dst) {
+        run((src.cols + TRANSPOSE_BLOCK - 1) / TRANSPOSE_BLOCK, [&src, &dst](size_t job) {
+            const size_t c0 = job * TRANSPOSE_BLOCK, c1 = std::min(src.cols, c0 + TRANSPOSE_BLOCK);
+            for (size_t r0 = 0; r0 < src.rows; r0 += TRANSPOSE_BLOCK)
+                for (size_t r = r0; r < std::min(src.rows, r0 + TRANSPOSE_BLOCK); ++r)
+                    for (size_t c = c0; c < c1; ++c)
+                    {
+                        dst.re[c * src.rows + r] = src.re[r * src.cols + c];
+                        dst.im[c * src.rows + r] = src.im[r * src.cols + c];
+                    }
+        });
+    };
+
+    // Spectra come out transposed, columns of the image are rows of the plane.
+    // The window is laid over the image moved by (sx, sy), outside of it is zero.
+    const auto spectrum = [&](const std::vector<float> &image, int sx, int sy) {
+        double sum = 0;
+        for (size_t i = 0; i < pixels; ++i)
+            sum += image[i];
+        const float mean = static_cast<float>(sum / pixels);
+
+        plane_t plane(h, w);
+        for (int y = std::max(0, sy); y < std::min(height, height + sy); ++y)
+        {
+            const float *src = image.data() + static_cast<size_t>(y) * width;
+            float *dst = plane.re.data() + static_cast<size_t>(y) * w;
+            const float wy = window_y[static_cast<size_t>(y - sy)];
+            for (int x = std::max(0, sx); x < std::min(width, width + sx); ++x)
+                dst[x] = (src[x] - mean) * window_x[static_cast<size_t>(x - sx)] * wy;
+        }
+        transform(plane, fft_w, false);
+        plane_t columns(w, h);
+        transpose(plane, columns);
+        transform(columns, fft_h, false);
+        return columns;
+    };
+
+    const plane_t base = spectrum(reference, 0, 0);
+    // shift and peak of the correlation with the spectrum of the moved image
+    const auto correlate = [&](plane_t cross) {
+        result_t found;
+        // cross power spectrum, moved * conj(reference)
+        std::vector<float> row_max(cross.rows);
+        rows(cross, [&cross, &base, &row_max](size_t r) {
+            const Eigen::Index n = static_cast<Eigen::Index>(cross.cols);
+            const size_t offset = r * cross.cols;
+            row_t ar(cross.re.data() + offset, n), ai(cross.im.data() + offset, n);
+            const const_row_t br(base.re.data() + offset, n), bi(base.im.data() + offset, n);
+            const Eigen::ArrayXf cr = ar * br + ai * bi;
+            ai = ai * br - ar * bi;
+            ar = cr;
+            row_max[r] = (ar * ar + ai * ai).maxCoeff();
+        });
+
+        // Normalized to the phase, but frequencies the images hardly have (rounding
+        // noise, mostly) get less weight instead of a unit of random phase
+        const float epsilon = std::sqrt(*std::max_element(row_max.begin(), row_max.end())) * PHASE_FLOOR;
+        if (!(epsilon > 0))
+            return found;
+        std::vector<double> row_weight(cross.rows);
+        rows(cross, [&cross, &row_weight, epsilon](size_t r) {
+            const Eigen::Index n = static_cast<Eigen::Index>(cross.cols);
+            const size_t offset = r * cross.cols;
+            row_t ar(cross.re.data() + offset, n), ai(cross.im.data() + offset, n);
+            const Eigen::ArrayXf magnitude = (ar * ar + ai * ai).sqrt();
+            const Eigen::ArrayXf scale = (magnitude + epsilon).inverse();
+            ar *= scale;
+            ai *= scale;
+            row_weight[r] = (magnitude * scale).sum();
+        });
+        double weight = 0;
+        for (double w_r : row_weight)
+            weight += w_r;
+
+        transform(cross, fft_h, true);
+        plane_t surface(h, w);
+        transpose(cross, surface);
+        transform(surface, fft_w, true);
+
+        // the highest real value, row maxima first
+        std::vector<size_t> row_peak(h);
+        rows(surface, [&surface, &row_peak](size_t r) {
+            const float *row = surface.re.data() + r * surface.cols;
+            row_peak[r] = static_cast<size_t>(std::max_element(row, row + surface.cols) - row);
+        });
+        size_t py = 0;
+        for (size_t r = 1; r < h; ++r)
+            if (surface.re[r * w + row_peak[r]] > surface.re[py * w + row_peak[py]])
+                py = r;
+        const size_t px = row_peak[py];
+
+        const auto at = [&surface, w, h](size_t x, size_t y) {
+            return static_cast<double>(surface.re[(y % h) * w + (x % w)]);
+        };
+        // vertex of the parabola through the peak and its neighbours
+        const auto offset = [](double before, double peak, double after) {
+            const double curvature = before - 2 * peak + after;
+            if (curvature >= 0)
+                return 0.;
+            return std::max(-0.5, std::min(0.5, (before - after) / (2 * curvature)));
+        };
+        const double peak = at(px, py);
+        found.dx = px + offset(at(px + w - 1, py), peak, at(px + 1, py));
+        found.dy = py + offset(at(px, py + h - 1), peak, at(px, py + 1));
+        // shifts past the half wrap around
+        if (found.dx > w / 2.)
+            found.dx -= w;
+        if (found.dy > h / 2.)
+            found.dy -= h;
+        // an exact copy sums every weight at zero
+        found.peak = peak / weight;
+        return found;
+    };
+
+    // The window weights the middle of the reference more than the edges, and the
+    // same window on the moved image pulls the shift towards zero. The second pass
+    // moves the window along by the whole pixels found, so it covers the same
+    // content in both.
+    result = correlate(spectrum(moved, 0, 0));
+    const int sx = static_cast<int>(std::lround(result.dx)), sy = static_cast<int>(std::lround(result.dy));
+    if (result.peak > 0 && (sx != 0 || sy != 0) && std::abs(sx) < width && std::abs(sy) < height)
+        result = correlate(spectrum(moved, sx, sy));
+    return result;
+}
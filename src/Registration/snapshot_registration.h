@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Translation between the rendered reference snapshot and the camera frame by
+// phase correlation. Both gray images are centered, weighted by a Hann window and
+// zero padded to powers of two; the normalized cross power spectrum is turned back
+// and its peak, refined to sub-pixel by the neighbours on each axis, is the
+// shift. A second pass with the window moved along by the whole pixels found
+// takes out the pull of the window towards zero. Rows of the 2D transforms are
+// independent and handed to the parallel runner, butterflies of a row go through
+// Eigen arrays (split real and imaginary parts) to use SIMD.
+class SnapshotRegistration
+{
+public:
+    // job(i) for i in [0, count), may run on several threads at once
+    typedef std::function<void(size_t count, const std::function<void(size_t)> &job)> parallel_t;
+
+    struct result_t {
+        double dx = 0, dy = 0;  // px, moved image relative to the reference, y down
+        double peak = 0;        // of the correlation, 1 - exact copy, near 0 - nothing in common
+    };
+
+    void set_parallel(const parallel_t &parallel);     // serial if not set
+
+    // same sizes, row by row
+    result_t align(const std::vector<float> &reference, const std::vector<float> &moved,
+                   int width, int height) const;
+
+    // luminance of 0xAARRGGBB pixels, as QImage::Format_RGB32 keeps them
+    static std::vector<float> gray(const uint32_t *pixels, int width, int height, int pixels_per_line);
+
+private:
+    void run(size_t count, const std::function<void(size_t)> &job) const;
+
+    parallel_t parallel_;
+};
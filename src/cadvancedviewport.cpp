@@ -144,6 +144,29 @@ class CAdvancedViewportPrivate : public AIS_ViewController
     Handle(CAspectWindow) aspect;
     Handle(AIS_InteractiveContext) context;
 
+    // camera of the laser head moved by trsf
+    void lsrheadCamera(const gp_Trsf &trsf, gp_Pnt &pos, gp_Pnt &at, gp_Dir &orient) const {
+        pos = laserPos;
+        pos.Transform(trsf);
+
+        gp_Dir dir = laserDir;
+        dir.Transform(trsf);
+
+        at = pos;
+        at.Translate(gp_Vec(dir));
+
+        /**
+         *  TODO: parametrize camera distance (e.g. 80 mm)
+         *        (plays a role when we look towards physycally-inspired
+         *                                     rendering and perspective)
+         */
+        Standard_Real len_cam = 0;
+        pos.Translate(-len_cam * gp_Vec(dir));
+        const gp_Quaternion rotation = trsf.GetRotation();
+        gp_Vec orient_x(1, 0, 0);
+        orient = rotation.Multiply(orient_x);
+    }
+
     gp_Pnt laserPos;
     gp_Dir laserDir;
 
@@ -204,25 +227,9 @@ void CAdvancedViewport::modelTransformChanged(const GUI_TYPES::EN_ShapeType mode
     bool needRedraw = false;
     if (model == GUI_TYPES::ENST_LSRHEAD)
     {
-        gp_Pnt pos = d_ptr->laserPos;
-        pos.Transform(trsf);
-
-        gp_Dir dir = d_ptr->laserDir;
-        dir.Transform(trsf);
-
-        gp_Pnt aLastPoint = pos;
-        aLastPoint.Translate(gp_Vec(dir));
-
-        /**
-         *  TODO: parametrize camera distance (e.g. 80 mm)
-         *        (plays a role when we look towards physycally-inspired
-         *                                     rendering and perspective)
-         */
-        Standard_Real len_cam = 0;
-        pos.Translate(-len_cam * gp_Vec(dir));
-        const gp_Quaternion rotation = trsf.GetRotation();
-        gp_Vec orient(1, 0, 0);
-        const gp_Vec orient_rot = rotation.Multiply(orient);
+        gp_Pnt pos, aLastPoint;
+        gp_Dir orient_rot;
+        d_ptr->lsrheadCamera(trsf, pos, aLastPoint, orient_rot);
 
         setCameraPos(pos, aLastPoint, orient_rot);
 
@@ -304,6 +311,27 @@ QImage CAdvancedViewport::createSnapshot(const size_t width, const size_t height
     return img;
 }
 
+QImage CAdvancedViewport::createSnapshot(const gp_Trsf &lsrhead, const size_t width, const size_t height)
+{
+    gp_Pnt pos, at;
+    gp_Dir orient;
+    d_ptr->lsrheadCamera(lsrhead, pos, at, orient);
+
+    // the image is rendered offscreen, the widget is not redrawn
+    Handle(Graphic3d_Camera) current = new Graphic3d_Camera();
+    current->Copy(d_ptr->view->Camera());
+    const Standard_Boolean immediate = d_ptr->view->SetImmediateUpdate(Standard_False);
+    d_ptr->view->SetEye(pos.X(), pos.Y(), pos.Z());
+    d_ptr->view->SetAt(at.X(), at.Y(), at.Z());
+    d_ptr->view->SetUp(orient.X(), orient.Y(), orient.Z());
+
+    const QImage img = createSnapshot(width, height);
+
+    d_ptr->view->Camera()->Copy(current);
+    d_ptr->view->SetImmediateUpdate(immediate);
+    return img;
+}
+
 void CAdvancedViewport::setShapeVisible(const GUI_TYPES::EN_ShapeType model, bool visible)
 {
     d_ptr->setShapeVisible(model, visible);
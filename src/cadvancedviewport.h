@@ -39,6 +39,8 @@ public:
     void createSnapshot(const char *fname, const size_t width, const size_t height);
 
     QImage createSnapshot(const size_t width, const size_t height);
+    // as seen from the laser head at lsrhead, the view camera stays where it is
+    QImage createSnapshot(const gp_Trsf &lsrhead, const size_t width, const size_t height);
 
     void setShapeVisible(const GUI_TYPES::EN_ShapeType model, bool visible);
 
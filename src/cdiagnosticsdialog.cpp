@@ -0,0 +1,163 @@
+#include "cdiagnosticsdialog.h"
+#include "ui_cdiagnosticsdialog.h"
+
+#include <QFile>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QTextStream>
+
+namespace {
+
+enum EN_Columns
+{
+    ENC_FIRST = 0,
+
+    ENC_COUNT = ENC_FIRST,
+    ENC_MIN,
+    ENC_MEAN,
+    ENC_P50,
+    ENC_P90,
+    ENC_P99,
+    ENC_MAX,
+
+    ENC_LAST
+};
+
+struct SMetric
+{
+    const char *id; //CSV name, keep stable to compare files
+    const char *title;
+    BotSocket::SLatencyStats BotSocket::SDiagnostics::*stats;
+};
+
+const SMetric METRICS[] = {
+    { "relay_round_trip", QT_TRANSLATE_NOOP("CDiagnosticsDialog", "Ответ на точку траектории"), &BotSocket::SDiagnostics::relayRoundTrip },
+    { "state_interval"  , QT_TRANSLATE_NOOP("CDiagnosticsDialog", "Интервал позиций"         ), &BotSocket::SDiagnostics::stateInterval  },
+    { "state_jitter"    , QT_TRANSLATE_NOOP("CDiagnosticsDialog", "Джиттер позиций"          ), &BotSocket::SDiagnostics::stateJitter    },
+    { "state_decode"    , QT_TRANSLATE_NOOP("CDiagnosticsDialog", "Обработка пакета"         ), &BotSocket::SDiagnostics::stateDecode    },
+    { "relay_ping"      , QT_TRANSLATE_NOOP("CDiagnosticsDialog", "Пинг реле"                ), &BotSocket::SDiagnostics::relayPing      },
+    { "state_ping"      , QT_TRANSLATE_NOOP("CDiagnosticsDialog", "Пинг состояния"           ), &BotSocket::SDiagnostics::statePing      },
+    { "task_cycle"      , QT_TRANSLATE_NOOP("CDiagnosticsDialog", "Цикл задачи (симуляция)"  ), &BotSocket::SDiagnostics::taskCycle      }
+};
+const int METRICS_COUNT = static_cast <int> (sizeof(METRICS) / sizeof(METRICS[0]));
+
+double value(const BotSocket::SLatencyStats &stats, const int column)
+{
+    switch(column) {
+        case ENC_COUNT: return static_cast <double> (stats.count);
+        case ENC_MIN  : return stats.min;
+        case ENC_MEAN : return stats.mean;
+        case ENC_P50  : return stats.p50;
+        case ENC_P90  : return stats.p90;
+        case ENC_P99  : return stats.p99;
+        case ENC_MAX  : return stats.max;
+    }
+    return 0.;
+}
+
+}
+
+class CDiagnosticsDialogPrivate
+{
+    friend class CDiagnosticsDialog;
+
+    BotSocket::SDiagnostics diag;
+    size_t posesApplied = 0, posesDropped = 0;
+};
+
+
+
+CDiagnosticsDialog::CDiagnosticsDialog(QWidget * const parent) :
+    QDialog(parent),
+    ui(new Ui::CDiagnosticsDialog),
+    d_ptr(new CDiagnosticsDialogPrivate())
+{
+    ui->setupUi(this);
+
+    ui->twStats->setColumnCount(ENC_LAST);
+    ui->twStats->setHorizontalHeaderLabels(QStringList()
+                                           << tr("Кол-во")
+                                           << tr("Мин, мс")
+                                           << tr("Сред, мс")
+                                           << tr("p50, мс")
+                                           << tr("p90, мс")
+                                           << tr("p99, мс")
+                                           << tr("Макс, мс"));
+    ui->twStats->setRowCount(METRICS_COUNT);
+    for(int row = 0; row < METRICS_COUNT; ++row) {
+        ui->twStats->setVerticalHeaderItem(row, new QTableWidgetItem(tr(METRICS[row].title)));
+        for(int col = ENC_FIRST; col < ENC_LAST; ++col) {
+            QTableWidgetItem * const item = new QTableWidgetItem();
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            ui->twStats->setItem(row, col, item);
+        }
+    }
+    setDiagnostics(d_ptr->diag);
+    setPoseCounters(0, 0);
+
+    connect(ui->pbReset  , &QPushButton::clicked, this, &CDiagnosticsDialog::sigReset);
+    connect(ui->pbSaveCsv, &QPushButton::clicked, this, &CDiagnosticsDialog::slSaveCsv);
+    connect(ui->pbClose  , &QPushButton::clicked, this, &CDiagnosticsDialog::reject);
+}
+
+CDiagnosticsDialog::~CDiagnosticsDialog()
+{
+    delete d_ptr;
+    delete ui;
+}
+
+void CDiagnosticsDialog::setDiagnostics(const BotSocket::SDiagnostics &diag)
+{
+    d_ptr->diag = diag;
+    for(int row = 0; row < METRICS_COUNT; ++row) {
+        const BotSocket::SLatencyStats &stats = diag.*METRICS[row].stats;
+        ui->twStats->item(row, ENC_COUNT)->setText(QString::number(stats.count));
+        for(int col = ENC_MIN; col < ENC_LAST; ++col)
+            ui->twStats->item(row, col)->setText(stats.count == 0
+                                                 ? QString("-")
+                                                 : QString::number(value(stats, col), 'f', 3));
+    }
+}
+
+void CDiagnosticsDialog::setPoseCounters(const size_t applied, const size_t dropped)
+{
+    d_ptr->posesApplied = applied;
+    d_ptr->posesDropped = dropped;
+    ui->lPoses->setText(tr("Позиции инструмента: показано %1, пропущено %2")
+                        .arg(applied)
+                        .arg(dropped));
+}
+
+bool CDiagnosticsDialog::saveCsv(const QString &fName) const
+{
+    QFile file(fName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream out(&file);
+    out << "metric,count,min_ms,mean_ms,p50_ms,p90_ms,p99_ms,max_ms\n";
+    for(int row = 0; row < METRICS_COUNT; ++row) {
+        const BotSocket::SLatencyStats &stats = d_ptr->diag.*METRICS[row].stats;
+        out << METRICS[row].id << ',' << stats.count;
+        for(int col = ENC_MIN; col < ENC_LAST; ++col)
+            out << ',' << QString::number(value(stats, col), 'f', 6);
+        out << '\n';
+    }
+    out << "gui_poses_applied," << d_ptr->posesApplied << ",,,,,,\n";
+    out << "gui_poses_dropped," << d_ptr->posesDropped << ",,,,,,\n";
+    return out.status() == QTextStream::Ok;
+}
+
+void CDiagnosticsDialog::slSaveCsv()
+{
+    QString fName = QFileDialog::getSaveFileName(this,
+                                                 tr("Имя файла для сохранения"),
+                                                 QString(),
+                                                 tr("CSV (*.csv)"));
+    if (fName.isEmpty())
+        return;
+    if (!fName.endsWith(".csv", Qt::CaseInsensitive))
+        fName.append(".csv");
+    if (!saveCsv(fName))
+        QMessageBox::warning(this, windowTitle(), tr("Не удалось сохранить файл"));
+}
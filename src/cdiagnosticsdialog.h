@@ -0,0 +1,37 @@
+#ifndef CDIAGNOSTICSDIALOG_H
+#define CDIAGNOSTICSDIALOG_H
+
+#include <QDialog>
+
+#include "BotSocket/bot_socket_types.h"
+
+namespace Ui {
+class CDiagnosticsDialog;
+}
+
+class CDiagnosticsDialogPrivate;
+
+class CDiagnosticsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit CDiagnosticsDialog(QWidget * const parent = nullptr);
+    ~CDiagnosticsDialog();
+
+    void setDiagnostics(const BotSocket::SDiagnostics &diag);
+    void setPoseCounters(const size_t applied, const size_t dropped);
+    bool saveCsv(const QString &fName) const;
+
+signals:
+    void sigReset();
+
+public slots:
+    void slSaveCsv();
+
+private:
+    Ui::CDiagnosticsDialog *ui;
+    CDiagnosticsDialogPrivate * const d_ptr;
+};
+
+#endif // CDIAGNOSTICSDIALOG_H
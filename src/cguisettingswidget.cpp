@@ -12,6 +12,7 @@ class CGuiSettingsWidgetPrivate
     GUI_TYPES::TMSAA msaa;
     GUI_TYPES::TScale snapshotScale;
     size_t snapshotWidth, snapshotHeight;
+    GUI_TYPES::TDistance clearanceMargin;
     std::vector <QDoubleSpinBox *> partSpins;
     QTimer partTm;
 };
@@ -27,6 +28,7 @@ CGuiSettingsWidget::CGuiSettingsWidget(QWidget *parent) :
     d_ptr->snapshotScale = 0.;
     d_ptr->snapshotWidth = 0ul;
     d_ptr->snapshotHeight = 0ul;
+    d_ptr->clearanceMargin = 0.;
 
     ui->setupUi(this);
 
@@ -72,6 +74,7 @@ void CGuiSettingsWidget::initFromGuiSettings(const GUI_TYPES::SGuiSettings &sett
     d_ptr->snapshotScale  = settings.snapshotScale;
     d_ptr->snapshotWidth  = settings.snapshotWidth;
     d_ptr->snapshotHeight = settings.snapshotHeight;
+    d_ptr->clearanceMargin = settings.clearanceMargin;
 
     //The Part
     for(auto spin : d_ptr->partSpins)
@@ -140,6 +143,7 @@ GUI_TYPES::SGuiSettings CGuiSettingsWidget::getChangedSettings() const
     settings.snapshotScale  = d_ptr->snapshotScale;
     settings.snapshotWidth  = d_ptr->snapshotWidth;
     settings.snapshotHeight = d_ptr->snapshotHeight;
+    settings.clearanceMargin = d_ptr->clearanceMargin;
 
     //The Part
     settings.partTrX       = ui->dsbPartTrX->value();
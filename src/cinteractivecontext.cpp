@@ -40,6 +40,7 @@ static const Quantity_Color TXT_CLR  = Quantity_Color( .05    ,  .05    , 0.05
 static const Quantity_Color FACE_CLR = Quantity_Color(0.1     , 0.1     , 0.1    , Quantity_TOC_RGB);
 static const Quantity_Color PART_CLR = Quantity_Color(0.570482, 0.283555, 0.12335, Quantity_TOC_RGB);
 static const Quantity_Color PNT_CLR  = Quantity_Color( .05    ,  .05    ,  .05   , Quantity_TOC_RGB);
+static const Quantity_Color COLL_CLR = Quantity_Color(1.      , 0.      , 0.     , Quantity_TOC_RGB);
 static const double TXT_HEIGHT = 20;
 
 class CInteractiveContextPrivate
@@ -488,7 +489,7 @@ private:
         context->Display(stpnt.pntLbl, Standard_False);
         context->Display(stpnt.tPnt, Standard_False);
         context->Deactivate(stpnt.tPnt);
-        redrawPathVec();
+        pathChanged();
     }
 
     void changeTaskPoint(const size_t index, const GUI_TYPES::STaskPoint &taskPoint) {
@@ -517,7 +518,7 @@ private:
         context->RecomputePrsOnly(stpnt.pntLbl, Standard_False);
         context->Display(stpnt.tPnt, Standard_False);
         context->Deactivate(stpnt.tPnt);
-        redrawPathVec();
+        pathChanged();
     }
 
     void removeTaskPoint(const size_t index) {
@@ -533,7 +534,7 @@ private:
             taskPoints[i].pntLbl->SetText(TCollection_ExtendedString(txt.c_str(), Standard_True));
             context->RecomputePrsOnly(taskPoints[i].pntLbl, Standard_False);
         }
-        redrawPathVec();
+        pathChanged();
     }
 
     GUI_TYPES::SHomePoint getHomePoint(const size_t index) const {
@@ -575,7 +576,7 @@ private:
         context->Display(sppnt.pntLbl, Standard_False);
         context->Display(sppnt.tPnt, Standard_False);
         context->Deactivate(sppnt.tPnt);
-        redrawPathVec();
+        pathChanged();
     }
 
     void changeHomePoint(const size_t index, const GUI_TYPES::SHomePoint &homePoint) {
@@ -603,7 +604,7 @@ private:
         context->RecomputePrsOnly(sppnt.pntLbl, Standard_False);
         context->Display(sppnt.tPnt, Standard_False);
         context->Deactivate(sppnt.tPnt);
-        redrawPathVec();
+        pathChanged();
     }
 
     void removeHomePoint(const size_t index) {
@@ -619,7 +620,7 @@ private:
             homePoints[i].pntLbl->SetText(TCollection_ExtendedString(ss.str().c_str(), Standard_True));
             context->RecomputePrsOnly(homePoints[i].pntLbl, Standard_False);
         }
-        redrawPathVec();
+        pathChanged();
     }
 
     bool detectNormal(gp_Dir &normal, const gp_Pnt pnt, const Handle(AIS_Shape) &obj) const {
@@ -656,6 +657,26 @@ private:
         }
     }
 
+    void pathChanged() {
+        pathClearance.clear();
+        redrawPathVec();
+    }
+
+    void addPathVec(const gp_Pnt &from, const gp_Pnt &to) {
+        Handle(CPathVec) vec = new CPathVec(from, to);
+        const size_t index = pathVec.size();
+        if (index < pathClearance.size() && pathClearance[index].bCollision) {
+            std::stringstream ss;
+            ss.precision(1);
+            ss << std::fixed << pathClearance[index].clearance;
+            vec->SetLineColor(COLL_CLR);
+            vec->SetText(TCollection_AsciiString(ss.str().c_str()));
+        }
+        context->Display(vec, Standard_False);
+        context->Deactivate(vec);
+        pathVec.push_back(vec);
+    }
+
     void redrawPathVec() {
         for(auto vec : pathVec)
             context->Remove(vec, Standard_False);
@@ -670,22 +691,12 @@ private:
         for(auto taskPnt : taskPoints) {
             const gp_Pnt nextPoint = taskPnt.pnt->Component()->Pnt();
             if (taskPnt.task.bUseHomePnt && bHome) {
-                if (!firstPnt) {
-                    Handle(CPathVec) vec = new CPathVec(lastPos, homePos);
-                    context->Display(vec, Standard_False);
-                    context->Deactivate(vec);
-                    pathVec.push_back(vec);
-                }
-                Handle(CPathVec) vec = new CPathVec(homePos, nextPoint);
-                context->Display(vec, Standard_False);
-                context->Deactivate(vec);
-                pathVec.push_back(vec);
+                if (!firstPnt)
+                    addPathVec(lastPos, homePos);
+                addPathVec(homePos, nextPoint);
             }
             else if (!firstPnt) {
-                Handle(CPathVec) vec = new CPathVec(lastPos, nextPoint);
-                context->Display(vec, Standard_False);
-                context->Deactivate(vec);
-                pathVec.push_back(vec);
+                addPathVec(lastPos, nextPoint);
             }
             firstPnt = false;
             lastPos = nextPoint;
@@ -741,6 +752,7 @@ private:
     std::vector <SHomePoint> homePoints;
 
     std::vector <Handle(CPathVec)> pathVec;
+    std::vector <GUI_TYPES::SPathClearance> pathClearance;
 };
 
 
@@ -1089,6 +1101,12 @@ void CInteractiveContext::removeHomePoint(const size_t index)
     d_ptr->removeHomePoint(index);
 }
 
+void CInteractiveContext::setPathClearance(const std::vector <GUI_TYPES::SPathClearance> &clearance)
+{
+    d_ptr->pathClearance = clearance;
+    d_ptr->redrawPathVec();
+}
+
 gp_Dir CInteractiveContext::detectNormal(const gp_Pnt pnt) const
 {
     gp_Dir normal(0., 0., 1.);
@@ -1,6 +1,7 @@
 #ifndef CINTERACTIVECONTEXT_H
 #define CINTERACTIVECONTEXT_H
 
+#include <vector>
 #include <Graphic3d_ZLayerId.hxx>
 
 #include "gui_types.h"
@@ -95,6 +96,9 @@ public:
     void changeHomePoint(const size_t index, const GUI_TYPES::SHomePoint &homePoint);
     void removeHomePoint(const size_t index);
 
+    //one per path segment in drawing order, segments in collision are highlighted
+    void setPathClearance(const std::vector <GUI_TYPES::SPathClearance> &clearance);
+
     gp_Dir detectNormal(const gp_Pnt pnt) const;
 private:
     CInteractiveContextPrivate * const d_ptr;
@@ -10,6 +10,7 @@
 #include <QVariant>
 #include <QMessageBox>
 #include <QDebug>
+#include <QtConcurrent/QtConcurrentMap>
 
 #include <AIS_ViewController.hxx>
 
@@ -40,6 +41,9 @@
 #include "Dialogs/PathPoints/caddpathpointdialog.h"
 
 #include "cjsonfilepointssaver.h"
+#include "BotSocket/pose_batch.h"
+#include "Clearance/swept_clearance.h"
+#include "Clearance/shape_triangles.h"
 
 static constexpr double DEGREE_K = M_PI / 180.;
 
@@ -51,6 +55,9 @@ static const GUI_TYPES::TDegree   ROTATION_PRECITION = 0.000005;
 
 static const GUI_TYPES::TScale SNAP_SCALE = 5.;
 
+static const GUI_TYPES::TDistance CLEARANCE_CELL = 5.;
+static const GUI_TYPES::TDistance MESH_DEFLECTION = 0.5;
+
 static const char *backup_points_fname = "_backup_points_.task";
 
 static class CEmptySubscriber : public CAbstractMainViewportSubscriber
@@ -190,9 +197,13 @@ class CMainViewportPrivate : public AIS_ViewController
     }
 
     gp_Trsf calcLsrheadTrsf() const {
-        return calc_transform(gp_Vec(guiSettings.lheadTrX + lheadPos.globalPos.x,
-                                     guiSettings.lheadTrY + lheadPos.globalPos.y,
-                                     guiSettings.lheadTrZ + lheadPos.globalPos.z),
+        return calcLsrheadTrsf(lheadPos);
+    }
+
+    gp_Trsf calcLsrheadTrsf(const BotSocket::SBotPosition &pos) const {
+        return calc_transform(gp_Vec(guiSettings.lheadTrX + pos.globalPos.x,
+                                     guiSettings.lheadTrY + pos.globalPos.y,
+                                     guiSettings.lheadTrZ + pos.globalPos.z),
                               gp_Vec(guiSettings.lheadCenterX,
                                      guiSettings.lheadCenterY,
                                      guiSettings.lheadCenterZ),
@@ -200,9 +211,9 @@ class CMainViewportPrivate : public AIS_ViewController
                               guiSettings.lheadRotationX,
                               guiSettings.lheadRotationY,
                               guiSettings.lheadRotationZ,
-                              lheadPos.globalRotation.x,
-                              lheadPos.globalRotation.y,
-                              lheadPos.globalRotation.z);
+                              pos.globalRotation.x,
+                              pos.globalRotation.y,
+                              pos.globalRotation.z);
     }
 
     gp_Trsf calcGripTrsf() const {
@@ -472,6 +483,109 @@ class CMainViewportPrivate : public AIS_ViewController
         return res;
     }
 
+    //The laser head rotates about lheadTr + lheadCenter (see calc_transform), its
+    //model is taken at the zero position relative to that point and moved along
+    //the same segments CInteractiveContext draws
+    std::vector <GUI_TYPES::SPathClearance> checkPathClearance() {
+        using namespace GUI_TYPES;
+        std::vector <SPathClearance> result;
+        const std::vector <STaskPoint> tasks = getTaskPoints();
+        if (tasks.empty() || context->getLsrheadShape().IsNull())
+            return result;
+
+        //Poses, the home point goes first
+        const bool bHome = context->getHomePointCount() > 0;
+        PoseBatch batch;
+        batch.reserve(tasks.size() + 1);
+        if (bHome) {
+            const SHomePoint home = context->getHomePoint(0);
+            batch.add(home.globalPos, home.angle, home.normal);
+        }
+        for(const auto &task : tasks)
+            batch.add(task.globalPos, task.angle, task.normal);
+        batch.convert();
+
+        const gp_Vec pivot(guiSettings.lheadTrX + guiSettings.lheadCenterX,
+                           guiSettings.lheadTrY + guiSettings.lheadCenterY,
+                           guiSettings.lheadTrZ + guiSettings.lheadCenterZ);
+        std::vector <SweptClearance::pose_t> poses(batch.size());
+        for(size_t i = 0; i < batch.size(); ++i) {
+            const std::array <double, 6> &pos = batch.pose(i).xyzwpr;
+            gp_Quaternion rotation;
+            rotation.SetEulerAngles(gp_Extrinsic_XYZ,
+                                    pos[3] * DEGREE_K,
+                                    pos[4] * DEGREE_K,
+                                    pos[5] * DEGREE_K);
+            const gp_Mat matrix = rotation.GetMatrix();
+            for(int row = 0; row < 3; ++row)
+                for(int col = 0; col < 3; ++col)
+                    poses[i].rotation(row, col) = matrix.Value(row + 1, col + 1);
+            poses[i].translation = Eigen::Vector3d(pivot.X() + pos[0],
+                                                   pivot.Y() + pos[1],
+                                                   pivot.Z() + pos[2]);
+        }
+
+        //Segments in the order of CInteractiveContextPrivate::redrawPathVec
+        struct SSegment { size_t from, to, task; };
+        std::vector <SSegment> segments;
+        const size_t firstTask = bHome ? 1 : 0;
+        for(size_t i = 0; i < tasks.size(); ++i) {
+            const size_t pose = firstTask + i;
+            if (tasks[i].bUseHomePnt && bHome) {
+                if (i > 0)
+                    segments.push_back(SSegment{pose - 1, 0, i});
+                segments.push_back(SSegment{0, pose, i});
+            }
+            else if (i > 0) {
+                segments.push_back(SSegment{pose - 1, pose, i});
+            }
+        }
+
+        std::vector <TriangleBvh::triangle_t> obstacles, lsrhead;
+        append_shape_triangles(context->getDeskShape(), context->getTransform(ENST_DESK),
+                               ENST_DESK, MESH_DEFLECTION, obstacles);
+        append_shape_triangles(context->getPartShape(), context->getTransform(ENST_PART),
+                               ENST_PART, MESH_DEFLECTION, obstacles);
+        if (guiSettings.gripVis)
+            append_shape_triangles(context->getGripShape(), context->getTransform(ENST_GRIP),
+                                   ENST_GRIP, MESH_DEFLECTION, obstacles);
+        gp_Trsf toPivot;
+        toPivot.SetTranslation(-pivot);
+        append_shape_triangles(context->getLsrheadShape(), toPivot * calcLsrheadTrsf(BotSocket::SBotPosition()),
+                               ENST_LSRHEAD, MESH_DEFLECTION, lsrhead);
+
+        SweptClearance sweep;
+        sweep.set_cell(CLEARANCE_CELL);
+        sweep.set_margin(guiSettings.clearanceMargin);
+        sweep.set_obstacles(std::move(obstacles));
+        sweep.set_tool(lsrhead);
+        if (!sweep.ready())
+            return result;
+
+        result.resize(segments.size());
+        std::vector <size_t> indices(segments.size());
+        for(size_t i = 0; i < indices.size(); ++i)
+            indices[i] = i;
+        QtConcurrent::blockingMap(indices, [&](const size_t i) {
+            const SSegment &segment = segments[i];
+            SPathClearance &res = result[i];
+            res.taskIndex = segment.task;
+            //invalid poses are never sent, the bot socket rejects them
+            if (batch.error(segment.from) != PoseBatch::POSE_OK ||
+                    batch.error(segment.to) != PoseBatch::POSE_OK)
+                return;
+            const SweptClearance::result_t sweepRes = sweep.segment(poses[segment.from], poses[segment.to]);
+            res.clearance = sweepRes.clearance;
+            if (sweepRes.owner >= 0)
+                res.obstacle = static_cast <EN_ShapeType> (sweepRes.owner);
+            res.bCollision = sweepRes.clearance < sweep.margin();
+        });
+
+        context->setPathClearance(result);
+        view->Redraw();
+        return result;
+    }
+
     CMainViewport * const q_ptr;
     std::vector <CAbstractMainViewportSubscriber *> subs;
 
@@ -654,6 +768,11 @@ const gp_Trsf CMainViewport::getTransform(const GUI_TYPES::EN_ShapeType shType)
     return d_ptr->context->getTransform(shType);
 }
 
+gp_Trsf CMainViewport::getLsrheadTransform(const BotSocket::SBotPosition &pos) const
+{
+    return d_ptr->calcLsrheadTrsf(pos);
+}
+
 void CMainViewport::setCalibResult(const BotSocket::EN_CalibResult val)
 {
     if (val != d_ptr->calibResult)
@@ -775,6 +894,11 @@ inline static std::vector <T> movedPoints(const std::vector <T> points,
     return result;
 }
 
+std::vector<GUI_TYPES::SPathClearance> CMainViewport::checkPathClearance()
+{
+    return d_ptr->checkPathClearance();
+}
+
 void CMainViewport::makeCorrectionBySnapshot(const gp_Vec &globalDelta)
 {
     //Part correction
@@ -78,6 +78,7 @@ public:
     const TopoDS_Shape& getGripShape() const;
 
     const gp_Trsf getTransform(const GUI_TYPES::EN_ShapeType shType) const;
+    gp_Trsf getLsrheadTransform(const BotSocket::SBotPosition &pos) const;
 
     void setCalibResult(const BotSocket::EN_CalibResult val);
     BotSocket::EN_CalibResult getCalibResult() const;
@@ -97,6 +98,9 @@ public:
     void setHomePoints(const std::vector <GUI_TYPES::SHomePoint> &points);
     std::vector <GUI_TYPES::SHomePoint> getHomePoints() const;
 
+    //Sweeps the laser head along the path, one result per drawn path segment
+    std::vector <GUI_TYPES::SPathClearance> checkPathClearance();
+
     void makeCorrectionBySnapshot(const gp_Vec &globalDelta);
 
     void loadBackupPoints();
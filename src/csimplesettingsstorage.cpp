@@ -69,6 +69,7 @@ enum EN_GuiKeys
     ENGK_SNAP_SCALE,
     ENGK_SNAP_WIDTH,
     ENGK_SNAP_HEIGHT,
+    ENGK_CLEARANCE_MARGIN,
 
     //Models
     ENGK_MDL_PART,
@@ -85,6 +86,7 @@ static const std::map <TGuiKey, QString> guiKeyMap = {
     { ENGK_SNAP_SCALE    , "snap_scale"     },
     { ENGK_SNAP_WIDTH    , "snap_width"     },
     { ENGK_SNAP_HEIGHT   , "snap_height"     },
+    { ENGK_CLEARANCE_MARGIN, "clearance_margin" },
     //The Part
     { ENGK_PART_TR_X     , "part/tr_x"     },
     { ENGK_PART_TR_Y     , "part/tr_y"     },
@@ -170,6 +172,9 @@ public:
         res.snapshotScale  = readGuiValue <TScale> (ENGK_SNAP_SCALE);
         res.snapshotWidth  = readGuiValue <size_t> (ENGK_SNAP_WIDTH);
         res.snapshotHeight = readGuiValue <size_t> (ENGK_SNAP_HEIGHT);
+        res.clearanceMargin = readGuiValue <TDistance> (ENGK_CLEARANCE_MARGIN);
+        if (res.clearanceMargin <= 0.)
+            res.clearanceMargin = SGuiSettings().clearanceMargin;
         settingsFile->endGroup();
 
         //The Part
@@ -234,6 +239,7 @@ public:
         writeGuiValue(ENGK_SNAP_SCALE   , settings.snapshotScale);
         writeGuiValue(ENGK_SNAP_WIDTH   , settings.snapshotWidth);
         writeGuiValue(ENGK_SNAP_HEIGHT  , settings.snapshotHeight);
+        writeGuiValue(ENGK_CLEARANCE_MARGIN, settings.clearanceMargin);
         settingsFile->endGroup();
         //The Part
         writeGuiValue(ENGK_PART_TR_X    , settings.partTrX);
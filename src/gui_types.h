@@ -2,6 +2,7 @@
 #define GUI_TYPES_H
 
 #include <cmath>
+#include <cstddef>
 
 namespace GUI_TYPES
 {
@@ -130,6 +131,20 @@ enum EN_ShapeType
     ENST_GRIP
 };
 
+struct SPathClearance
+{
+    SPathClearance() :
+        taskIndex(0),
+        clearance(0.),
+        obstacle(ENST_DESK),
+        bCollision(false) { }
+
+    size_t taskIndex;       //task point the path segment leads to
+    TDistance clearance;    //from the laser head to the nearest obstacle
+    EN_ShapeType obstacle;
+    bool bCollision;        //closer than the clearance margin
+};
+
 }
 
 #endif // GUI_TYPES_H
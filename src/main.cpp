@@ -5,23 +5,29 @@
 #include <QFile>
 #include <QSettings>
 
+#include <memory>
+
 #include <OpenGl_GraphicDriver.hxx>
 #include <OSD_Environment.hxx>
 
 #include "csimplesettingsstorage.h"
 
 #include "BotSocket/cfanucbotsocket.h"
+#include "BotSocket/csimbotsocket.h"
 #include "log/loguru.hpp"
 
 int main(int argc, char *argv[])
 {
     //arg parsing
     bool bStyleSheet = true;
+    bool bSimulation = false;
     for(int i = 0; i < argc; ++i)
     {
         const char *arg = argv[i];
         if (strcmp(arg, "--no-ssheet") == 0)
             bStyleSheet = false;
+        else if (strcmp(arg, "--sim") == 0)
+            bSimulation = true;
     }
 
     loguru::g_stderr_verbosity = loguru::Verbosity_OFF;
@@ -50,10 +56,15 @@ int main(int argc, char *argv[])
     settings.setSettingsFName(settings_fname);
 
     MainWindow w;
-    CFanucBotSocket bot_socket;
+    // --sim runs the tasks against the cycle time model instead of the robot
+    std::unique_ptr <CAbstractBotSocket> bot_socket;
+    if (bSimulation)
+        bot_socket.reset(new CSimBotSocket());
+    else
+        bot_socket.reset(new CFanucBotSocket());
     w.init(*aGraphicDriver);
     w.setSettingsStorage(settings);
-    w.setBotSocket(bot_socket);
+    w.setBotSocket(*bot_socket);
     w.loadBackupPoints();
     if (bStyleSheet)
     {
@@ -7,6 +7,7 @@
 #include <QTime>
 #include <QLabel>
 #include <QTimer>
+#include <QElapsedTimer>
 
 #include "cabstractsettingsstorage.h"
 #include "ModelLoader/cmodelloaderfactorymethod.h"
@@ -19,9 +20,13 @@
 #include "Dialogs/PathPoints/cpathpointsorderdialog.h"
 
 #include "csnapshotdialog.h"
+#include "cdiagnosticsdialog.h"
+#include "log/loguru.hpp"
 
 static constexpr int MAX_JRNL_ROW_COUNT = 15000;
 static const int STATE_LAMP_UPDATE_INTERVAL = 200;
+static const int POSE_FRAME_INTERVAL = 16;
+static const int MAX_LISTED_COLLISIONS = 10;
 
 class CUiIface : public CAbstractUi, public CAbstractMainViewportSubscriber
 {
@@ -32,7 +37,13 @@ public:
         viewport(nullptr),
         snapView(nullptr),
         depthView(nullptr),
-        jrnl(nullptr) { }
+        jrnl(nullptr),
+        posesApplied(0),
+        posesDropped(0) {
+        frameTm.setSingleShot(true);
+        QObject::connect(&frameTm, &QTimer::timeout, [this]() { applyPoses(); });
+        frameClock.start();
+    }
 
 protected:
     void prepareComplete(const BotSocket::EN_PrepareResult) {
@@ -56,7 +67,17 @@ protected:
         viewport->setBotState(state);
     }
 
+    //Poses may come faster than the viewport redraws, only the newest one
+    //of each tool is applied once per frame
     void laserHeadPositionChanged(const BotSocket::SBotPosition &pos) final {
+        queuePose(pendingLsrhead, pos);
+    }
+
+    void gripPositionChanged(const BotSocket::SBotPosition &pos) final {
+        queuePose(pendingGrip, pos);
+    }
+
+    void applyLsrheadPosition(const BotSocket::SBotPosition &pos) {
         const QString jrnlTxt = MainWindow::tr(" Lsr: %1\t-->\tx: %2 y: %3 z: %4 "
                                                "α: %5 β: %6 γ: %7")
                 .arg(QTime::currentTime().toString("hh:mm:ss.zzz"))
@@ -78,7 +99,7 @@ protected:
         shapeTransformChaged(GUI_TYPES::ENST_LSRHEAD);
     }
 
-    void gripPositionChanged(const BotSocket::SBotPosition &pos) final {
+    void applyGripPosition(const BotSocket::SBotPosition &pos) {
         const QString jrnlTxt = MainWindow::tr("Grip: %1\t-->\tx: %2 y: %3 z: %4 "
                                                "α: %5 β: %6 γ: %7")
                 .arg(QTime::currentTime().toString("hh:mm:ss.zzz"))
@@ -102,6 +123,41 @@ protected:
             shapeTransformChaged(GUI_TYPES::ENST_PART);
     }
 
+    struct SPendingPose
+    {
+        bool pending = false;
+        BotSocket::SBotPosition pos;
+    };
+
+    void queuePose(SPendingPose &slot, const BotSocket::SBotPosition &pos) {
+        if (slot.pending)
+            ++posesDropped;
+        slot.pending = true;
+        slot.pos = pos;
+
+        if (frameTm.isActive())
+            return;
+        const qint64 wait = POSE_FRAME_INTERVAL - frameClock.elapsed();
+        if (wait <= 0)
+            applyPoses();
+        else
+            frameTm.start(static_cast <int> (wait));
+    }
+
+    void applyPoses() {
+        frameClock.restart();
+        if (pendingLsrhead.pending) {
+            pendingLsrhead.pending = false;
+            applyLsrheadPosition(pendingLsrhead.pos);
+            ++posesApplied;
+        }
+        if (pendingGrip.pending) {
+            pendingGrip.pending = false;
+            applyGripPosition(pendingGrip.pos);
+            ++posesApplied;
+        }
+    }
+
     void shapeCalibrationChanged(const GUI_TYPES::EN_ShapeType shType, const BotSocket::SBotPosition &pos)
     {
         if (std::isnan(pos.globalPos.x) ||
@@ -219,6 +275,12 @@ protected:
         return snapView->createSnapshot(settings.snapshotWidth, settings.snapshotHeight);
     }
 
+    QImage makeSnapshot(const BotSocket::SBotPosition &lsrhead) final {
+        const GUI_TYPES::SGuiSettings settings = viewport->getGuiSettings();
+        return snapView->createSnapshot(viewport->getLsrheadTransform(lsrhead),
+                                        settings.snapshotWidth, settings.snapshotHeight);
+    }
+
     void setSnapshotShapeVisible(const GUI_TYPES::EN_ShapeType model, bool visible) final {
         snapView->setShapeVisible(model, visible);
     }
@@ -237,6 +299,12 @@ protected:
         return depthView->createSnapshot(settings.snapshotWidth, settings.snapshotHeight);
     }
 
+    QImage makeDepthMap(const BotSocket::SBotPosition &lsrhead) final {
+        const GUI_TYPES::SGuiSettings settings = viewport->getGuiSettings();
+        return depthView->createSnapshot(viewport->getLsrheadTransform(lsrhead),
+                                         settings.snapshotWidth, settings.snapshotHeight);
+    }
+
     void setDepthMapShapeVisible(const GUI_TYPES::EN_ShapeType model, bool visible) {
         depthView->setShapeVisible(model, visible);
     }
@@ -272,6 +340,11 @@ private:
     QTextEdit *jrnl;
     QAction *btnStart;
     QString usrText;
+
+    SPendingPose pendingLsrhead, pendingGrip;
+    QTimer frameTm;
+    QElapsedTimer frameClock;
+    size_t posesApplied, posesDropped;
 };
 
 
@@ -285,7 +358,8 @@ private:
         settingsStorage(&emptySettingsStorage),
         stateLamp(new QLabel()),
         attachLamp(new QLabel()),
-        lampTm(new QTimer()) {
+        lampTm(new QTimer()),
+        diagDlg(nullptr) {
         lampTm->setSingleShot(false);
         lampTm->setInterval(STATE_LAMP_UPDATE_INTERVAL);
         lampTm->start();
@@ -329,7 +403,21 @@ private:
         attachActions << tBar->addWidget(attachLamp);
     }
 
-    void updateBotLamps(const QSize iconSize, const BotSocket::EN_BotState state)
+    //PING round trips of both channels, once they are known
+    static QString linkToolTip(const BotSocket::SDiagnostics &diag)
+    {
+        if (diag.relayRtt < 0 && diag.stateRtt < 0)
+            return MainWindow::tr("ОК");
+        const auto ms = [](const double rtt) {
+            return rtt < 0 ? QString("-") : QString::number(rtt, 'f', 1);
+        };
+        return MainWindow::tr("ОК, пинг: реле %1 мс, состояние %2 мс")
+                .arg(ms(diag.relayRtt))
+                .arg(ms(diag.stateRtt));
+    }
+
+    void updateBotLamps(const QSize iconSize, const BotSocket::EN_BotState state,
+                        const BotSocket::SDiagnostics &diag)
     {
         static const QPixmap red =
                 QPixmap(":/Lamps/Data/Lamps/red.png").scaled(iconSize,
@@ -349,13 +437,13 @@ private:
                 break;
             case ENBS_NOT_ATTACHED:
                 stateLamp->setPixmap(green);
-                stateLamp->setToolTip(MainWindow::tr("ОК"));
+                stateLamp->setToolTip(linkToolTip(diag));
                 attachLamp->setPixmap(red);
                 attachLamp->setToolTip(MainWindow::tr("Нет захвата"));
                 break;
             case ENBS_ATTACHED:
                 stateLamp->setPixmap(green);
-                stateLamp->setToolTip(MainWindow::tr("ОК"));
+                stateLamp->setToolTip(linkToolTip(diag));
                 attachLamp->setPixmap(green);
                 attachLamp->setToolTip(MainWindow::tr("Захват"));
                 break;
@@ -364,6 +452,53 @@ private:
         }
     }
 
+    static QString shapeName(const GUI_TYPES::EN_ShapeType shType) {
+        using namespace GUI_TYPES;
+        switch(shType) {
+            case ENST_DESK   : return MainWindow::tr("основание");
+            case ENST_PART   : return MainWindow::tr("деталь");
+            case ENST_LSRHEAD: return MainWindow::tr("лазерная головка");
+            case ENST_GRIP   : return MainWindow::tr("захват");
+        }
+        return QString();
+    }
+
+    //The laser head is swept along the path before the start, if it comes closer
+    //to the desk, the part or the grip than the clearance margin the user decides
+    bool checkPathClearance(CMainViewport &view, QWidget *parent) {
+        QElapsedTimer timer;
+        timer.start();
+        const std::vector <GUI_TYPES::SPathClearance> clearance = view.checkPathClearance();
+        LOG_F(INFO, "Path clearance checked: %zu segments in %.3f ms", clearance.size(), timer.nsecsElapsed() / 1e6);
+
+        QStringList collisions;
+        int count = 0;
+        for(const auto &segment : clearance) {
+            if (!segment.bCollision)
+                continue;
+            if (++count <= MAX_LISTED_COLLISIONS)
+                collisions << MainWindow::tr("точка %1: %2 мм, %3")
+                              .arg(segment.taskIndex + 1)
+                              .arg(segment.clearance, 0, 'f', 1)
+                              .arg(shapeName(segment.obstacle));
+        }
+        if (count == 0)
+            return true;
+        if (count > MAX_LISTED_COLLISIONS)
+            collisions << "...";
+
+        return QMessageBox::warning(parent,
+                                    MainWindow::tr("Проверка траектории"),
+                                    MainWindow::tr("Головка проходит ближе %1 мм к оснастке или детали "
+                                                   "на %2 участках траектории:\n%3\n\nЗапустить обработку?")
+                                    .arg(view.getGuiSettings().clearanceMargin, 0, 'f', 1)
+                                    .arg(count)
+                                    .arg(collisions.join("\n")),
+                                    QMessageBox::Yes | QMessageBox::No,
+                                    QMessageBox::No)
+                == QMessageBox::Yes;
+    }
+
 private:
     std::map <GUI_TYPES::TMSAA, QAction *> mapMsaa;
 
@@ -373,6 +508,7 @@ private:
     QLabel * const stateLamp, * const attachLamp;
     QList <QAction *> attachActions;
     QTimer * const lampTm;
+    CDiagnosticsDialog *diagDlg;
     CUiIface uiIface;
 };
 
@@ -603,6 +739,22 @@ void MainWindow::slClearJrnl()
     ui->teJrnl->clear();
 }
 
+void MainWindow::slDiagnosticsDlg()
+{
+    if (!d_ptr->diagDlg) {
+        d_ptr->diagDlg = new CDiagnosticsDialog(this);
+        connect(d_ptr->diagDlg, &CDiagnosticsDialog::sigReset, [this]() {
+            d_ptr->uiIface.resetDiagnostics();
+            d_ptr->uiIface.posesApplied = d_ptr->uiIface.posesDropped = 0;
+        });
+    }
+    d_ptr->diagDlg->setDiagnostics(d_ptr->uiIface.getDiagnostics());
+    d_ptr->diagDlg->setPoseCounters(d_ptr->uiIface.posesApplied,
+                                    d_ptr->uiIface.posesDropped);
+    d_ptr->diagDlg->show();
+    d_ptr->diagDlg->raise();
+}
+
 void MainWindow::slCallibCalc()
 {
     const BotSocket::EN_CalibResult calibRes =
@@ -689,6 +841,8 @@ void MainWindow::slCallibApply()
 
 void MainWindow::slStart()
 {
+    if (!d_ptr->checkPathClearance(*ui->mainView, this))
+        return;
     ui->mainView->setUiState(GUI_TYPES::ENUS_BOT_WORKED);
     d_ptr->uiIface.startTasks(ui->mainView->getHomePoints(),
                               ui->mainView->getTaskPoints());
@@ -705,7 +859,13 @@ void MainWindow::slStop()
 
 void MainWindow::slUpdateBotLamps()
 {
-    d_ptr->updateBotLamps(ui->toolBar->iconSize(), ui->mainView->getBotState());
+    const BotSocket::SDiagnostics diag = d_ptr->uiIface.getDiagnostics();
+    d_ptr->updateBotLamps(ui->toolBar->iconSize(), ui->mainView->getBotState(), diag);
+    if (d_ptr->diagDlg && d_ptr->diagDlg->isVisible()) {
+        d_ptr->diagDlg->setDiagnostics(diag);
+        d_ptr->diagDlg->setPoseCounters(d_ptr->uiIface.posesApplied,
+                                        d_ptr->uiIface.posesDropped);
+    }
 }
 
 void MainWindow::configMenu()
@@ -741,6 +901,9 @@ void MainWindow::configMenu()
     //teJrnl
     connect(ui->actionClearJrnl, SIGNAL(triggered(bool)), SLOT(slClearJrnl()));
 
+    //Diagnostics
+    connect(ui->actionDiagnostics, SIGNAL(triggered(bool)), SLOT(slDiagnosticsDlg()));
+
     //Menu "Algorithms"
     connect(ui->actionPartDetection, SIGNAL(triggered(bool)), SLOT(slPartDetection()));
 }
@@ -45,6 +45,7 @@ private slots:
     void slMsaa();
     void slFpsCounter(bool enabled);
     void slClearJrnl();
+    void slDiagnosticsDlg();
 
     //callib
     void slCallibApply();
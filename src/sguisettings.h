@@ -14,6 +14,7 @@ struct SGuiSettings
         snapshotScale(5.),
         snapshotWidth(2000ul),
         snapshotHeight(2000ul),
+        clearanceMargin(5.),
         //The Part
         partTrX(0.),
         partTrY(0.),
@@ -74,6 +75,7 @@ struct SGuiSettings
     TScale snapshotScale;
     size_t snapshotWidth;
     size_t snapshotHeight;
+    TDistance clearanceMargin;
 
     //The Part
     TDistance partTrX;
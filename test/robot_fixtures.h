@@ -0,0 +1,21 @@
+#pragma once
+
+#include "BotSocket/opw_kinematics.h"
+
+// FANUC R-2000iB/200R
+inline OpwKinematics::parameters_t r2000ib()
+{
+    OpwKinematics::parameters_t p;
+    p.a1 = 720;
+    p.a2 = -225;
+    p.c1 = 600;
+    p.c2 = 1075;
+    p.c3 = 1280;
+    p.c4 = 235;
+    p.offsets = {{0, 0, -90, 0, 0, 0}};
+    p.signs = {{1, 1, -1, -1, -1, -1}};
+    p.j23_factor = 1;
+    p.joint_min = {{-180, -60, -120, -360, -125, -360}};
+    p.joint_max = {{ 180,  75,  190,  360,  125,  360}};
+    return p;
+}
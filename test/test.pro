@@ -2,11 +2,49 @@ QT += core testlib
 
 CONFIG += c++14 testcase no_testcase_installs
 
-HEADERS = catch2/catch.hpp
+DEFINES += CATCH_CONFIG_ENABLE_BENCHMARKING
+
+HEADERS = catch2/catch.hpp \
+    robot_fixtures.h
+
+INCLUDEPATH += ../src
 
 SOURCES += \
     test_main.cpp \
     test_point_pair_part_referencer.cpp \
+    test_simple_message_codec.cpp \
+    test_simple_message_framer.cpp \
+    test_simple_message_dispatch.cpp \
+    test_seqlock.cpp \
+    test_pose_history.cpp \
+    test_traffic_capture.cpp \
+    test_latency_histogram.cpp \
+    test_motion_state_tracker.cpp \
+    test_link_health.cpp \
+    test_pulse_reply_tracker.cpp \
+    test_pose_batch.cpp \
+    test_opw_kinematics.cpp \
+    test_cycle_time_model.cpp \
+    test_task_order_optimizer.cpp \
+    test_swept_clearance.cpp \
+    test_tool_spin_planner.cpp \
+    test_snapshot_registration.cpp \
+    ../src/BotSocket/simple_message_codec.cpp \
+    ../src/BotSocket/simple_message_framer.cpp \
+    ../src/BotSocket/pose_history.cpp \
+    ../src/BotSocket/traffic_capture.cpp \
+    ../src/BotSocket/latency_histogram.cpp \
+    ../src/BotSocket/motion_state_tracker.cpp \
+    ../src/BotSocket/link_health.cpp \
+    ../src/BotSocket/pulse_reply_tracker.cpp \
+    ../src/BotSocket/pose_batch.cpp \
+    ../src/BotSocket/opw_kinematics.cpp \
+    ../src/BotSocket/cycle_time_model.cpp \
+    ../src/BotSocket/task_order_optimizer.cpp \
+    ../src/BotSocket/tool_spin_planner.cpp \
+    ../src/Clearance/triangle_bvh.cpp \
+    ../src/Clearance/swept_clearance.cpp \
+    ../src/Registration/snapshot_registration.cpp \
     ../src/log/loguru.cpp
 
 unix: LIBS += -ldl -lpthread
@@ -0,0 +1,87 @@
+#include <catch2/catch.hpp>
+
+#include "../src/BotSocket/cycle_time_model.h"
+
+static CycleTimeModel::waypoint_t make_point(int task, double x, double delay = 0, bool calib = false)
+{
+    CycleTimeModel::waypoint_t point;
+    point.task = task;
+    point.pose.xyzwpr = {{x, 0, 0, 0, 0, 0}};
+    point.joints = {{x / 10, 0, 0, 0, 0, 0}};
+    point.delay = delay;
+    point.calib = calib;
+    return point;
+}
+
+TEST_CASE( "trapezoidal and triangular profiles", "[cycle_time_model]" )
+{
+    // reaches 100 mm/s after 0.1 s and 5 mm
+    CHECK(CycleTimeModel::profile_time(100, 100, 1000) == Approx(1.1));
+    CHECK(CycleTimeModel::profile_time(-100, 100, 1000) == Approx(1.1));
+    CHECK(CycleTimeModel::profile_time(10, 100, 1000) == Approx(0.2));
+    CHECK(CycleTimeModel::profile_time(2.5, 100, 1000) == Approx(0.1));
+    CHECK(CycleTimeModel::profile_time(100, 100, 0) == Approx(1.0));
+    CHECK(CycleTimeModel::profile_time(0, 100, 1000) == 0);
+}
+
+TEST_CASE( "slowest axis decides the move time", "[cycle_time_model]" )
+{
+    CycleTimeModel model;
+    CycleTimeModel::config_t config;
+    config.linear_speed = 100;
+    config.linear_accel = 0;
+    config.angular_speed = 10;
+    config.angular_accel = 0;
+    config.joint_speed = {{10, 10, 10, 10, 10, 1}};
+    config.joint_accel = {{0, 0, 0, 0, 0, 0}};
+    model.set_config(config);
+
+    xyzwpr_data a, b;
+    b.xyzwpr = {{50, 0, 0, 0, 0, 0}};
+    CHECK(model.move_time(a, b) == Approx(0.5));
+    b.xyzwpr[5] = 20;
+    CHECK(model.move_time(a, b) == Approx(2.0));
+
+    joint_data from = {{0, 0, 0, 0, 0, 0}}, to = {{10, 0, 0, 0, 0, 3}};
+    CHECK(model.move_time(from, to) == Approx(3.0));
+}
+
+TEST_CASE( "schedule adds settling, delays and calibration", "[cycle_time_model]" )
+{
+    CycleTimeModel model;
+    CycleTimeModel::config_t config;
+    config.linear_speed = 100;
+    config.linear_accel = 0;
+    config.settle_time = 0.2;
+    config.calib_time = 3;
+    model.set_config(config);
+
+    std::vector<CycleTimeModel::waypoint_t> path = {
+        make_point(-1, 100),            // home
+        make_point(0, 200),             // passed without a stop
+        make_point(1, 300, 1.5),        // delay
+        make_point(2, 300, 0, true),    // snapshot at the same point
+        make_point(3, 400)              // end of the job
+    };
+    const std::vector<CycleTimeModel::step_t> steps = model.schedule(make_point(-1, 0), path, false);
+    REQUIRE(steps.size() == path.size());
+
+    CHECK(steps[0].task == -1);
+    CHECK(steps[0].move == Approx(1.0));
+    CHECK(steps[0].settle == 0);
+    CHECK(steps[1].settle == 0);
+    CHECK(steps[2].settle == Approx(0.2));
+    CHECK(steps[2].delay == Approx(1.5));
+    CHECK(steps[3].move == 0);
+    CHECK(steps[3].calib == Approx(3));
+    CHECK(steps[3].settle == Approx(0.2));
+    CHECK(steps[4].settle == Approx(0.2));
+
+    for (size_t i = 1; i < steps.size(); ++i)
+        CHECK(steps[i].start == Approx(steps[i - 1].end()));
+    CHECK(steps.back().end() == Approx(4 * 1.0 + 3 * 0.2 + 1.5 + 3));
+
+    // joint moves follow the joint speeds instead of the TCP
+    const std::vector<CycleTimeModel::step_t> joint_steps = model.schedule(make_point(-1, 0), path, true);
+    CHECK(joint_steps[0].move == Approx(CycleTimeModel::profile_time(10, config.joint_speed[0], config.joint_accel[0])));
+}
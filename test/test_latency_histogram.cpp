@@ -0,0 +1,61 @@
+#include <catch2/catch.hpp>
+
+#include "../src/BotSocket/latency_histogram.h"
+
+TEST_CASE( "latency histogram percentiles", "[latency_histogram]" )
+{
+    LatencyHistogram histogram;
+    CHECK(histogram.count() == 0);
+    CHECK(histogram.percentile(0.5) == 0);
+
+    // 1..1000 ms
+    for(int i=1; i<=1000; i++)
+        histogram.add(i);
+
+    CHECK(histogram.count() == 1000);
+    CHECK(histogram.min() == 1);
+    CHECK(histogram.max() == 1000);
+    CHECK(histogram.mean() == Approx(500.5));
+
+    // within the bucket resolution
+    CHECK(histogram.percentile(0.5) == Approx(500).epsilon(0.05));
+    CHECK(histogram.percentile(0.9) == Approx(900).epsilon(0.05));
+    CHECK(histogram.percentile(0.99) == Approx(990).epsilon(0.05));
+    CHECK(histogram.percentile(1) == Approx(1000).epsilon(0.05));
+    CHECK(histogram.percentile(0) == Approx(1).epsilon(0.05));
+
+    BotSocket::SLatencyStats stats = histogram.stats();
+    CHECK(stats.count == 1000);
+    CHECK(stats.p90 == histogram.percentile(0.9));
+
+    histogram.reset();
+    CHECK(histogram.count() == 0);
+    CHECK(histogram.stats().max == 0);
+}
+
+TEST_CASE( "latency histogram out of range values", "[latency_histogram]" )
+{
+    LatencyHistogram histogram;
+    histogram.add(-1);
+    histogram.add(0);
+    histogram.add(1e9);
+
+    CHECK(histogram.count() == 3);
+    CHECK(histogram.min() == 0);
+    CHECK(histogram.max() == 1e9);
+    // percentiles stay within the observed range
+    CHECK(histogram.percentile(0.1) == 0);
+    CHECK(histogram.percentile(1) == 1e9);
+}
+
+TEST_CASE( "latency histogram keeps small values apart", "[latency_histogram]" )
+{
+    LatencyHistogram histogram;
+    for(int i=0; i<99; i++)
+        histogram.add(0.002);   // 2 us decode
+    histogram.add(5);
+
+    CHECK(histogram.percentile(0.5) == Approx(0.002).epsilon(0.05));
+    CHECK(histogram.percentile(0.99) == Approx(0.002).epsilon(0.05));
+    CHECK(histogram.percentile(1) == 5);
+}
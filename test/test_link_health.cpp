@@ -0,0 +1,68 @@
+#include <catch2/catch.hpp>
+
+#include "../src/BotSocket/link_health.h"
+
+TEST_CASE( "link health pings at the interval", "[link_health]" )
+{
+    LinkHealth health;
+    health.set_timing(0.2, 0.8);
+    health.reset(10);
+
+    CHECK(health.ping_due(10));
+    health.on_ping_sent(10);
+    CHECK_FALSE(health.ping_due(10.1));
+
+    CHECK(health.on_ping_reply(10.01) == Approx(0.01));
+    CHECK(health.rtt() == Approx(0.01));
+    CHECK_FALSE(health.ping_due(10.15));
+    CHECK(health.ping_due(10.2));
+
+    // a reply without a request does not count as a round trip
+    CHECK(health.on_ping_reply(10.3) < 0);
+    CHECK(health.rtt() == Approx(0.01));
+}
+
+TEST_CASE( "link health smooths the round trip", "[link_health]" )
+{
+    LinkHealth health;
+    health.set_timing(0.2, 0.8);
+    health.reset(0);
+    CHECK(health.rtt() < 0);
+
+    health.on_ping_sent(0);
+    health.on_ping_reply(0.01);
+    health.on_ping_sent(0.2);
+    health.on_ping_reply(0.26);
+    CHECK(health.rtt() > 0.01);
+    CHECK(health.rtt() < 0.06);
+}
+
+TEST_CASE( "link is lost after timeout of silence", "[link_health]" )
+{
+    LinkHealth health;
+    health.set_timing(0.2, 0.8);
+    health.reset(0);
+
+    health.on_ping_sent(0);
+    CHECK(health.alive(0.5));
+    CHECK_FALSE(health.alive(0.9));
+
+    // topics keep a link alive even if PING is never answered
+    health.reset(0);
+    health.on_ping_sent(0);
+    for(int i=1; i<=20; i++)
+        health.on_traffic(i * 0.1);
+    CHECK(health.alive(2.5));
+    CHECK_FALSE(health.ping_due(0.5));
+    CHECK(health.ping_due(0.8)); // the unanswered PING is repeated
+}
+
+TEST_CASE( "disabled link health never drops the link", "[link_health]" )
+{
+    LinkHealth health;
+    health.set_timing(0, 0);
+    health.reset(0);
+    CHECK_FALSE(health.enabled());
+    CHECK_FALSE(health.ping_due(100));
+    CHECK(health.alive(100));
+}
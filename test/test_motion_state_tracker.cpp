@@ -0,0 +1,72 @@
+#include <catch2/catch.hpp>
+
+#include "../src/BotSocket/motion_state_tracker.h"
+
+static xyzwpr_data make_pose(double x, double w = 0, double p = 0, double r = 0)
+{
+    xyzwpr_data pos;
+    pos.xyzwpr = {{x, 0, 0, w, p, r}};
+    return pos;
+}
+
+TEST_CASE( "motion tracker settles at the target", "[motion_state_tracker]" )
+{
+    MotionStateTracker tracker;
+    tracker.start(0, make_pose(100));
+
+    // approaching
+    for(int i=0; i<=10; i++)
+    {
+        tracker.on_pose(i * 0.1, make_pose(i * 10));
+        if(i < 10)
+            CHECK(tracker.update(i * 0.1) == MotionStateTracker::MOVING);
+    }
+
+    // at the target, but has to stay there for settle_time
+    CHECK(tracker.update(1.1) == MotionStateTracker::MOVING);
+    tracker.on_pose(1.2, make_pose(100.1));
+    CHECK(tracker.update(1.25) == MotionStateTracker::SETTLED);
+}
+
+TEST_CASE( "motion tracker waits for in_motion", "[motion_state_tracker]" )
+{
+    MotionStateTracker tracker;
+    tracker.start(0, make_pose(0));
+    tracker.on_pose(0, make_pose(0));
+    tracker.on_status(0.05, true);
+    CHECK(tracker.update(1.0) == MotionStateTracker::MOVING);
+
+    tracker.on_status(1.0, false);
+    CHECK(tracker.update(1.1) == MotionStateTracker::MOVING);
+    CHECK(tracker.update(1.25) == MotionStateTracker::SETTLED);
+}
+
+TEST_CASE( "motion tracker times out without motion", "[motion_state_tracker]" )
+{
+    MotionStateTracker tracker;
+    MotionStateTracker::config_t config;
+    config.timeout = 2;
+    tracker.set_config(config);
+    tracker.start(0, make_pose(100));
+
+    // never reaches the target and does not move
+    tracker.on_pose(0.5, make_pose(0));
+    tracker.on_pose(1.5, make_pose(0));
+    CHECK(tracker.update(1.9) == MotionStateTracker::MOVING);
+    CHECK(tracker.update(2.0) == MotionStateTracker::TIMED_OUT);
+
+    // moving robot postpones the timeout
+    tracker.start(10, make_pose(100));
+    tracker.on_pose(11, make_pose(10));
+    tracker.on_pose(12.5, make_pose(20));
+    CHECK(tracker.update(14) == MotionStateTracker::MOVING);
+    CHECK(tracker.update(14.5) == MotionStateTracker::TIMED_OUT);
+}
+
+TEST_CASE( "rotation distance does not depend on euler representation", "[motion_state_tracker]" )
+{
+    // the same orientation, W and R swap near P = 90
+    CHECK(MotionStateTracker::rotation_angle(make_pose(0, 30, 90, 0), make_pose(0, 0, 90, -30)) == Approx(0).margin(1e-6));
+    CHECK(MotionStateTracker::rotation_angle(make_pose(0, 0, 0, 179), make_pose(0, 0, 0, -179)) == Approx(2));
+    CHECK(MotionStateTracker::rotation_angle(make_pose(0, 10, 0, 0), make_pose(0)) == Approx(10));
+}
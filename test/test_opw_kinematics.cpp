@@ -0,0 +1,114 @@
+#include <catch2/catch.hpp>
+
+#include <random>
+#include "../src/BotSocket/opw_kinematics.h"
+#include "robot_fixtures.h"
+
+static bool same_pose(const Eigen::Isometry3d &a, const Eigen::Isometry3d &b)
+{
+    return (a.translation() - b.translation()).norm() < 1e-6 &&
+           (a.linear() - b.linear()).norm() < 1e-9;
+}
+
+TEST_CASE( "every inverse solution reaches the pose", "[opw_kinematics]" )
+{
+    OpwKinematics kin;
+    kin.set_parameters(r2000ib());
+    REQUIRE(kin.valid());
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> angle(-40, 40);
+    for(int n=0; n<200; n++)
+    {
+        joint_data joints;
+        for(double &j : joints)
+            j = angle(random);
+        // away from the singularities: wrist center over the base, J5 at zero
+        joints[1] = fabs(joints[1]);
+        if(fabs(joints[4]) < 5)
+            joints[4] = 5;
+        const Eigen::Isometry3d pose = kin.forward(joints);
+
+        int found = 0;
+        for(const joint_data &solution : kin.inverse(pose))
+        {
+            if(!std::isfinite(solution[0]) || !std::isfinite(solution[1]) || !std::isfinite(solution[2]))
+                continue;
+            found++;
+            CHECK(same_pose(kin.forward(solution), pose));
+        }
+        CHECK(found >= 2);
+
+        joint_data result;
+        REQUIRE(kin.select(kin.inverse(pose), joints, result) == OpwKinematics::IK_OK);
+        for(int i=0; i<6; i++)
+            CHECK(result[i] == Approx(joints[i]).margin(1e-6));
+    }
+}
+
+TEST_CASE( "tool frame is applied both ways", "[opw_kinematics]" )
+{
+    OpwKinematics::parameters_t p = r2000ib();
+    p.tool.xyzwpr = {{10, -20, 150, 0, 30, 90}};
+    OpwKinematics kin;
+    kin.set_parameters(p);
+
+    const joint_data joints = {{10, 20, -10, 30, -40, 50}};
+    const xyzwpr_data pose = OpwKinematics::to_xyzwpr(kin.forward(joints));
+
+    joint_data result;
+    REQUIRE(kin.solve(pose, joints, result) == OpwKinematics::IK_OK);
+    for(int i=0; i<6; i++)
+        CHECK(result[i] == Approx(joints[i]).margin(1e-6));
+}
+
+TEST_CASE( "xyzwpr conversion round trip", "[opw_kinematics]" )
+{
+    xyzwpr_data pose;
+    pose.xyzwpr = {{100, 200, 300, 10, -20, 170}};
+    const xyzwpr_data result = OpwKinematics::to_xyzwpr(OpwKinematics::to_isometry(pose));
+    for(int i=0; i<6; i++)
+        CHECK(result.xyzwpr[i] == Approx(pose.xyzwpr[i]));
+}
+
+TEST_CASE( "inverse kinematics reports why a pose is rejected", "[opw_kinematics]" )
+{
+    OpwKinematics kin;
+    kin.set_parameters(r2000ib());
+    const joint_data seed = {{0, 0, 0, 0, 0, 0}};
+    joint_data result;
+
+    xyzwpr_data far;
+    far.xyzwpr = {{10000, 0, 0, 0, 180, 0}};
+    CHECK(kin.solve(far, seed, result) == OpwKinematics::IK_UNREACHABLE);
+
+    // J5 at zero
+    const xyzwpr_data wrist = OpwKinematics::to_xyzwpr(kin.forward({{0, 10, 10, 0, 0, 0}}));
+    CHECK(kin.solve(wrist, seed, result) == OpwKinematics::IK_SINGULAR);
+
+    // J1 has to turn beyond its limits
+    OpwKinematics::parameters_t p = r2000ib();
+    p.joint_min[0] = -10;
+    p.joint_max[0] = 10;
+    kin.set_parameters(p);
+    const xyzwpr_data side = OpwKinematics::to_xyzwpr(kin.forward({{0, 10, 10, 0, 30, 0}}));
+    CHECK(kin.solve(side, seed, result) == OpwKinematics::IK_OK);
+    xyzwpr_data behind = side;
+    behind.xyzwpr[0] = -side.xyzwpr[0] * 0.3;
+    behind.xyzwpr[1] = side.xyzwpr[0];
+    CHECK(kin.solve(behind, seed, result) == OpwKinematics::IK_JOINT_LIMIT);
+}
+
+TEST_CASE( "joints are unwrapped towards the seed", "[opw_kinematics]" )
+{
+    OpwKinematics kin;
+    kin.set_parameters(r2000ib());
+    const joint_data joints = {{0, 10, 10, 0, 30, 170}};
+    const xyzwpr_data pose = OpwKinematics::to_xyzwpr(kin.forward(joints));
+
+    joint_data seed = joints;
+    seed[5] = -180;
+    joint_data result;
+    REQUIRE(kin.solve(pose, seed, result) == OpwKinematics::IK_OK);
+    CHECK(result[5] == Approx(-190));
+}
@@ -0,0 +1,83 @@
+#include <catch2/catch.hpp>
+
+#include <limits>
+#include "../src/BotSocket/pose_batch.h"
+
+using GUI_TYPES::SVertex;
+using GUI_TYPES::SRotationAngle;
+
+static void check_pose(const xyzwpr_data &pose, std::array<double, 6> expected)
+{
+    for(int i=0; i<6; i++)
+        CHECK(pose.xyzwpr[i] == Approx(expected[i]).margin(1e-9));
+}
+
+TEST_CASE( "pose batch keeps points along Z as they are", "[pose_batch]" )
+{
+    PoseBatch batch;
+    batch.add(SVertex(1, 2, 3), SRotationAngle(0, 0, 30), SVertex(0, 0, 1));
+    batch.convert();
+    REQUIRE(batch.size() == 1);
+    CHECK(batch.first_error() == 1);
+    check_pose(batch.pose(0), {{1, 2, 3, 0, 0, 30}});
+}
+
+TEST_CASE( "pose batch turns the tool to the normal", "[pose_batch]" )
+{
+    PoseBatch batch;
+    batch.add(SVertex(), SRotationAngle(), SVertex(2, 0, 0));   // normal needs not be unit
+    batch.add(SVertex(), SRotationAngle(), SVertex(0, -1, 0));
+    batch.add(SVertex(), SRotationAngle(), SVertex(0, 0, -1));  // opposite to Z
+    batch.convert();
+    CHECK(batch.first_error() == batch.size());
+    check_pose(batch.pose(0), {{0, 0, 0, 0, 90, 0}});
+    check_pose(batch.pose(1), {{0, 0, 0, 90, 0, 0}});
+    check_pose(batch.pose(2), {{0, 0, 0, 180, 0, 180}});
+}
+
+TEST_CASE( "pose batch applies user2world", "[pose_batch]" )
+{
+    PoseBatch batch;
+    // 90 degrees around Z and a shift
+    batch.set_transform({{0, -1, 0, 100,
+                          1,  0, 0, 200,
+                          0,  0, 1, 300}});
+    batch.add(SVertex(10, 0, 0), SRotationAngle(0, 0, 10), SVertex(0, 0, 1));
+    batch.convert();
+    check_pose(batch.pose(0), {{100, 210, 300, 0, 0, 100}});
+}
+
+TEST_CASE( "pose batch rejects invalid points", "[pose_batch]" )
+{
+    PoseBatch batch;
+    batch.set_reach(1000);
+    batch.add(SVertex(0, 0, 500), SRotationAngle(), SVertex(0, 0, 1));
+    batch.add(SVertex(std::numeric_limits<double>::quiet_NaN(), 0, 0), SRotationAngle(), SVertex(0, 0, 1));
+    batch.add(SVertex(), SRotationAngle(), SVertex(0, 0, 0));
+    batch.add(SVertex(0, 0, 1500), SRotationAngle(), SVertex(0, 0, 1));
+    batch.convert();
+
+    CHECK(batch.error(0) == PoseBatch::POSE_OK);
+    CHECK(batch.error(1) == PoseBatch::POSE_NOT_FINITE);
+    CHECK(batch.error(2) == PoseBatch::POSE_BAD_NORMAL);
+    CHECK(batch.error(3) == PoseBatch::POSE_OUT_OF_REACH);
+    CHECK(batch.first_error() == 1);
+}
+
+TEST_CASE( "pose batch detects changed input", "[pose_batch]" )
+{
+    PoseBatch a, b;
+    for(int i=0; i<40; i++)
+    {
+        a.add(SVertex(i, 0, 0), SRotationAngle(), SVertex(0, 0, 1));
+        b.add(SVertex(i, 0, 0), SRotationAngle(), SVertex(0, 0, 1));
+    }
+    CHECK(a.same_input(b));
+
+    b.set_reach(10);
+    CHECK_FALSE(a.same_input(b));
+    b.set_reach(0);
+
+    b.add(SVertex(), SRotationAngle(), SVertex(0, 0, 1));
+    CHECK_FALSE(a.same_input(b));
+}
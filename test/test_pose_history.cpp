@@ -0,0 +1,46 @@
+#include <catch2/catch.hpp>
+
+#include "../src/BotSocket/pose_history.h"
+
+using BotSocket::SBotPosition;
+
+TEST_CASE( "pose history interpolates between samples", "[pose_history]" )
+{
+    PoseHistory history;
+    SBotPosition pos;
+    CHECK_FALSE(history.sample(0, pos));
+
+    history.push(1.0, SBotPosition(0, 0, 0, 0, 0, 170));
+    history.push(1.1, SBotPosition(10, 20, 30, 0, 0, -170));
+
+    REQUIRE(history.sample(1.05, pos));
+    CHECK(pos.globalPos.x == Approx(5));
+    CHECK(pos.globalPos.y == Approx(10));
+    CHECK(pos.globalPos.z == Approx(15));
+    // goes through 180, not through 0
+    CHECK(std::abs(pos.globalRotation.z) == Approx(180));
+
+    // clamped at both ends
+    REQUIRE(history.sample(0.5, pos));
+    CHECK(pos.globalPos.x == 0);
+    REQUIRE(history.sample(2.0, pos));
+    CHECK(pos.globalPos.x == 10);
+}
+
+TEST_CASE( "pose history keeps the latest samples", "[pose_history]" )
+{
+    PoseHistory history;
+    for(size_t i=0; i<2 * PoseHistory::CAPACITY; i++)
+        history.push(0.1 * i, SBotPosition(i, 0, 0, 0, 0, 0));
+
+    CHECK(history.interval() == Approx(0.1));
+    CHECK(history.latest_time() == Approx(0.1 * (2 * PoseHistory::CAPACITY - 1)));
+
+    SBotPosition pos;
+    REQUIRE(history.sample(history.latest_time() - 0.15, pos));
+    CHECK(pos.globalPos.x == Approx(2 * PoseHistory::CAPACITY - 2.5));
+
+    // samples older than the capacity are gone
+    REQUIRE(history.sample(0, pos));
+    CHECK(pos.globalPos.x == PoseHistory::CAPACITY);
+}
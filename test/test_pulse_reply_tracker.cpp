@@ -0,0 +1,59 @@
+#include <catch2/catch.hpp>
+
+#include "../src/BotSocket/pulse_reply_tracker.h"
+
+TEST_CASE( "pulse replies of a path", "[pulse_reply_tracker]" )
+{
+    PulseReplyTracker pulses;
+    pulses.reset(3);
+    CHECK_FALSE(pulses.pending());
+
+    pulses.on_point_sent(0);
+    pulses.on_point_sent(1);
+    pulses.on_pulse_sent(1);
+    pulses.on_pulse_sent(1);
+    CHECK(pulses.pending());
+
+    CHECK(pulses.on_reply(0) == PulseReplyTracker::REPLY_UNEXPECTED);
+    CHECK(pulses.on_reply(1) == PulseReplyTracker::REPLY_CURRENT);
+    CHECK(pulses.pending());
+    CHECK(pulses.on_reply(1) == PulseReplyTracker::REPLY_CURRENT);
+    CHECK_FALSE(pulses.pending());
+    CHECK(pulses.on_reply(1) == PulseReplyTracker::REPLY_UNEXPECTED);
+    CHECK(pulses.on_reply(3) == PulseReplyTracker::REPLY_UNEXPECTED);
+    CHECK(pulses.on_reply(-1) == PulseReplyTracker::REPLY_UNEXPECTED);
+}
+
+TEST_CASE( "pulse replies of a rejected and retried point", "[pulse_reply_tracker]" )
+{
+    PulseReplyTracker pulses;
+    pulses.reset(2);
+
+    // point 1 is rejected, its pulse is answered only after the retry went out
+    pulses.on_point_sent(1);
+    pulses.on_pulse_sent(1);
+    pulses.on_point_sent(1);
+    pulses.on_pulse_sent(1);
+
+    SECTION( "the first pulse was accepted" )
+    {
+        CHECK(pulses.on_reply(1) == PulseReplyTracker::REPLY_STALE);
+        // the path is not finished before the pulse of the retry is acknowledged
+        CHECK(pulses.pending());
+        CHECK(pulses.on_reply(1) == PulseReplyTracker::REPLY_CURRENT);
+        CHECK_FALSE(pulses.pending());
+    }
+    SECTION( "the first pulse was rejected with its point" )
+    {
+        // a failure of the earlier send does not stop the retried path
+        CHECK(pulses.on_reply(1) == PulseReplyTracker::REPLY_STALE);
+        CHECK(pulses.on_reply(1) == PulseReplyTracker::REPLY_CURRENT);
+        CHECK(pulses.on_reply(1) == PulseReplyTracker::REPLY_UNEXPECTED);
+    }
+    SECTION( "a new path forgets the old replies" )
+    {
+        pulses.reset(2);
+        CHECK_FALSE(pulses.pending());
+        CHECK(pulses.on_reply(1) == PulseReplyTracker::REPLY_UNEXPECTED);
+    }
+}
@@ -0,0 +1,73 @@
+#include <catch2/catch.hpp>
+
+#include <thread>
+
+#include "../src/BotSocket/seqlock.h"
+#include "../src/BotSocket/spsc_queue.h"
+#include "../src/BotSocket/bot_socket_types.h"
+
+TEST_CASE( "seqlock publishes latest value", "[seqlock]" )
+{
+    SeqLock<BotSocket::SBotPosition> pose;
+    BotSocket::SBotPosition p;
+    CHECK(pose.load(p) == 0);
+
+    pose.store(BotSocket::SBotPosition(1, 2, 3, 4, 5, 6));
+    pose.store(BotSocket::SBotPosition(7, 8, 9, 10, 11, 12));
+    CHECK(pose.load(p) == 2);
+    CHECK(p.isEqual(BotSocket::SBotPosition(7, 8, 9, 10, 11, 12), 1e-9, 1e-9));
+}
+
+TEST_CASE( "spsc queue keeps order and bounds", "[spsc_queue]" )
+{
+    SpscQueue<int, 4> queue;
+    int v = 0;
+    CHECK(queue.empty());
+    CHECK_FALSE(queue.pop(v));
+    for(int i=0; i<4; i++)
+        CHECK(queue.push(i));
+    CHECK_FALSE(queue.push(4));
+    for(int i=0; i<4; i++)
+    {
+        REQUIRE(queue.pop(v));
+        CHECK(v == i);
+    }
+    CHECK(queue.empty());
+}
+
+TEST_CASE( "seqlock and queue across threads", "[seqlock][spsc_queue]" )
+{
+    const int count = 20000;
+    SeqLock<BotSocket::SBotPosition> pose;
+    SpscQueue<int, 8> queue;
+
+    std::thread writer([&](){
+        for(int i=1; i<=count; i++)
+        {
+            pose.store(BotSocket::SBotPosition(i, i, i, i, i, i));
+            while(!queue.push(i))
+                std::this_thread::yield();
+        }
+    });
+
+    int last = 0, torn = 0, unordered = 0;
+    while(last < count)
+    {
+        BotSocket::SBotPosition p;
+        pose.load(p);
+        if(p.globalPos.x != p.globalRotation.z)
+            ++torn;
+        int v;
+        if(queue.pop(v))
+        {
+            if(v != last + 1)
+                ++unordered;
+            last = v;
+        }
+        else
+            std::this_thread::yield();
+    }
+    writer.join();
+    CHECK(torn == 0);
+    CHECK(unordered == 0);
+}
@@ -0,0 +1,221 @@
+#include <catch2/catch.hpp>
+
+#include "../src/BotSocket/simple_message_codec.h"
+
+using namespace simple_message;
+
+static xyzwpr_traj_pt_t make_xyzwpr(int sequence)
+{
+    xyzwpr_traj_pt_t msg;
+    msg.header.comm_type = COMM_TYPE_SERVICE_REQUEST;
+    msg.sequence = sequence;
+    for(int i=0; i<6; i++)
+        msg.xyz_data.xyzwpr[i] = 10.f * i + 0.5f;
+    msg.xyz_data.prefix1 = 1;
+    msg.xyz_data.prefix2 = 2;
+    msg.xyz_data.config = 0x20010203;
+    return msg;
+}
+
+TEST_CASE( "xyzwpr_traj_pt_t round trip", "[simple_message_codec]" )
+{
+    bool bigendian = GENERATE(false, true);
+    char buffer[sizeof(xyzwpr_traj_pt_t)];
+    xyzwpr_traj_pt_t msg = make_xyzwpr(17);
+
+    REQUIRE(encode(msg, bigendian, buffer, sizeof(buffer)) == sizeof(xyzwpr_traj_pt_t));
+
+    packet_view packet(buffer, sizeof(buffer), bigendian);
+    REQUIRE(packet.valid());
+    CHECK(packet.header().msg_type == MSG_TYPE_XYZWPR_TRAJ_PT);
+    CHECK(packet.header().comm_type == COMM_TYPE_SERVICE_REQUEST);
+    CHECK(packet.prefix().length == sizeof(xyzwpr_traj_pt_t) - sizeof(prefix_t));
+
+    int_t sequence = 0;
+    CHECK(packet.sequence(sequence));
+    CHECK(sequence == 17);
+
+    xyzwpr_traj_pt_t result;
+    REQUIRE(packet.decode(result));
+    for(int i=0; i<6; i++)
+        CHECK(result.xyz_data.xyzwpr[i] == msg.xyz_data.xyzwpr[i]);
+    CHECK(result.xyz_data.prefix1 == 1);
+    CHECK(result.xyz_data.prefix2 == 2);
+    CHECK(result.xyz_data.config == msg.xyz_data.config);
+}
+
+TEST_CASE( "big endian wire layout", "[simple_message_codec]" )
+{
+    char buffer[sizeof(xyzwpr_traj_pt_t)];
+    xyzwpr_traj_pt_t msg = make_xyzwpr(1);
+    encode(msg, true, buffer, sizeof(buffer));
+
+    // length prefix in network order
+    CHECK(buffer[0] == 0);
+    CHECK(buffer[3] == static_cast<char>(sizeof(xyzwpr_traj_pt_t) - sizeof(prefix_t)));
+
+    // config is never swapped
+    int_t config;
+    memcpy(&config, buffer + sizeof(xyzwpr_traj_pt_t) - sizeof(int_t), sizeof(config));
+    CHECK(config == msg.xyz_data.config);
+}
+
+TEST_CASE( "length mismatch is rejected", "[simple_message_codec]" )
+{
+    char buffer[sizeof(xyzwpr_traj_pt_t)];
+    encode(make_xyzwpr(1), false, buffer, sizeof(buffer));
+
+    packet_view packet(buffer, sizeof(buffer), false);
+    status_t status;
+    joint_traj_pt_t joint;
+    CHECK_FALSE(packet.decode(status));
+    CHECK_FALSE(packet.decode(joint));
+
+    packet_view truncated(buffer, sizeof(prefix_t), false);
+    CHECK_FALSE(truncated.valid());
+    CHECK(encode(make_xyzwpr(1), false, buffer, sizeof(buffer) - 1) == 0);
+}
+
+TEST_CASE( "service reply", "[simple_message_codec]" )
+{
+    bool bigendian = GENERATE(false, true);
+    char request[sizeof(xyzwpr_traj_pt_t)], reply[sizeof(xyzwpr_traj_pt_t)];
+    encode(make_xyzwpr(5), bigendian, request, sizeof(request));
+
+    size_t size = encode_reply(packet_view(request, sizeof(request), bigendian),
+                               REPLY_CODE_FAILURE, reply, sizeof(reply));
+    REQUIRE(size == sizeof(reply));
+
+    packet_view packet(reply, size, bigendian);
+    CHECK(packet.header().comm_type == COMM_TYPE_SERVICE_REPLY);
+    CHECK(packet.header().reply_code == REPLY_CODE_FAILURE);
+    int_t sequence = 0;
+    CHECK(packet.sequence(sequence));
+    CHECK(sequence == 5);
+}
+
+TEST_CASE( "codec throughput", "[.][benchmark][simple_message_codec]" )
+{
+    char buffer[sizeof(xyzwpr_traj_pt_t)];
+    xyzwpr_traj_pt_t msg = make_xyzwpr(1);
+
+    BENCHMARK("encode big endian") {
+        return encode(msg, true, buffer, sizeof(buffer));
+    };
+
+    encode(msg, true, buffer, sizeof(buffer));
+    BENCHMARK("decode big endian") {
+        xyzwpr_traj_pt_t result;
+        packet_view(buffer, sizeof(buffer), true).decode(result);
+        return result.sequence;
+    };
+}
+
+TEST_CASE( "swap mask follows field descriptors", "[simple_message_codec]" )
+{
+    // every word of the status is swapped
+    CHECK(swap_mask<status_t>() == (uint64_t(1) << word_count<status_t>()) - 1);
+
+    // the last word of xyzwpr_traj_pt_t is config
+    const uint64_t all = (uint64_t(1) << word_count<xyzwpr_traj_pt_t>()) - 1;
+    CHECK(swap_mask<xyzwpr_traj_pt_t>() == (all & ~(uint64_t(1) << (word_count<xyzwpr_traj_pt_t>() - 1))));
+}
+
+TEST_CASE( "joint feedback round trip", "[simple_message_codec]" )
+{
+    bool bigendian = GENERATE(false, true);
+    char buffer[sizeof(joint_feedback_t)];
+    joint_feedback_t msg;
+    msg.valid_fields = VALID_FIELD_TIME | VALID_FIELD_POSITION | VALID_FIELD_VELOCITY;
+    msg.time = 12.5f;
+    for(int i=0; i<6; i++)
+    {
+        msg.positions[i] = 0.1f * i;
+        msg.velocities[i] = -0.2f * i;
+    }
+
+    REQUIRE(encode(msg, bigendian, buffer, sizeof(buffer)) == sizeof(joint_feedback_t));
+    packet_view packet(buffer, sizeof(buffer), bigendian);
+    CHECK(packet.header().msg_type == MSG_TYPE_JOINT_FEEDBACK);
+
+    joint_feedback_t result;
+    REQUIRE(packet.decode(result));
+    CHECK(result.valid_fields == msg.valid_fields);
+    CHECK(result.time == msg.time);
+    for(int i=0; i<6; i++)
+    {
+        CHECK(result.positions[i] == msg.positions[i]);
+        CHECK(result.velocities[i] == msg.velocities[i]);
+    }
+}
+
+TEST_CASE( "ping reply", "[simple_message_codec]" )
+{
+    bool bigendian = GENERATE(false, true);
+    char request[sizeof(ping_t)], reply[sizeof(ping_t)];
+    ping_t ping;
+    ping.header.comm_type = COMM_TYPE_SERVICE_REQUEST;
+    REQUIRE(encode(ping, bigendian, request, sizeof(request)) == sizeof(ping_t));
+
+    size_t size = encode_reply(packet_view(request, sizeof(request), bigendian),
+                               REPLY_CODE_SUCCESS, reply, sizeof(reply));
+    REQUIRE(size == sizeof(ping_t));
+
+    ping_t result;
+    REQUIRE(packet_view(reply, size, bigendian).decode(result));
+    CHECK(result.header.msg_type == MSG_TYPE_PING);
+    CHECK(result.header.comm_type == COMM_TYPE_SERVICE_REPLY);
+    CHECK(result.header.reply_code == REPLY_CODE_SUCCESS);
+    CHECK(result.prefix.length == sizeof(header_t));
+}
+
+TEST_CASE( "output pulse round trip", "[simple_message_codec]" )
+{
+    bool bigendian = GENERATE(false, true);
+    char buffer[sizeof(output_pulse_t)];
+    output_pulse_t msg;
+    msg.header.comm_type = COMM_TYPE_SERVICE_REQUEST;
+    msg.sequence = 5;
+    msg.index = 3;
+    msg.duration = 0.25f;
+
+    REQUIRE(encode(msg, bigendian, buffer, sizeof(buffer)) == sizeof(output_pulse_t));
+    packet_view packet(buffer, sizeof(buffer), bigendian);
+    CHECK(packet.header().msg_type == MSG_TYPE_OUTPUT_PULSE);
+
+    // pulses belong to the trajectory
+    int_t sequence = 0;
+    CHECK(packet.sequence(sequence));
+    CHECK(sequence == 5);
+
+    output_pulse_t result;
+    REQUIRE(packet.decode(result));
+    CHECK(result.index == 3);
+    CHECK(result.duration == 0.25f);
+}
+
+TEST_CASE( "I/O reply keeps index and value", "[simple_message_codec]" )
+{
+    bool bigendian = GENERATE(false, true);
+    char request[sizeof(read_input_t)], reply[sizeof(read_input_t)];
+    read_input_t msg;
+    msg.header.comm_type = COMM_TYPE_SERVICE_REQUEST;
+    msg.index = 7;
+    msg.value = 1;
+    REQUIRE(encode(msg, bigendian, request, sizeof(request)) == sizeof(read_input_t));
+
+    size_t size = encode_reply(packet_view(request, sizeof(request), bigendian),
+                               REPLY_CODE_SUCCESS, reply, sizeof(reply));
+    REQUIRE(size == sizeof(read_input_t));
+
+    read_input_t result;
+    REQUIRE(packet_view(reply, size, bigendian).decode(result));
+    CHECK(result.header.msg_type == MSG_TYPE_READ_INPUT);
+    CHECK(result.header.reply_code == REPLY_CODE_SUCCESS);
+    CHECK(result.index == 7);
+    CHECK(result.value == 1);
+
+    // not part of a trajectory
+    int_t sequence = 0;
+    CHECK_FALSE(packet_view(reply, size, bigendian).sequence(sequence));
+}
@@ -0,0 +1,51 @@
+#include <catch2/catch.hpp>
+
+#include "../src/BotSocket/simple_message_dispatch.h"
+
+using namespace simple_message;
+
+namespace
+{
+    struct receiver
+    {
+        int status_count = 0;
+        int last_sequence = 0;
+
+        void on_status(const status_t &msg) {
+            status_count++;
+            CHECK(msg.error_code == 3);
+        }
+        void on_xyzwpr(const xyzwpr_traj_pt_t &msg) {
+            last_sequence = msg.sequence;
+        }
+    };
+}
+
+TEST_CASE( "handler table dispatches by msg_type", "[simple_message_dispatch]" )
+{
+    bool bigendian = GENERATE(false, true);
+    receiver r;
+    handler_table<receiver> table;
+    table.add<status_t, &receiver::on_status>();
+    table.add<xyzwpr_traj_pt_t, &receiver::on_xyzwpr>();
+
+    char buffer[sizeof(xyzwpr_traj_pt_t)];
+    status_t status;
+    status.error_code = 3;
+    size_t size = encode(status, bigendian, buffer, sizeof(buffer));
+    CHECK(table.dispatch(r, packet_view(buffer, size, bigendian)) == handler_table<receiver>::HANDLED);
+    CHECK(r.status_count == 1);
+
+    xyzwpr_traj_pt_t point;
+    point.sequence = 11;
+    size = encode(point, bigendian, buffer, sizeof(buffer));
+    CHECK(table.dispatch(r, packet_view(buffer, size, bigendian)) == handler_table<receiver>::HANDLED);
+    CHECK(r.last_sequence == 11);
+
+    // truncated packet with a known type
+    CHECK(table.dispatch(r, packet_view(buffer, size - 4, bigendian)) == handler_table<receiver>::BAD_LENGTH);
+
+    joint_traj_pt_t joint;
+    size = encode(joint, bigendian, buffer, sizeof(buffer));
+    CHECK(table.dispatch(r, packet_view(buffer, size, bigendian)) == handler_table<receiver>::UNKNOWN_TYPE);
+}
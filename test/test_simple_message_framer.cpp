@@ -0,0 +1,123 @@
+#include <catch2/catch.hpp>
+
+#include <string.h>
+#include <vector>
+
+#include "../src/BotSocket/simple_message_framer.h"
+
+using namespace simple_message;
+
+static std::vector<char> make_status(int error_code)
+{
+    status_t msg;
+    msg.prefix.length = sizeof(status_t) - sizeof(prefix_t);
+    msg.header.msg_type = MSG_TYPE_STATUS;
+    msg.header.comm_type = COMM_TYPE_TOPIC;
+    msg.error_code = error_code;
+    const char *data = reinterpret_cast<const char *>(&msg);
+    return std::vector<char>(data, data + sizeof(msg));
+}
+
+static void feed(SimpleMessageFramer &framer, const char *data, size_t size)
+{
+    while(size > 0)
+    {
+        size_t chunk = framer.write_size() < size ? framer.write_size() : size;
+        memcpy(framer.write_ptr(), data, chunk);
+        framer.commit(chunk);
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+static int frame_error_code(const char *frame)
+{
+    status_t msg;
+    memcpy(&msg, frame, sizeof(msg));
+    return msg.error_code;
+}
+
+TEST_CASE( "coalesced frames are all extracted", "[simple_message_framer]" )
+{
+    SimpleMessageFramer framer;
+    std::vector<char> stream;
+    for(int i=0; i<5; i++)
+    {
+        std::vector<char> msg = make_status(i);
+        stream.insert(stream.end(), msg.begin(), msg.end());
+    }
+    feed(framer, stream.data(), stream.size());
+
+    size_t size = 0;
+    for(int i=0; i<5; i++)
+    {
+        const char *frame = framer.next_frame(size);
+        REQUIRE(frame != nullptr);
+        CHECK(size == sizeof(status_t));
+        CHECK(frame_error_code(frame) == i);
+    }
+    CHECK(framer.next_frame(size) == nullptr);
+    CHECK(framer.pending() == 0);
+}
+
+TEST_CASE( "partial frame is kept until complete", "[simple_message_framer]" )
+{
+    SimpleMessageFramer framer;
+    std::vector<char> msg = make_status(42);
+    size_t size = 0;
+
+    feed(framer, msg.data(), 3);
+    CHECK(framer.next_frame(size) == nullptr);
+    feed(framer, msg.data() + 3, 10);
+    CHECK(framer.next_frame(size) == nullptr);
+    CHECK(framer.pending() == 13);
+    feed(framer, msg.data() + 13, msg.size() - 13);
+
+    const char *frame = framer.next_frame(size);
+    REQUIRE(frame != nullptr);
+    CHECK(frame_error_code(frame) == 42);
+}
+
+TEST_CASE( "frames wrapping around the buffer end", "[simple_message_framer]" )
+{
+    SimpleMessageFramer framer;
+    std::vector<char> msg = make_status(0);
+    size_t size = 0;
+    const int count = static_cast<int>(3 * SimpleMessageFramer::BUFFER_SIZE / msg.size());
+    for(int i=0; i<count; i++)
+    {
+        msg = make_status(i);
+        feed(framer, msg.data(), msg.size());
+        const char *frame = framer.next_frame(size);
+        REQUIRE(frame != nullptr);
+        CHECK(frame_error_code(frame) == i);
+    }
+}
+
+TEST_CASE( "invalid length drops buffered data", "[simple_message_framer]" )
+{
+    SimpleMessageFramer framer;
+    int_t garbage[4] = {-5, 1, 2, 3};
+    size_t size = 0;
+    feed(framer, reinterpret_cast<const char *>(garbage), sizeof(garbage));
+    CHECK(framer.next_frame(size) == nullptr);
+    CHECK(framer.dropped() == sizeof(garbage));
+
+    std::vector<char> msg = make_status(7);
+    feed(framer, msg.data(), msg.size());
+    const char *frame = framer.next_frame(size);
+    REQUIRE(frame != nullptr);
+    CHECK(frame_error_code(frame) == 7);
+}
+
+TEST_CASE( "big endian length prefix", "[simple_message_framer]" )
+{
+    SimpleMessageFramer framer(true);
+    std::vector<char> msg = make_status(0);
+    std::swap(msg[0], msg[3]);
+    std::swap(msg[1], msg[2]);
+    size_t size = 0;
+    feed(framer, msg.data(), msg.size());
+    CHECK(framer.next_frame(size) != nullptr);
+    CHECK(size == sizeof(status_t));
+}
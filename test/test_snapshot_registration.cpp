@@ -0,0 +1,123 @@
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <random>
+#include <thread>
+#include "../src/Registration/snapshot_registration.h"
+
+struct blob_t {
+    double x, y, radius, value;
+};
+
+static std::vector<blob_t> random_blobs(unsigned seed, int width, int height)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> x(0, width), y(0, height), radius(3, 12), value(20, 200);
+    std::vector<blob_t> blobs;
+    for(int i=0; i<60; i++)
+        blobs.push_back({x(random), y(random), radius(random), value(random)});
+    return blobs;
+}
+
+// blobs moved by (dx, dy), sampled at the pixel centers
+static std::vector<float> render(const std::vector<blob_t> &blobs, int width, int height, double dx, double dy)
+{
+    std::vector<float> image(static_cast<size_t>(width * height), 10.f);
+    for(int y=0; y<height; y++)
+        for(int x=0; x<width; x++) {
+            double v = 0;
+            for(const blob_t &b : blobs) {
+                const double ex = x - b.x - dx, ey = y - b.y - dy;
+                v += b.value * std::exp(-(ex * ex + ey * ey) / (2 * b.radius * b.radius));
+            }
+            image[static_cast<size_t>(y * width + x)] += static_cast<float>(v);
+        }
+    return image;
+}
+
+// std::thread per job block, as QtConcurrent::blockingMap spreads them
+static void threads(size_t count, const std::function<void(size_t)> &job)
+{
+    const size_t n = 4;
+    std::vector<std::thread> pool;
+    for(size_t t=0; t<n; t++)
+        pool.emplace_back([t, n, count, &job]() {
+            for(size_t i=t; i<count; i+=n)
+                job(i);
+        });
+    for(std::thread &t : pool)
+        t.join();
+}
+
+TEST_CASE( "gray weights", "[snapshot_registration]" )
+{
+    const uint32_t pixels[] = {0xff000000u, 0xffffffffu, 0x00ff0000u, 0x0000ff00u, 0x000000ffu, 0};
+    const std::vector<float> g = SnapshotRegistration::gray(pixels, 2, 2, 3);
+    REQUIRE(g.size() == 4);
+    CHECK(g[0] == 0);
+    CHECK(g[1] == Approx(255));
+    CHECK(g[2] == Approx(255 * 16 / 32.));
+    CHECK(g[3] == Approx(255 * 5 / 32.));
+}
+
+TEST_CASE( "same image does not move", "[snapshot_registration]" )
+{
+    const int width = 160, height = 120;
+    const std::vector<float> image = render(random_blobs(1, width, height), width, height, 0, 0);
+    const SnapshotRegistration::result_t r = SnapshotRegistration().align(image, image, width, height);
+    CHECK(std::fabs(r.dx) < 1e-3);
+    CHECK(std::fabs(r.dy) < 1e-3);
+    CHECK(r.peak == Approx(1).margin(1e-3));
+}
+
+TEST_CASE( "finds whole and sub-pixel shifts", "[snapshot_registration]" )
+{
+    // not powers of two, the images are padded
+    const int width = 200, height = 150;
+    const std::vector<blob_t> blobs = random_blobs(2, width, height);
+    const std::vector<float> reference = render(blobs, width, height, 0, 0);
+
+    SnapshotRegistration serial, parallel;
+    parallel.set_parallel(threads);
+
+    const double shifts[][2] = {{7, -3}, {-12, 9}, {2.5, 0.25}, {-4.3, -6.7}, {0.4, 11.6}};
+    for(const auto &s : shifts) {
+        const std::vector<float> moved = render(blobs, width, height, s[0], s[1]);
+        const SnapshotRegistration::result_t r = serial.align(reference, moved, width, height);
+        CHECK(r.dx == Approx(s[0]).margin(0.05));
+        CHECK(r.dy == Approx(s[1]).margin(0.05));
+        CHECK(r.peak > 0.9);
+
+        const SnapshotRegistration::result_t p = parallel.align(reference, moved, width, height);
+        CHECK(p.dx == Approx(r.dx).margin(1e-6));
+        CHECK(p.dy == Approx(r.dy).margin(1e-6));
+    }
+}
+
+TEST_CASE( "unrelated images have a low peak", "[snapshot_registration]" )
+{
+    const int width = 128, height = 128;
+    const std::vector<float> a = render(random_blobs(3, width, height), width, height, 0, 0);
+    const std::vector<float> b = render(random_blobs(4, width, height), width, height, 0, 0);
+    CHECK(SnapshotRegistration().align(a, b, width, height).peak < 0.5);
+    CHECK(SnapshotRegistration().align(a, std::vector<float>(), width, height).peak == 0);
+}
+
+TEST_CASE( "snapshot registration throughput", "[.][benchmark][snapshot_registration]" )
+{
+    const int width = 1000, height = 1000;
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> noise(0, 255);
+    std::vector<float> a(static_cast<size_t>(width * height)), b(a.size());
+    for(size_t i=0; i<a.size(); i++)
+        a[i] = b[(i + 3 * width + 5) % b.size()] = noise(random);
+
+    SnapshotRegistration serial, parallel;
+    parallel.set_parallel(threads);
+    BENCHMARK("1000x1000 serial") {
+        return serial.align(a, b, width, height).dx;
+    };
+    BENCHMARK("1000x1000 4 threads") {
+        return parallel.align(a, b, width, height).dx;
+    };
+}
@@ -0,0 +1,190 @@
+#include <catch2/catch.hpp>
+
+#include <random>
+#include "../src/Clearance/swept_clearance.h"
+
+typedef TriangleBvh::triangle_t triangle_t;
+
+// axis aligned box as 12 triangles
+static void add_box(std::vector<triangle_t> &triangles, const Eigen::Vector3d &min, const Eigen::Vector3d &max,
+                    int owner)
+{
+    Eigen::Vector3d v[8];
+    for(int i=0; i<8; i++)
+        v[i] = Eigen::Vector3d(i & 1 ? max.x() : min.x(), i & 2 ? max.y() : min.y(), i & 4 ? max.z() : min.z());
+    const int faces[6][4] = {{0, 1, 3, 2}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 3, 7, 5}};
+    for(const auto &f : faces) {
+        triangles.push_back({v[f[0]], v[f[1]], v[f[2]], owner});
+        triangles.push_back({v[f[0]], v[f[2]], v[f[3]], owner});
+    }
+}
+
+static SweptClearance::pose_t make_pose(double x, double y, double z, double angle_z = 0)
+{
+    SweptClearance::pose_t pose;
+    pose.rotation = Eigen::AngleAxisd(angle_z, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+    pose.translation = Eigen::Vector3d(x, y, z);
+    return pose;
+}
+
+TEST_CASE( "bvh nearest matches brute force", "[swept_clearance]" )
+{
+    std::mt19937 random(3);
+    std::uniform_real_distribution<double> coord(-100, 100), size(-5, 5);
+    std::vector<triangle_t> triangles;
+    for(int i=0; i<500; i++) {
+        const Eigen::Vector3d a(coord(random), coord(random), coord(random));
+        triangles.push_back({a, a + Eigen::Vector3d(size(random), size(random), size(random)),
+                             a + Eigen::Vector3d(size(random), size(random), size(random)), i});
+    }
+
+    TriangleBvh bvh;
+    bvh.build(triangles);
+    REQUIRE(bvh.size() == triangles.size());
+
+    for(int i=0; i<200; i++) {
+        const Eigen::Vector3d p(coord(random), coord(random), coord(random));
+        double best = 1e9;
+        int owner = -1;
+        for(const triangle_t &t : triangles) {
+            const double d = (TriangleBvh::closest_point(p, t) - p).norm();
+            if(d < best) {
+                best = d;
+                owner = t.owner;
+            }
+        }
+
+        const TriangleBvh::hit_t hit = bvh.nearest(p, 1e9);
+        CHECK(hit.distance == Approx(best));
+        CHECK(hit.owner == owner);
+
+        // nothing closer than the limit
+        const TriangleBvh::hit_t none = bvh.nearest(p, best * 0.5);
+        CHECK(none.owner == -1);
+        CHECK(none.distance == best * 0.5);
+    }
+}
+
+TEST_CASE( "closest point on a triangle", "[swept_clearance]" )
+{
+    const triangle_t t{Eigen::Vector3d(0, 0, 0), Eigen::Vector3d(10, 0, 0), Eigen::Vector3d(0, 10, 0), 0};
+    CHECK((TriangleBvh::closest_point(Eigen::Vector3d(2, 2, 5), t) - Eigen::Vector3d(2, 2, 0)).norm() < 1e-12);
+    CHECK((TriangleBvh::closest_point(Eigen::Vector3d(-3, -3, 0), t) - t.a).norm() < 1e-12);
+    CHECK((TriangleBvh::closest_point(Eigen::Vector3d(10, 10, 0), t) - Eigen::Vector3d(5, 5, 0)).norm() < 1e-12);
+    CHECK((TriangleBvh::closest_point(Eigen::Vector3d(5, -4, 1), t) - Eigen::Vector3d(5, 0, 0)).norm() < 1e-12);
+}
+
+TEST_CASE( "spheres cover the tool surface", "[swept_clearance]" )
+{
+    std::vector<triangle_t> tool;
+    add_box(tool, Eigen::Vector3d(-10, -10, 0), Eigen::Vector3d(10, 10, 80), 0);
+    const double cell = 5;
+    const std::vector<SweptClearance::sphere_t> spheres = SweptClearance::cover(tool, cell);
+    REQUIRE_FALSE(spheres.empty());
+
+    std::mt19937 random(5);
+    std::uniform_real_distribution<double> unit(0, 1);
+    for(int i=0; i<2000; i++) {
+        const triangle_t &t = tool[i % tool.size()];
+        double u = unit(random), v = unit(random);
+        if(u + v > 1) {
+            u = 1 - u;
+            v = 1 - v;
+        }
+        const Eigen::Vector3d p = t.a + (t.b - t.a) * u + (t.c - t.a) * v;
+
+        bool covered = false;
+        for(const SweptClearance::sphere_t &s : spheres)
+            covered = covered || (p - s.center).norm() <= s.radius;
+        CHECK(covered);
+    }
+
+    // half diagonal of a cell and the sampling slack
+    for(const SweptClearance::sphere_t &s : spheres)
+        CHECK(s.radius <= cell * (std::sqrt(3.) / 2 + 0.5 / std::sqrt(3.)));
+}
+
+TEST_CASE( "moves over and through obstacles", "[swept_clearance]" )
+{
+    // 20x20x80 mm tool standing on its origin, a floor and a wall
+    std::vector<triangle_t> tool, obstacles;
+    add_box(tool, Eigen::Vector3d(-10, -10, 0), Eigen::Vector3d(10, 10, 80), 0);
+    add_box(obstacles, Eigen::Vector3d(-500, -500, -10), Eigen::Vector3d(500, 500, 0), 1);
+    add_box(obstacles, Eigen::Vector3d(200, -500, 0), Eigen::Vector3d(210, 500, 60), 2);
+
+    SweptClearance clearance;
+    clearance.set_cell(4);
+    clearance.set_margin(5);
+    CHECK_FALSE(clearance.ready());
+    clearance.set_obstacles(obstacles);
+    clearance.set_tool(tool);
+    REQUIRE(clearance.ready());
+
+    SECTION( "parallel to the floor" ) {
+        const SweptClearance::result_t r = clearance.segment(make_pose(-300, 0, 7), make_pose(100, 0, 7));
+        CHECK(r.clearance <= 7);
+        CHECK(r.clearance >= 7 - clearance.cell());
+        CHECK(r.owner == 1);
+    }
+
+    SECTION( "far above everything" ) {
+        const SweptClearance::result_t r = clearance.segment(make_pose(-300, 0, 200), make_pose(300, 0, 200));
+        CHECK(r.clearance >= clearance.margin());
+        CHECK(r.owner == -1);
+    }
+
+    SECTION( "through the wall" ) {
+        // clear at both ends, the wall is between them
+        CHECK(clearance.pose(make_pose(100, 0, 30)).clearance >= clearance.margin());
+        CHECK(clearance.pose(make_pose(300, 0, 30)).clearance >= clearance.margin());
+
+        const SweptClearance::result_t r = clearance.segment(make_pose(100, 0, 30), make_pose(300, 0, 30));
+        CHECK(r.clearance == 0);
+        CHECK(r.owner == 2);
+        CHECK(r.at == Approx(0.5).margin(0.1));
+    }
+
+    SECTION( "rotation sweeps into the wall" ) {
+        // a long arm on the tool turns around z and hits the wall only half way
+        std::vector<triangle_t> arm = tool;
+        add_box(arm, Eigen::Vector3d(0, -5, 30), Eigen::Vector3d(150, 5, 40), 0);
+        clearance.set_tool(arm);
+
+        const SweptClearance::pose_t from = make_pose(80, -150, 20, M_PI / 3);
+        const SweptClearance::pose_t to = make_pose(80, -150, 20, -M_PI / 3);
+        CHECK(clearance.pose(from).clearance >= clearance.margin());
+        CHECK(clearance.pose(to).clearance >= clearance.margin());
+        CHECK(clearance.segment(from, to).clearance < clearance.margin());
+    }
+
+    SECTION( "does not move" ) {
+        const SweptClearance::result_t r = clearance.segment(make_pose(0, 0, 3), make_pose(0, 0, 3));
+        CHECK(r.clearance <= 3);
+        CHECK(r.at == 0);
+    }
+}
+
+TEST_CASE( "swept clearance throughput", "[.][benchmark][swept_clearance]" )
+{
+    std::vector<triangle_t> tool, obstacles;
+    add_box(tool, Eigen::Vector3d(-30, -30, 0), Eigen::Vector3d(30, 30, 200), 0);
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> coord(-400, 400);
+    for(int i=0; i<5000; i++) {
+        const Eigen::Vector3d a(coord(random), coord(random), -20);
+        add_box(obstacles, a, a + Eigen::Vector3d(10, 10, 15), 1);
+    }
+
+    SweptClearance clearance;
+    clearance.set_obstacles(obstacles);
+    clearance.set_tool(tool);
+
+    // the tool slides 10 mm above the boxes, closer than margin + cell all the way
+    BENCHMARK("100 segments") {
+        double sum = 0;
+        for(int i=0; i<100; i++)
+            sum += clearance.segment(make_pose(coord(random), coord(random), 5, 0),
+                                     make_pose(coord(random), coord(random), 5, 1)).clearance;
+        return sum;
+    };
+}
@@ -0,0 +1,129 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <random>
+#include "../src/BotSocket/task_order_optimizer.h"
+
+static GUI_TYPES::STaskPoint make_point(double x, double y = 0)
+{
+    GUI_TYPES::STaskPoint point;
+    point.globalPos = GUI_TYPES::SVertex(x, y, 0);
+    point.bUseHomePnt = false;
+    return point;
+}
+
+static bool is_permutation(const std::vector<size_t> &order, size_t size)
+{
+    std::vector<size_t> sorted = order;
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t i = 0; i < sorted.size(); ++i)
+        if (sorted[i] != i)
+            return false;
+    return sorted.size() == size;
+}
+
+TEST_CASE( "shuffled line is put in order", "[task_order_optimizer]" )
+{
+    std::vector<GUI_TYPES::STaskPoint> points;
+    points.push_back(make_point(0));
+    std::vector<double> xs;
+    for (int i = 1; i <= 30; ++i)
+        xs.push_back(i * 10);
+    std::shuffle(xs.begin(), xs.end(), std::mt19937(1));
+    for (double x : xs)
+        points.push_back(make_point(x));
+
+    TaskOrderOptimizer optimizer;
+    optimizer.set_cost(TaskOrderOptimizer::distance_cost(points));
+    const TaskOrderOptimizer::result_t result = optimizer.optimize(points);
+
+    REQUIRE(is_permutation(result.order, points.size()));
+    CHECK(result.complete);
+    CHECK(result.order.front() == 0);
+    CHECK(result.after == Approx(300));
+    CHECK(result.before > result.after);
+}
+
+TEST_CASE( "home and calibration points stay in place", "[task_order_optimizer]" )
+{
+    std::mt19937 random(2);
+    std::uniform_real_distribution<double> coord(-500, 500);
+    std::vector<GUI_TYPES::STaskPoint> points;
+    for (int i = 0; i < 60; ++i)
+        points.push_back(make_point(coord(random), coord(random)));
+    points[20].bNeedCalib = true;
+    points[41].bUseHomePnt = true;
+
+    TaskOrderOptimizer optimizer;
+    optimizer.set_cost(TaskOrderOptimizer::distance_cost(points));
+    const TaskOrderOptimizer::result_t result = optimizer.optimize(points);
+
+    REQUIRE(is_permutation(result.order, points.size()));
+    CHECK(result.order[0] == 0);
+    CHECK(result.order[20] == 20);
+    CHECK(result.order[41] == 41);
+    // points do not cross the barriers
+    for (size_t i = 0; i < result.order.size(); ++i)
+        CHECK((i < 20) == (result.order[i] < 20));
+    CHECK(result.after <= result.before);
+}
+
+TEST_CASE( "cancelled optimization still returns an order", "[task_order_optimizer]" )
+{
+    std::vector<GUI_TYPES::STaskPoint> points;
+    for (int i = 0; i < 20; ++i)
+        points.push_back(make_point((i * 7) % 20, (i * 3) % 5));
+
+    std::atomic<bool> cancel(true);
+    TaskOrderOptimizer optimizer;
+    optimizer.set_cost(TaskOrderOptimizer::distance_cost(points));
+    optimizer.set_cancel(&cancel);
+    const TaskOrderOptimizer::result_t result = optimizer.optimize(points);
+
+    CHECK(is_permutation(result.order, points.size()));
+    CHECK_FALSE(result.complete);
+}
+
+TEST_CASE( "an optimal order comes back unchanged", "[task_order_optimizer]" )
+{
+    // nearest neighbour from 0 goes to 10 first and ends far away at -15
+    std::vector<GUI_TYPES::STaskPoint> points;
+    for (double x : {0., -15., 10., 30., 60.})
+        points.push_back(make_point(x));
+
+    TaskOrderOptimizer optimizer;
+    optimizer.set_cost(TaskOrderOptimizer::distance_cost(points));
+    std::atomic<bool> cancel(false);
+    optimizer.set_cancel(&cancel);
+
+    SECTION( "searched to the end" )
+    {
+    }
+    SECTION( "cancelled before the search" )
+    {
+        cancel = true;
+    }
+    const TaskOrderOptimizer::result_t result = optimizer.optimize(points);
+
+    CHECK(result.order == std::vector<size_t>({0, 1, 2, 3, 4}));
+    CHECK(result.after == Approx(result.before));
+}
+
+TEST_CASE( "joint time cost", "[task_order_optimizer]" )
+{
+    CycleTimeModel model;
+    std::vector<joint_data> joints = {
+        {{0, 0, 0, 0, 0, 0}},
+        {{90, 0, 0, 0, 0, 0}},
+        {{10, 0, 0, 0, 0, 0}}
+    };
+    const TaskOrderOptimizer::cost_t cost = TaskOrderOptimizer::time_cost(joints, model);
+    CHECK(cost(0, 1) == Approx(model.move_time(joints[0], joints[1])));
+    CHECK(cost(0, 2) < cost(0, 1));
+
+    std::vector<GUI_TYPES::STaskPoint> points(3, make_point(0));
+    TaskOrderOptimizer optimizer;
+    optimizer.set_cost(cost);
+    const TaskOrderOptimizer::result_t result = optimizer.optimize(points);
+    CHECK(result.order == std::vector<size_t>({0, 2, 1}));
+}
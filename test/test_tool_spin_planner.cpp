@@ -0,0 +1,148 @@
+#include <catch2/catch.hpp>
+
+#include <random>
+#include "../src/BotSocket/tool_spin_planner.h"
+#include "robot_fixtures.h"
+
+static double angle_between(const xyzwpr_data &a, const xyzwpr_data &b)
+{
+    const Eigen::Quaterniond qa(OpwKinematics::to_isometry(a).linear()), qb(OpwKinematics::to_isometry(b).linear());
+    return qa.angularDistance(qb) * 180. / M_PI;
+}
+
+TEST_CASE( "turn about the tool z", "[tool_spin_planner]" )
+{
+    xyzwpr_data pose;
+    pose.xyzwpr = {{100, 200, 300, 10, -20, 170}};
+    pose.flip = true;
+    const xyzwpr_data same = ToolSpinPlanner::turned(pose, 0);
+    CHECK(same.xyzwpr == pose.xyzwpr);
+
+    const xyzwpr_data turned = ToolSpinPlanner::turned(pose, 40);
+    const Eigen::Isometry3d a = OpwKinematics::to_isometry(pose), b = OpwKinematics::to_isometry(turned);
+    CHECK((a.translation() - b.translation()).norm() < 1e-9);
+    CHECK((a.linear().col(2) - b.linear().col(2)).norm() < 1e-9);
+    CHECK(angle_between(pose, turned) == Approx(40));
+    CHECK(turned.flip);
+}
+
+TEST_CASE( "orientation path matches brute force", "[tool_spin_planner]" )
+{
+    std::mt19937 random(11);
+    std::uniform_real_distribution<double> angle(-180, 180);
+    std::vector<xyzwpr_data> poses(4);
+    for(xyzwpr_data &pose : poses)
+        pose.xyzwpr = {{0, 0, 0, angle(random) / 4, angle(random) / 4, angle(random)}};
+    const std::vector<bool> symmetric = {true, false, true, true};
+    xyzwpr_data start;
+    start.xyzwpr = {{0, 0, 0, 0, 0, 90}};
+
+    ToolSpinPlanner planner;
+    planner.set_steps(6);
+    planner.set_poses(poses, symmetric);
+    REQUIRE(planner.candidate_count() == 19);
+    const ToolSpinPlanner::result_t result = planner.plan(start);
+    REQUIRE(result.failed == ToolSpinPlanner::npos);
+    REQUIRE(result.poses.size() == poses.size());
+    CHECK(result.joints.empty());
+    CHECK(result.spins[1] == 0);
+    CHECK(result.poses[1].xyzwpr == poses[1].xyzwpr);
+
+    double best = std::numeric_limits<double>::infinity();
+    for(int a=0; a<6; a++)
+        for(int c=0; c<6; c++)
+            for(int d=0; d<6; d++)
+            {
+                const xyzwpr_data path[] = {ToolSpinPlanner::turned(poses[0], a * 60.), poses[1],
+                                            ToolSpinPlanner::turned(poses[2], c * 60.),
+                                            ToolSpinPlanner::turned(poses[3], d * 60.)};
+                double cost = 0;
+                const xyzwpr_data *from = &start;
+                for(const xyzwpr_data &to : path)
+                {
+                    cost += angle_between(*from, to) * angle_between(*from, to);
+                    from = &to;
+                }
+                best = std::min(best, cost);
+            }
+    CHECK(result.cost == Approx(best));
+}
+
+TEST_CASE( "symmetric points keep the wrist still", "[tool_spin_planner]" )
+{
+    OpwKinematics kin;
+    kin.set_parameters(r2000ib());
+
+    // the flange turns back and forth by 170 deg between neighbours
+    std::vector<xyzwpr_data> poses;
+    for(int i=0; i<20; i++)
+        poses.push_back(OpwKinematics::to_xyzwpr(kin.forward({{i * 2., 20, 10, 0, -30, i % 2 ? 170. : 0.}})));
+    const joint_data start = {{0, 20, 10, 0, -30, 0}};
+
+    ToolSpinPlanner planner;
+    planner.set_kinematics(&kin);
+    planner.set_steps(36);
+
+    planner.set_poses(poses, std::vector<bool>(poses.size(), false));
+    planner.solve(0, planner.candidate_count());
+    const ToolSpinPlanner::result_t fixed = planner.plan(start);
+    REQUIRE(fixed.failed == ToolSpinPlanner::npos);
+
+    planner.set_poses(poses, std::vector<bool>(poses.size(), true));
+    REQUIRE(planner.candidate_count() == poses.size() * 36);
+    // in parts, as the socket does
+    for(size_t i=0; i<planner.candidate_count(); i+=100)
+        planner.solve(i, i + 100);
+    const ToolSpinPlanner::result_t turned = planner.plan(start);
+    REQUIRE(turned.failed == ToolSpinPlanner::npos);
+    REQUIRE(turned.joints.size() == poses.size());
+
+    CHECK(turned.cost < fixed.cost / 100);
+    for(size_t i=0; i<poses.size(); i++)
+    {
+        // the tool axis and position stay, the joints reach the turned pose
+        const Eigen::Isometry3d want = OpwKinematics::to_isometry(poses[i]);
+        const Eigen::Isometry3d got = kin.forward(turned.joints[i]);
+        CHECK((want.translation() - got.translation()).norm() < 1e-6);
+        CHECK((want.linear().col(2) - got.linear().col(2)).norm() < 1e-9);
+        CHECK((OpwKinematics::to_isometry(turned.poses[i]).linear() - got.linear()).norm() < 1e-9);
+        CHECK(std::fabs(turned.joints[i][5] - start[5]) < 10);
+    }
+}
+
+TEST_CASE( "unreachable point is reported", "[tool_spin_planner]" )
+{
+    OpwKinematics kin;
+    kin.set_parameters(r2000ib());
+    std::vector<xyzwpr_data> poses(3, OpwKinematics::to_xyzwpr(kin.forward({{0, 20, 10, 0, -30, 0}})));
+    poses[1].xyzwpr[0] = 10000;
+
+    ToolSpinPlanner planner;
+    planner.set_kinematics(&kin);
+    planner.set_poses(poses, {true, true, true});
+    planner.solve(0, planner.candidate_count());
+    const ToolSpinPlanner::result_t result = planner.plan(joint_data{{0, 0, 0, 0, 0, 0}});
+    CHECK(result.failed == 1);
+    CHECK(result.error == OpwKinematics::IK_UNREACHABLE);
+    CHECK(result.poses.empty());
+}
+
+TEST_CASE( "tool spin planner throughput", "[.][benchmark][tool_spin_planner]" )
+{
+    OpwKinematics kin;
+    kin.set_parameters(r2000ib());
+    std::mt19937 random(5);
+    std::uniform_real_distribution<double> angle(-30, 30);
+    std::vector<xyzwpr_data> poses;
+    for(int i=0; i<200; i++)
+        poses.push_back(OpwKinematics::to_xyzwpr(kin.forward({{angle(random), 20 + angle(random) / 2, 10,
+                                                               angle(random), -30, angle(random) * 6}})));
+
+    ToolSpinPlanner planner;
+    planner.set_kinematics(&kin);
+    BENCHMARK("200 symmetric points") {
+        planner.set_poses(poses, std::vector<bool>(poses.size(), true));
+        planner.solve(0, planner.candidate_count());
+        return planner.plan(joint_data{{0, 20, 10, 0, -30, 0}}).cost;
+    };
+}
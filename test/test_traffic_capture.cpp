@@ -0,0 +1,49 @@
+#include <catch2/catch.hpp>
+
+#include <QFile>
+
+#include "../src/BotSocket/traffic_capture.h"
+#include "../src/BotSocket/simple_message_codec.h"
+
+using namespace traffic_capture;
+
+TEST_CASE( "traffic capture round trip", "[traffic_capture]" )
+{
+    const QString file_name = "test_capture.bin";
+    bool bigendian = GENERATE(false, true);
+
+    char frame[sizeof(simple_message::status_t)];
+    simple_message::status_t status;
+    status.error_code = 42;
+    size_t size = simple_message::encode(status, bigendian, frame, sizeof(frame));
+
+    {
+        writer capture;
+        REQUIRE(capture.open(file_name, bigendian));
+        capture.record(CHANNEL_STATE, DIRECTION_RX, frame, size);
+        capture.record(CHANNEL_RELAY, DIRECTION_TX, frame, 4);
+        CHECK(capture.records() == 2);
+    }
+
+    reader replay;
+    REQUIRE(replay.open(file_name));
+    CHECK(replay.bigendian() == bigendian);
+
+    record_t first, second, end;
+    REQUIRE(replay.next(first));
+    CHECK(first.channel == CHANNEL_STATE);
+    CHECK(first.direction == DIRECTION_RX);
+    REQUIRE(first.frame.size() == size);
+    simple_message::status_t decoded;
+    REQUIRE(simple_message::packet_view(first.frame.data(), first.frame.size(), bigendian).decode(decoded));
+    CHECK(decoded.error_code == 42);
+
+    REQUIRE(replay.next(second));
+    CHECK(second.channel == CHANNEL_RELAY);
+    CHECK(second.direction == DIRECTION_TX);
+    CHECK(second.frame.size() == 4);
+    CHECK(second.time_ns >= first.time_ns);
+
+    CHECK_FALSE(replay.next(end));
+    QFile::remove(file_name);
+}